@@ -54,4 +54,11 @@ public class VideoActivity extends AppCompatActivity {
     protected void onStop() {
         super.onStop();
     }
+
+    @Override
+    protected void onDestroy() {
+        // the player outlives its surface, release it with the activity
+        mVideoView.release(true);
+        super.onDestroy();
+    }
 }
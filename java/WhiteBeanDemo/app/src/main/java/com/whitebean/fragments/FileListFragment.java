@@ -3,6 +3,8 @@ package com.whitebean.fragments;
 import android.app.Activity;
 import android.content.Context;
 import android.database.Cursor;
+import android.graphics.Bitmap;
+import android.os.AsyncTask;
 import android.os.Bundle;
 import android.support.annotation.Nullable;
 import android.support.v4.app.Fragment;
@@ -10,6 +12,7 @@ import android.support.v4.app.LoaderManager;
 import android.support.v4.content.Loader;
 import android.support.v4.widget.SimpleCursorAdapter;
 import android.text.TextUtils;
+import android.util.LruCache;
 import android.view.LayoutInflater;
 import android.view.View;
 import android.view.ViewGroup;
@@ -22,6 +25,7 @@ import com.example.loushuai.whitebeandemo.R;
 import com.whitebean.content.PathCursor;
 import com.whitebean.content.PathCursorLoader;
 import com.whitebean.eventbus.FileExplorerEvents;
+import com.whitebean.media.MediaPlayer;
 
 import java.io.File;
 
@@ -30,11 +34,14 @@ import java.io.File;
  */
 public class FileListFragment extends Fragment implements LoaderManager.LoaderCallbacks<Cursor> {
     private static final String ARG_PATH = "path";
+    private static final int THUMBNAIL_DP = 48;
 
     private TextView mPathView;
     private ListView mFileListView;
     private VideoAdapter mAdapter;
     private String mPath;
+    private int mThumbnailSize;
+    private final LruCache<String, Bitmap> mThumbnails = new LruCache<>(64);
 
     public static FileListFragment newInstance(String path) {
         FileListFragment f = new FileListFragment();
@@ -64,6 +71,10 @@ public class FileListFragment extends Fragment implements LoaderManager.LoaderCa
 
         Activity activity = getActivity();
 
+        // thumbnails are kept on disk across visits
+        MediaPlayer.setCacheDirectory(activity.getCacheDir().getAbsolutePath());
+        mThumbnailSize = (int) (THUMBNAIL_DP * getResources().getDisplayMetrics().density);
+
         Bundle bundle = getArguments();
         if (bundle != null) {
             mPath = bundle.getString(ARG_PATH);
@@ -131,10 +142,12 @@ public class FileListFragment extends Fragment implements LoaderManager.LoaderCa
                 viewHolder.nameTextView = (TextView) view.findViewById(R.id.name);
             }
 
+            viewHolder.iconImageView.setTag(R.id.icon, null);
             if (isDirectory(position)) {
                 viewHolder.iconImageView.setImageResource(R.drawable.ic_theme_folder);
             } else if (isVideo(position)) {
                 viewHolder.iconImageView.setImageResource(R.drawable.ic_theme_play_arrow);
+                loadThumbnail(viewHolder.iconImageView, getFilePath(position));
             } else {
                 viewHolder.iconImageView.setImageResource(R.drawable.ic_theme_description);
             }
@@ -143,6 +156,32 @@ public class FileListFragment extends Fragment implements LoaderManager.LoaderCa
             return view;
         }
 
+        void loadThumbnail(final ImageView imageView, final String path) {
+            Bitmap bitmap = mThumbnails.get(path);
+            if (bitmap != null) {
+                imageView.setImageBitmap(bitmap);
+                return;
+            }
+
+            // the view may be recycled for another file meanwhile
+            imageView.setTag(R.id.icon, path);
+            new AsyncTask<Void, Void, Bitmap>() {
+                @Override
+                protected Bitmap doInBackground(Void... params) {
+                    return MediaPlayer.getThumbnail(path, -1, mThumbnailSize, mThumbnailSize);
+                }
+
+                @Override
+                protected void onPostExecute(Bitmap bitmap) {
+                    if (bitmap == null)
+                        return;
+                    mThumbnails.put(path, bitmap);
+                    if (path.equals(imageView.getTag(R.id.icon)))
+                        imageView.setImageBitmap(bitmap);
+                }
+            }.executeOnExecutor(AsyncTask.THREAD_POOL_EXECUTOR);
+        }
+
         @Override
         public long getItemId(int position) {
             final Cursor cursor = moveToPosition(position);
@@ -1,5 +1,6 @@
 package com.whitebean.media;
 
+import android.graphics.Bitmap;
 import android.os.Handler;
 import android.os.Looper;
 import android.os.Message;
@@ -9,6 +10,7 @@ import android.view.SurfaceHolder;
 
 import java.io.IOException;
 import java.lang.ref.WeakReference;
+import java.nio.ByteBuffer;
 
 /**
  * Created by loushuai on 2016/6/26.
@@ -18,6 +20,11 @@ public class MediaPlayer implements IMediaPlayer {
     private static final int MEDIA_NOP = 0; // interface test message
     private static final int MEDIA_PREPARED = 1;
 
+    /** seekTo() starts at the key frame before the position, the fastest */
+    public static final int SEEK_KEYFRAME = 0;
+    /** seekTo() decodes from the key frame and starts exactly at the position */
+    public static final int SEEK_ACCURATE = 1;
+
     static {
         System.loadLibrary("whitebean");
         native_init();
@@ -94,6 +101,100 @@ public class MediaPlayer implements IMediaPlayer {
 
     public native void onTouchMove(float dx, float dy);
 
+    /**
+     * Directory where compiled shader programs, probed stream info and the
+     * bytes of http(s) sources are cached, e.g. Context.getCacheDir().
+     * Without it shaders are compiled for every player, every file is
+     * probed on open and http(s) sources are fetched again on every play.
+     */
+    public static native void setCacheDirectory(String path);
+
+    /**
+     * Thumbnail of the key frame at or before timeMs, or a tenth into the
+     * file for a negative timeMs, scaled to fit in width x height. Blocks
+     * while it is decoded, call it off the UI thread. Thumbnails are kept
+     * in the cache directory. Returns null if the file has no video.
+     */
+    public static Bitmap getThumbnail(String path, long timeMs, int width, int height) {
+        int[] size = new int[2];
+        byte[] pixels = _getThumbnail(path, timeMs, width, height, size);
+        if (pixels == null)
+            return null;
+
+        Bitmap bitmap = Bitmap.createBitmap(size[0], size[1], Bitmap.Config.RGB_565);
+        bitmap.copyPixelsFromBuffer(ByteBuffer.wrap(pixels));
+        return bitmap;
+    }
+
+    private static native byte[] _getThumbnail(String path, long timeMs, int width, int height, int[] size);
+
+    /**
+     * Play the audio track only, e.g. while the app is in background. Video
+     * is neither demuxed nor decoded until the mode is left again.
+     */
+    public native void setAudioOnly(boolean audioOnly);
+
+    /**
+     * Seek while the user drags the seek bar. Only the nearest keyframe is
+     * shown and requests arriving during a seek are merged into the newest
+     * one; finish with seekTo() for the exact position.
+     */
+    public native void scrubTo(long msec);
+
+    /**
+     * SEEK_KEYFRAME (default) or SEEK_ACCURATE, for seekTo(). scrubTo()
+     * always stops at key frames.
+     */
+    public native void setSeekMode(int mode);
+
+    /**
+     * Fast forward at 2 to 64 times normal speed, rewind at -2 to -64, and
+     * 1 to play normally again. Only key frames are shown and audio is
+     * muted meanwhile. -1 plays every frame backwards, also muted. Throws
+     * IllegalArgumentException for other rates or before the player is
+     * prepared.
+     */
+    public native void setPlaybackRate(int rate);
+
+    /**
+     * Show the next (1) or previous (-1) frame, pausing playback first.
+     * Returns false at either end of the file or during fast forward and
+     * rewind. start() plays on from the frame shown.
+     */
+    public native boolean stepFrame(int delta);
+
+    /**
+     * Bytes of decoded frames kept for stepFrame() and playing backwards,
+     * 64 MB by default.
+     */
+    public native void setFrameCacheSize(long bytes);
+
+    /**
+     * Play the files one after the other, instead of setDataSource(). The
+     * next one is opened ahead and its audio follows without a gap.
+     */
+    public native void setPlaylist(String[] paths);
+
+    /**
+     * Start over at the first file after the last one.
+     */
+    public native void setLooping(boolean looping);
+
+    /**
+     * Loop between two positions of the file without a stall at the wrap,
+     * the audio is joined at the sample. endMs -1 plays on normally.
+     * Throws IllegalArgumentException for a range outside the file or
+     * before the player is prepared.
+     */
+    public native void setLoopRange(long startMs, long endMs);
+
+    /**
+     * Playback pauses for buffering when less than lowMs is read ahead and
+     * goes on once highMs is. Throws IllegalArgumentException when highMs
+     * is below lowMs.
+     */
+    public native void setBufferingWatermarks(long lowMs, long highMs);
+
     private native void _setVideoSurface(Surface surface);
     private native void _setDataSource(String path)
             throws IOException, IllegalArgumentException, SecurityException, IllegalStateException;
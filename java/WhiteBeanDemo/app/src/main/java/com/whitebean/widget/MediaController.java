@@ -250,11 +250,14 @@ public class MediaController extends FrameLayout {
             Log.d(TAG, "onProgressChanged");
             if (!fromuser)
                 return;
+
+            // previews the nearest keyframe, only the newest position is sought
+            mPlayer.scrubTo((int) ((long) mDuration * progress / 1000));
         }
 
         public void onStopTrackingTouch(SeekBar bar) {
             Log.d(TAG, "onStopTrackingTouch");
-            mPlayer.seekTo((mDuration * bar.getProgress()) / 1000);
+            mPlayer.seekTo((int) ((long) mDuration * bar.getProgress() / 1000));
             show(sDefaultTimeout);
         }
     };
@@ -279,6 +282,8 @@ public class MediaController extends FrameLayout {
 
         void seekTo(int pos);
 
+        void scrubTo(int pos);
+
         boolean isPlaying();
 
         int getBufferPercentage();
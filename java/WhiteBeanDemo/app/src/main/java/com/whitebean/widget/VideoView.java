@@ -96,8 +96,11 @@ public class VideoView extends SurfaceView implements MediaController.MediaPlaye
 
         release(false);
         try {
+            MediaPlayer.setCacheDirectory(getContext().getCacheDir().getAbsolutePath());
             mMediaPlayer = new MediaPlayer();
             mMediaPlayer.setOnPreparedListener(mPreparedListener);
+            // a released seek bar should show the frame it points at
+            mMediaPlayer.setSeekMode(MediaPlayer.SEEK_ACCURATE);
             mMediaPlayer.setDataSource(mUri);
             mMediaPlayer.setDisplay(mSurfaceHolder);
             mMediaPlayer.prepare();
@@ -153,7 +156,13 @@ public class VideoView extends SurfaceView implements MediaController.MediaPlaye
         @Override
         public void surfaceCreated(SurfaceHolder holder) {
             mSurfaceHolder = holder;
-            openVideo();
+            if (mMediaPlayer != null) {
+                // back from background or rotation, keep the running player
+                mMediaPlayer.setDisplay(mSurfaceHolder);
+                mMediaPlayer.setAudioOnly(false);
+            } else {
+                openVideo();
+            }
         }
 
         @Override
@@ -167,7 +176,10 @@ public class VideoView extends SurfaceView implements MediaController.MediaPlaye
         public void surfaceDestroyed(SurfaceHolder holder) {
             mSurfaceHolder = null;
             if (mMediaController != null) mMediaController.hide();
-            release(true);
+            if (mMediaPlayer != null) {
+                mMediaPlayer.setDisplay(null);
+                mMediaPlayer.setAudioOnly(true);
+            }
         }
     };
 
@@ -272,6 +284,12 @@ public class VideoView extends SurfaceView implements MediaController.MediaPlaye
         }
     }
 
+    public void scrubTo(int msec) {
+        if (isInPlaybackState()) {
+            mMediaPlayer.scrubTo(msec);
+        }
+    }
+
     private boolean isInPlaybackState() {
         return (mMediaPlayer != null &&
                 mCurrentState != STATE_ERROR &&
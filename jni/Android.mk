@@ -61,18 +61,35 @@ LOCAL_C_INCLUDES += $(LOCAL_PATH)/include \
 LOCAL_MODULE := whitebean
 LOCAL_SRC_FILES += mediaplayer/WhiteBeanPlayer.cpp \
 				   mediaplayer/AudioPlayer.cpp \
+				   mediaplayer/MediaRuntime.cpp \
 				   mediaplayer/TimedEventQueue.cpp \
 				   mediaplayer/mediabase/MediaBase.cpp \
 				   mediaplayer/mediabase/MetaData.cpp \
 				   mediaplayer/mediabase/MediaSource.cpp \
+				   mediaplayer/mediabase/StreamInfoCache.cpp \
+				   mediaplayer/mediabase/CacheFile.cpp \
+				   mediaplayer/mediabase/KeyframeIndex.cpp \
+				   mediaplayer/mediabase/FileReader.cpp \
+				   mediaplayer/mediabase/PrefetchReader.cpp \
+				   mediaplayer/mediabase/HttpCache.cpp \
+				   mediaplayer/mediabase/HttpCacheReader.cpp \
+				   mediaplayer/mediabase/AVIOBridge.cpp \
+				   mediaplayer/mediabase/GopCache.cpp \
+				   mediaplayer/mediabase/ThumbnailEngine.cpp \
+				   mediaplayer/mediabase/BufferingMonitor.cpp \
 				   mediaplayer/mediabase/MediaTracks.cpp \
            		   mediaplayer/mediabase/MediaCodec.cpp \
            		   mediaplayer/mediasink/audiosink/opensl/openslsink.cpp \
 				   mediaplayer/mediasink/videosink/egl/EglSink.cpp \
+				   mediaplayer/mediasink/videosink/egl/EglContextManager.cpp \
 				   mediaplayer/mediasink/videosink/egl/GLRenderer.cpp \
+				   mediaplayer/mediasink/videosink/egl/GLProgramCache.cpp \
 				   mediaplayer/mediasink/videosink/egl/GLRendererYUV420p.cpp \
+				   mediaplayer/mediasink/videosink/egl/GLRendererYUV420p10.cpp \
+				   mediaplayer/mediasink/videosink/egl/GLRendererNV12.cpp \
 				   mediaplayer/mediasink/videosink/egl/GLRendererPanoYUV420p.cpp \
 				   mediaplayer/mediasink/videosink/egl/utils/math3d.cpp \
+				   mediaplayer/mediasink/videosink/egl/utils/panomesh.cpp \
 				   jni/whitebean_media_MediaPlayer.cpp
 
 LOCAL_STATIC_LIBRARIES := avformat avcodec avutil swresample avfilter swscale
@@ -103,6 +120,31 @@ LOCAL_MODULE := test
 #LOCAL_SRC_FILES += test/mediaplayertest.cpp
 LOCAL_SRC_FILES += test/whitebeanplayer.cpp
 #LOCAL_SRC_FILES += test/videodecodetest.cpp
+#LOCAL_SRC_FILES += test/glcallcounttest.cpp
+#LOCAL_SRC_FILES += test/glrenderformattest.cpp
+#LOCAL_SRC_FILES += test/panomeshtest.cpp
+#LOCAL_SRC_FILES += test/glrenderbench.cpp
+#LOCAL_SRC_FILES += test/glprogramcachetest.cpp
+#LOCAL_SRC_FILES += test/eglcontexttest.cpp
+#LOCAL_SRC_FILES += test/audioonlybench.cpp
+#LOCAL_SRC_FILES += test/playercreatebench.cpp
+#LOCAL_SRC_FILES += test/preparebench.cpp
+#LOCAL_SRC_FILES += test/streamopenbench.cpp
+#LOCAL_SRC_FILES += test/filereadertest.cpp
+#LOCAL_SRC_FILES += test/demuxbench.cpp
+#LOCAL_SRC_FILES += test/prefetchreadertest.cpp
+#LOCAL_SRC_FILES += test/keyframeindextest.cpp
+#LOCAL_SRC_FILES += test/seekbench.cpp
+#LOCAL_SRC_FILES += test/seekscrubbench.cpp
+#LOCAL_SRC_FILES += test/accurateseekbench.cpp
+#LOCAL_SRC_FILES += test/trickplaybench.cpp
+#LOCAL_SRC_FILES += test/gopcachetest.cpp
+#LOCAL_SRC_FILES += test/thumbnailbench.cpp
+#LOCAL_SRC_FILES += test/playlistbench.cpp
+#LOCAL_SRC_FILES += test/abloopbench.cpp
+#LOCAL_SRC_FILES += test/bufferingtest.cpp
+#LOCAL_SRC_FILES += test/httpcachetest.cpp
+#LOCAL_SRC_FILES += test/seekfailtest.cpp
 
 LOCAL_SHARED_LIBRARIES += libwhitebean
 
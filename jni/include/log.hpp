@@ -9,9 +9,13 @@
 #define JNI_INCLUDE_LOG_H_
 
 #include <stdio.h>
-#include <android/log.h>
 
+#ifdef __ANDROID__
+#include <android/log.h>
 #define ANDROID_LOG 1
+#else
+#define ANDROID_LOG 0
+#endif
 
 #define LOG_TAG    "WhiteBean"
 
@@ -2,8 +2,14 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 #include <android/native_window_jni.h>
 #include "../mediaplayer/WhiteBeanPlayer.hpp"
+#include "../mediaplayer/MediaRuntime.hpp"
+#include "../mediaplayer/mediabase/StreamInfoCache.hpp"
+#include "../mediaplayer/mediabase/HttpCache.hpp"
+#include "../mediaplayer/mediabase/ThumbnailEngine.hpp"
+#include "../mediaplayer/mediasink/videosink/egl/GLProgramCache.hpp"
 #include "JNIHelp.h"
 
 using namespace std;
@@ -158,10 +164,14 @@ static void setVideoSurface(JNIEnv *env, jobject thiz, jobject jsurface, jboolea
         return;
     }
 
-	nativeWindow = ANativeWindow_fromSurface(env, jsurface);
-	if (!nativeWindow) {
-        jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
-        return;
+	// a null surface detaches the video output, playback goes on
+	nativeWindow = nullptr;
+	if (jsurface) {
+		nativeWindow = ANativeWindow_fromSurface(env, jsurface);
+		if (!nativeWindow) {
+			jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+			return;
+		}
 	}
 
 	mp->setVideoSurface(nativeWindow);
@@ -172,6 +182,17 @@ static void com_whitebean_media_MediaPlayer_setVideoSurface(JNIEnv *env, jobject
     setVideoSurface(env, thiz, jsurface, true /* mediaPlayerMustBeAlive */);
 }
 
+static void com_whitebean_media_MediaPlayer_setAudioOnly(JNIEnv *env, jobject thiz, jboolean audioOnly)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	int opStatus = mp->setAudioOnly(audioOnly);
+}
+
 static void com_whitebean_media_MediaPlayer_prepare(JNIEnv *env, jobject thiz)
 {
 	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
@@ -230,6 +251,137 @@ static void com_whitebean_media_MediaPlayer_seekTo(JNIEnv *env, jobject thiz, in
 	mp->seekTo(msec);
 }
 
+static void com_whitebean_media_MediaPlayer_scrubTo(JNIEnv *env, jobject thiz, int64_t msec)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	mp->seekTo(msec, true);
+}
+
+static void com_whitebean_media_MediaPlayer_setSeekMode(JNIEnv *env, jobject thiz, jint mode)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	mp->setSeekMode(mode);
+}
+
+static void com_whitebean_media_MediaPlayer_setPlaybackRate(JNIEnv *env, jobject thiz, jint rate)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	if (mp->setPlaybackRate(rate) < 0) {
+		jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+	}
+}
+
+static jboolean com_whitebean_media_MediaPlayer_stepFrame(JNIEnv *env, jobject thiz, jint delta)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return false;
+    }
+
+	return mp->stepFrame(delta) == 0;
+}
+
+static void com_whitebean_media_MediaPlayer_setFrameCacheSize(JNIEnv *env, jobject thiz, jlong bytes)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	mp->setFrameCacheSize(bytes);
+}
+
+static void com_whitebean_media_MediaPlayer_setPlaylist(JNIEnv *env, jobject thiz, jobjectArray paths)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+    if (paths == NULL) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+        return;
+    }
+
+	vector<string> uris;
+	jsize count = env->GetArrayLength(paths);
+
+	for (jsize i = 0; i < count; ++i) {
+		jstring path = (jstring)env->GetObjectArrayElement(paths, i);
+		if (path == NULL) {
+			jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+			return;
+		}
+
+		const char *tmp = env->GetStringUTFChars(path, NULL);
+		if (tmp == NULL) {  // Out of memory
+			return;
+		}
+		uris.push_back(tmp);
+		env->ReleaseStringUTFChars(path, tmp);
+		env->DeleteLocalRef(path);
+	}
+
+	if (mp->setPlaylist(uris) < 0) {
+		jniThrowException(env, "java/lang/IllegalStateException", NULL);
+	}
+}
+
+static void com_whitebean_media_MediaPlayer_setLooping(JNIEnv *env, jobject thiz, jboolean looping)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	mp->setLooping(looping);
+}
+
+static void com_whitebean_media_MediaPlayer_setLoopRange(JNIEnv *env, jobject thiz, jlong startMs, jlong endMs)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	if (mp->setLoopRange(startMs, endMs) < 0) {
+		jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+	}
+}
+
+static void com_whitebean_media_MediaPlayer_setBufferingWatermarks(JNIEnv *env, jobject thiz, jlong lowMs, jlong highMs)
+{
+	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
+    if (mp == NULL ) {
+        jniThrowException(env, "java/lang/IllegalStateException", NULL);
+        return;
+    }
+
+	if (mp->setBufferingWatermarks(lowMs, highMs) < 0) {
+		jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+	}
+}
+
 static int64_t com_whitebean_media_MediaPlayer_getCurrentPosition(JNIEnv *env, jobject thiz)
 {
 	shared_ptr<WhiteBeanPlayer> mp = getMediaPlayer(env, thiz);
@@ -324,6 +476,61 @@ static void com_whitebean_media_MediaPlayer_onTouchMove(JNIEnv *env, jobject thi
 	mp->onTouchMoveEvent(dx, dy);
 }
 
+static void com_whitebean_media_MediaPlayer_setCacheDirectory(JNIEnv *env, jclass clazz, jstring path)
+{
+	if (path == NULL) {
+		jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+		return;
+	}
+
+	const char *tmp = env->GetStringUTFChars(path, NULL);
+	if (tmp == NULL) {
+		return;
+	}
+
+	LOGD("setCacheDirectory: %s", tmp);
+	GLProgramCache::instance().setDirectory(tmp);
+	StreamInfoCache::instance().setDirectory(tmp);
+	ThumbnailEngine::instance().setDirectory(tmp);
+	HttpCache::instance().setDirectory(tmp);
+	env->ReleaseStringUTFChars(path, tmp);
+}
+
+static jbyteArray com_whitebean_media_MediaPlayer_getThumbnail(JNIEnv *env, jclass clazz, jstring path,
+															   jlong timeMs, jint width, jint height,
+															   jintArray size)
+{
+	if (path == NULL || size == NULL || env->GetArrayLength(size) < 2) {
+		jniThrowException(env, "java/lang/IllegalArgumentException", NULL);
+		return NULL;
+	}
+
+	const char *tmp = env->GetStringUTFChars(path, NULL);
+	if (tmp == NULL) {
+		return NULL;
+	}
+	string uri(tmp);
+	env->ReleaseStringUTFChars(path, tmp);
+
+	MediaRuntime::instance().initFFmpeg();
+
+	ThumbnailEngine::Thumbnail thumb;
+	if (ThumbnailEngine::instance().extract(uri, timeMs < 0 ? -1 : timeMs * 1000,
+											width, height, thumb) < 0) {
+		return NULL;
+	}
+
+	jbyteArray pixels = env->NewByteArray(thumb.pixels.size());
+	if (pixels == NULL) {
+		return NULL;
+	}
+	env->SetByteArrayRegion(pixels, 0, thumb.pixels.size(), (const jbyte *)thumb.pixels.data());
+
+	jint dimensions[] = {thumb.width, thumb.height};
+	env->SetIntArrayRegion(size, 0, 2, dimensions);
+
+	return pixels;
+}
 
 static JNINativeMethod gMethods[] = {
 	{"_setDataSource",        "(Ljava/lang/String;)V",          (void *)com_whitebean_media_MediaPlayer_setDataSourcePath},
@@ -332,6 +539,15 @@ static JNINativeMethod gMethods[] = {
     {"_start",              "()V",                              (void *)com_whitebean_media_MediaPlayer_start},
 	{"_pause",              "()V",                              (void *)com_whitebean_media_MediaPlayer_pause},
 	{"seekTo",              "(J)V",                             (void *)com_whitebean_media_MediaPlayer_seekTo},
+	{"scrubTo",             "(J)V",                             (void *)com_whitebean_media_MediaPlayer_scrubTo},
+	{"setSeekMode",         "(I)V",                             (void *)com_whitebean_media_MediaPlayer_setSeekMode},
+	{"setPlaybackRate",     "(I)V",                             (void *)com_whitebean_media_MediaPlayer_setPlaybackRate},
+	{"stepFrame",           "(I)Z",                             (void *)com_whitebean_media_MediaPlayer_stepFrame},
+	{"setFrameCacheSize",   "(J)V",                             (void *)com_whitebean_media_MediaPlayer_setFrameCacheSize},
+	{"setPlaylist",         "([Ljava/lang/String;)V",           (void *)com_whitebean_media_MediaPlayer_setPlaylist},
+	{"setLooping",          "(Z)V",                             (void *)com_whitebean_media_MediaPlayer_setLooping},
+	{"setLoopRange",        "(JJ)V",                            (void *)com_whitebean_media_MediaPlayer_setLoopRange},
+	{"setBufferingWatermarks", "(JJ)V",                         (void *)com_whitebean_media_MediaPlayer_setBufferingWatermarks},
 	{"isPlaying",           "()Z",                              (void *)com_whitebean_media_MediaPlayer_isPlaying},
 	{"getCurrentPosition",  "()J",                              (void *)com_whitebean_media_MediaPlayer_getCurrentPosition},
 	{"getDuration",         "()J",                              (void *)com_whitebean_media_MediaPlayer_getDuration},
@@ -339,6 +555,9 @@ static JNINativeMethod gMethods[] = {
 	{"native_init",         "()V",                              (void *)com_whitebean_media_MediaPlayer_native_init},
 	{"native_setup",        "(Ljava/lang/Object;)V",            (void *)com_whitebean_media_MediaPlayer_native_setup},
 	{"onTouchMove",         "(FF)V",                            (void *)com_whitebean_media_MediaPlayer_onTouchMove},
+	{"setCacheDirectory",   "(Ljava/lang/String;)V",            (void *)com_whitebean_media_MediaPlayer_setCacheDirectory},
+	{"_getThumbnail",       "(Ljava/lang/String;JII[I)[B",      (void *)com_whitebean_media_MediaPlayer_getThumbnail},
+	{"setAudioOnly",        "(Z)V",                             (void *)com_whitebean_media_MediaPlayer_setAudioOnly},
 };
 
 int jniRegisterNativeMethods(JNIEnv* env,
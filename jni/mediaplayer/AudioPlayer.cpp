@@ -17,21 +17,20 @@ void AudioPlayer::setSource(shared_ptr<MediaSource> source)
 	mSourcePtr = source;
 }
 
-int AudioPlayer::start()
+int AudioPlayer::prepare()
 {
 	int ret = 0;
 	int audioid = mSourcePtr->getAudioStreamId();
 
+	if (mPrepared) {
+		return 0;
+	}
+
 	if (audioid < 0) {
 		LOGE("No audio stream");
 		return -1;
 	}
 
-	if (mPaused) {
-		mPaused = 0;
-		return 0;
-	}
-
 	ret = mDecoder.open(mSourcePtr, audioid);
 	if (ret < 0) {
 		LOGE("Open decoder failed");
@@ -59,6 +58,23 @@ int AudioPlayer::start()
 		return -1;
 	}
 
+	mSampleRate = sr;
+	mPrepared = true;
+
+	return 0;
+}
+
+int AudioPlayer::start()
+{
+	if (mPaused) {
+		mPaused = 0;
+		return 0;
+	}
+
+	if (prepare() < 0) {
+		return -1;
+	}
+
 	mSinkPtr->start();
 	
 	return 0;
@@ -75,21 +91,126 @@ void AudioPlayer::stop()
 {
 	LOGD("AudioPlayer stop");
 	mAbout = true;
+	if (mSinkPtr) {
+		mSinkPtr->stop();
+	}
+
+	unique_lock<mutex> autoLock(mLock);
 	mDecoder.stop();
-	mSinkPtr->stop();
+	if (mNextDecoderPtr) {
+		mNextDecoderPtr->stop();
+	}
+	if (mRetiredPtr) {
+		mRetiredPtr->stop();
+	}
 	LOGD("AudioPlayer stop exit");	
 }
 
-int AudioPlayer::seekTo(int64_t msec)
+int AudioPlayer::seekTo(int64_t msec, bool accurate)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mDecoder.seekTo(msec, accurate);
+	return 0;
+}
+
+int AudioPlayer::setNextSource(shared_ptr<MediaSource> source, int64_t startUs, int64_t endUs)
 {
-	mDecoder.seekTo(msec);
+	int audioid = source->getAudioStreamId();
+
+	if (audioid < 0) {
+		LOGE("No audio stream");
+		return -1;
+	}
+
+	shared_ptr<MediaDecoder> decoder(new MediaDecoder);
+	if (decoder->open(source, audioid, mSampleRate) < 0) {
+		LOGE("Open next decoder failed");
+		return -1;
+	}
+
+	decoder->setListener(source.get());
+	decoder->setStartTarget(startUs);
+	decoder->setEndTarget(endUs);
+	decoder->start();
+
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mNextDecoderPtr) {
+		mNextDecoderPtr->stop();
+	}
+
+	mNextDecoderPtr = decoder;
+	mNextSourcePtr = source;
+
 	return 0;
 }
 
+void AudioPlayer::clearNextSource()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mNextDecoderPtr) {
+		mNextDecoderPtr->stop();
+	}
+
+	mNextDecoderPtr.reset();
+	mNextSourcePtr.reset();
+}
+
+void AudioPlayer::setEndTarget(int64_t endUs)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mDecoder.setEndTarget(endUs);
+}
+
+shared_ptr<MediaSource> AudioPlayer::getSource() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mSourcePtr;
+}
+
+bool AudioPlayer::ended() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return !mNextDecoderPtr && mDecoder.eos();
+}
+
+shared_ptr<MediaDecoder> AudioPlayer::takeRetired()
+{
+	unique_lock<mutex> autoLock(mLock);
+	return std::move(mRetiredPtr);
+}
+
+AudioPlayer::SpliceStats AudioPlayer::getSpliceStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mSpliceStats;
+}
+
+void AudioPlayer::splice_l()
+{
+	if (mRetiredPtr) {
+		// not taken since the last splice
+		mRetiredPtr->stop();
+	}
+
+	// the next decoder object keeps the played out one after the swap
+	mDecoder.swap(*mNextDecoderPtr);
+	mRetiredPtr = std::move(mNextDecoderPtr);
+	mSourcePtr = std::move(mNextSourcePtr);
+
+	mSpliceStats.splices++;
+
+	LOGD("Audio spliced to the next item");
+}
+
 size_t AudioPlayer::fillBuffer(std::unique_ptr<uint8_t[]> &buf)
 {
 	size_t size = 0;
 	FrameBuffer frmbuf;
+	bool got;
+	bool spliced = false;
+	auto start = chrono::steady_clock::now();
  retry:
 	if (mAbout) {		
 		return 0;
@@ -97,10 +218,37 @@ size_t AudioPlayer::fillBuffer(std::unique_ptr<uint8_t[]> &buf)
 
 	if (mPaused) {
 		this_thread::sleep_for(chrono::milliseconds(10));
+		start = chrono::steady_clock::now();
 		goto retry;
 	}
-	
-	if (mDecoder.read(frmbuf)) {
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+
+		got = mDecoder.read(frmbuf);
+		if (!got && mNextDecoderPtr && mDecoder.eos()) {
+			splice_l();
+			spliced = true;
+			got = mDecoder.read(frmbuf);
+		}
+
+		if (got && spliced) {
+			// how long the sink waited for its buffer across the splice
+			int64_t gapUs = chrono::duration_cast<chrono::microseconds>(
+				chrono::steady_clock::now() - start).count();
+			mSpliceStats.lastGapUs = gapUs;
+			mSpliceStats.maxGapUs = max(mSpliceStats.maxGapUs, gapUs);
+			mSpliceStats.lastOutUs = mLastEndUs;
+			mSpliceStats.lastInUs = frmbuf.getPts();
+			spliced = false;
+		}
+
+		if (got && mSampleRate > 0) {
+			mLastEndUs = frmbuf.getPts() + (int64_t)frmbuf.getDataPtr()->nb_samples * US_IN_SECOND / mSampleRate;
+		}
+	}
+
+	if (got) {
 		size = frmbuf.asize();
 		
 		LOGD("audio player get pcm ok, size %d, pts %lld", size, frmbuf.getPts());
@@ -9,6 +9,7 @@
 #define JNI_MEDIAPLAYER_AUDIOPLAYER_H_
 
 #include <memory>
+#include <mutex>
 #include "mediabase/MediaCodec.hpp"
 #include "mediasink/audiosink/opensl/openslsink.hpp"
 
@@ -16,30 +17,87 @@ namespace whitebean {
 
 class AudioPlayer {
 public:
-	AudioPlayer(): mAbout(false),
-				   mPaused(0) {}
+	struct SpliceStats {
+		int splices;
+		int64_t lastGapUs;	// the sink waited on the next item's decoder
+		int64_t maxGapUs;
+		int64_t lastOutUs;	// end of the last sample before the splice
+		int64_t lastInUs;	// pts of the first one after
+	};
+
+	AudioPlayer(): mCurTimeUs(0),
+				   mAbout(false),
+				   mPaused(0),
+				   mPrepared(false),
+				   mSampleRate(0),
+				   mSpliceStats(),
+				   mLastEndUs(0) {}
 	~AudioPlayer() {}
 
 	void setSource(std::shared_ptr<MediaSource> source);
+	// open the decoder and the sink without starting output, start() does
+	// it if it was not called before
+	int prepare();
 	int start();
 	int pause();
 	void stop();
-	int seekTo(int64_t msec);
+	int seekTo(int64_t msec, bool accurate = false);
 	int64_t getCurTime() const; // in us
 
+	/*
+	 * Audio of the next playlist item, its decoder is opened and started
+	 * now, resampled to the rate of the sink, and takes over in the sink
+	 * callback as soon as the current one runs out, so that the sink plays
+	 * on without a gap. A source seeked ahead starts exactly at startUs,
+	 * and endUs is the end target of the new decoder.
+	 */
+	int setNextSource(std::shared_ptr<MediaSource> source,
+					  int64_t startUs = -1, int64_t endUs = -1);
+
+	// drop the next source unless the sink spliced to it already
+	void clearNextSource();
+
+	// end target of the decoder playing now, see Codec::setEndTarget()
+	void setEndTarget(int64_t endUs);
+
+	// the source in the sink now, the next one once it took over
+	std::shared_ptr<MediaSource> getSource() const;
+
+	// the current decoder ran out and no next one is waiting
+	bool ended() const;
+
+	/*
+	 * Decoder replaced by the last splice, for the caller to stop off the
+	 * sink thread
+	 */
+	std::shared_ptr<MediaDecoder> takeRetired();
+
+	SpliceStats getSpliceStats() const;
+
 	void resume() {
+		std::unique_lock<std::mutex> autoLock(mLock);
 		mDecoder.resume();
 	}
 private:
 	static size_t audioSinkCallBack(std::unique_ptr<uint8_t[]> &buf, void *cookie = nullptr);
 	size_t fillBuffer(std::unique_ptr<uint8_t[]> &buf);
-	
+	void splice_l();
+
+	// the decoders are read by the sink thread
+	mutable std::mutex mLock;
 	MediaDecoder mDecoder;
 	std::shared_ptr<MediaSource> mSourcePtr;
+	std::shared_ptr<MediaDecoder> mNextDecoderPtr;
+	std::shared_ptr<MediaSource> mNextSourcePtr;
+	std::shared_ptr<MediaDecoder> mRetiredPtr;
 	std::shared_ptr<AudioSink> mSinkPtr;
     int64_t mCurTimeUs; // in us
 	int mAbout;
 	int mPaused;
+	bool mPrepared;
+	int mSampleRate;
+	SpliceStats mSpliceStats;
+	int64_t mLastEndUs;	// of the last frame given to the sink
 };
 	
 }
@@ -0,0 +1,176 @@
+/*
+ * MediaRuntime.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <chrono>
+#include <new>
+#include "log.hpp"
+#include "MediaRuntime.hpp"
+#include "mediabase/Clock.hpp"
+
+extern "C" {
+#include "libavformat/avformat.h"
+#include "libavcodec/avcodec.h"
+#include "libavfilter/avfilter.h"
+}
+
+using namespace std;
+
+namespace whitebean {
+
+/*
+ * avcodec_open2 of this FFmpeg fails when called on two threads at once
+ * unless a lock manager is registered, and prepare, the stream probing and
+ * the thumbnail workers all open codecs in parallel.
+ */
+static int lockManager(void **lock, enum AVLockOp op)
+{
+	switch (op) {
+	case AV_LOCK_CREATE:
+		*lock = new (nothrow) mutex;
+		return *lock ? 0 : 1;
+	case AV_LOCK_OBTAIN:
+		((mutex *)*lock)->lock();
+		return 0;
+	case AV_LOCK_RELEASE:
+		((mutex *)*lock)->unlock();
+		return 0;
+	case AV_LOCK_DESTROY:
+		delete (mutex *)*lock;
+		*lock = nullptr;
+		return 0;
+	}
+
+	return 1;
+}
+
+MediaRuntime &MediaRuntime::instance()
+{
+	static MediaRuntime runtime;
+	return runtime;
+}
+
+MediaRuntime::MediaRuntime()
+: mEngineObject(NULL)
+, mEngine(NULL)
+, mOutputMixObject(NULL)
+{
+	mStats.ffmpegInitUs = 0;
+	mStats.openslInitUs = 0;
+}
+
+void MediaRuntime::initFFmpeg()
+{
+	call_once(mFFmpegOnce, &MediaRuntime::doInitFFmpeg, this);
+}
+
+void MediaRuntime::doInitFFmpeg()
+{
+	auto start = chrono::steady_clock::now();
+
+	av_register_all();
+	avcodec_register_all();
+	avfilter_register_all();
+	avformat_network_init();
+
+	if (av_lockmgr_register(lockManager) < 0) {
+		LOGE("Register FFmpeg lock manager failed");
+	}
+
+	int64_t us = elapsedUs(start);
+	LOGI("FFmpeg registered in %lld us", (long long)us);
+
+	unique_lock<mutex> autoLock(mLock);
+	mStats.ffmpegInitUs = us;
+}
+
+int MediaRuntime::getOpensl(SLEngineItf &engine, SLObjectItf &outputMix)
+{
+	call_once(mOpenslOnce, &MediaRuntime::doInitOpensl, this);
+
+	if (!mEngine || !mOutputMixObject) {
+		return -1;
+	}
+
+	engine = mEngine;
+	outputMix = mOutputMixObject;
+
+	return 0;
+}
+
+void MediaRuntime::doInitOpensl()
+{
+	SLresult result;
+	const SLInterfaceID ids[1] = {SL_IID_VOLUME};
+	const SLboolean req[1] = {SL_BOOLEAN_FALSE};
+
+	auto start = chrono::steady_clock::now();
+
+	// create engine
+	result = slCreateEngine(&mEngineObject, 0, NULL, 0, NULL, NULL);
+	if (SL_RESULT_SUCCESS != result) {
+		LOGE("slCreateEngine failed");
+		mEngineObject = NULL;
+		return;
+	}
+
+	// realize the engine
+	result = (*mEngineObject)->Realize(mEngineObject, SL_BOOLEAN_FALSE);
+	if (SL_RESULT_SUCCESS != result) {
+		LOGE("(*mEngineObject)->Realize failed");
+		goto failed;
+	}
+
+	// get the engine interface, which is needed in order to create other objects
+	result = (*mEngineObject)->GetInterface(mEngineObject, SL_IID_ENGINE, &mEngine);
+	if (SL_RESULT_SUCCESS != result) {
+		LOGE("Get SL_IID_ENGINE failed");
+		goto failed;
+	}
+
+	// realize the output mix
+	result = (*mEngine)->CreateOutputMix(mEngine, &mOutputMixObject, 1, ids, req);
+	if (SL_RESULT_SUCCESS != result) {
+		LOGE("CreateOutputMix failed");
+		mOutputMixObject = NULL;
+		goto failed;
+	}
+
+	result = (*mOutputMixObject)->Realize(mOutputMixObject, SL_BOOLEAN_FALSE);
+	if (SL_RESULT_SUCCESS != result) {
+		LOGE("(*mOutputMixObject)->Realize");
+		goto failed;
+	}
+
+	{
+		int64_t us = elapsedUs(start);
+		LOGI("OpenSL engine created in %lld us", (long long)us);
+
+		unique_lock<mutex> autoLock(mLock);
+		mStats.openslInitUs = us;
+	}
+
+	return;
+ failed:
+	if (mOutputMixObject) {
+		(*mOutputMixObject)->Destroy(mOutputMixObject);
+		mOutputMixObject = NULL;
+	}
+
+	if (mEngineObject) {
+		(*mEngineObject)->Destroy(mEngineObject);
+		mEngineObject = NULL;
+	}
+
+	mEngine = NULL;
+}
+
+MediaRuntime::Stats MediaRuntime::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mStats;
+}
+
+}
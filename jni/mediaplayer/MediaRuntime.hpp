@@ -0,0 +1,65 @@
+/*
+ * MediaRuntime.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIARUNTIME_H_
+#define JNI_MEDIAPLAYER_MEDIARUNTIME_H_
+
+#include <stdint.h>
+#include <mutex>
+#include <SLES/OpenSLES.h>
+
+namespace whitebean {
+
+/*
+ * Process-wide media state, set up once on first use and kept until the
+ * process exits: FFmpeg component registration and the OpenSL engine with
+ * its output mix, shared by all audio sinks. Creating a player does no
+ * global work any more.
+ */
+class MediaRuntime {
+public:
+	struct Stats {
+		int64_t ffmpegInitUs;	// time spent registering FFmpeg components
+		int64_t openslInitUs;	// time spent creating the OpenSL engine
+	};
+
+	static MediaRuntime &instance();
+
+	/*
+	 * Register FFmpeg formats, codecs and filters and a lock manager for
+	 * opening codecs on several threads, only the first call does the work
+	 */
+	void initFFmpeg();
+
+	/*
+	 * Shared OpenSL engine and output mix, created by the first call
+	 */
+	int getOpensl(SLEngineItf &engine, SLObjectItf &outputMix);
+
+	Stats getStats() const;
+
+private:
+	MediaRuntime();
+	MediaRuntime(const MediaRuntime &) = delete;
+	MediaRuntime &operator=(const MediaRuntime &) = delete;
+
+	void doInitFFmpeg();
+	void doInitOpensl();
+
+	std::once_flag mFFmpegOnce;
+	std::once_flag mOpenslOnce;
+
+	SLObjectItf mEngineObject;
+	SLEngineItf mEngine;
+	SLObjectItf mOutputMixObject;
+
+	mutable std::mutex mLock;
+	Stats mStats;
+};
+
+}
+
+#endif
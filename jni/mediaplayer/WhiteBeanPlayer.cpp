@@ -5,8 +5,12 @@
  *      Author: loushuai
  */
 
+#include <stdlib.h>
+#include <future>
 #include "log.hpp"
 #include "WhiteBeanPlayer.hpp"
+#include "MediaRuntime.hpp"
+#include "mediabase/Clock.hpp"
 #include "mediasink/videosink/egl/EglSink.hpp"
 
 extern "C" {
@@ -19,6 +23,17 @@ using namespace std;
 
 namespace whitebean {
 
+static int panoLayoutOf(const shared_ptr<MediaSource> &source)
+{
+	int pano = PANO_LAYOUT_NONE;
+
+	if (source && source->getFormat()) {
+		source->getFormat()->findInt32(kKeyPanoramic, pano);
+	}
+
+	return pano;
+}
+
 struct WhiteBeanEvent : public TimedEventQueue::Event {
 	WhiteBeanEvent(WhiteBeanPlayer *player,
 				   void (WhiteBeanPlayer::*method)())
@@ -35,24 +50,73 @@ private:
 };
 
 WhiteBeanPlayer::WhiteBeanPlayer()
-: mQueueStarted(false)
+: mNativeWindow(nullptr)
+, mPendingWindow(nullptr)
+, mSurfaceChangePending(false)
+, mVideoCatchUp(false)
+, mAudioOnly(false)
+, mSeekInFlight(false)
+, mSeekPending(false)
+, mSeekPreview(false)
+, mSeekMode(SEEK_KEYFRAME)
+, mSeekAccurate(false)
+, mSeekTargetMs(0)
+, mSeekLatencyPending(false)
+, mSeekQuiet(false)
+, mTrickRate(1)
+, mTrickAnchorUs(0)
+, mGopCacheBudget(GopCache::DEFAULT_BUDGET)
+, mStepped(false)
+, mPlaylistIndex(0)
+, mNextIndex(-1)
+, mNextStartUs(-1)
+, mLoopStartUs(-1)
+, mLoopEndUs(-1)
+, mNextFailed(false)
+, mPlaylistEventPending(false)
+, mVideoGapPending(false)
+, mBufferingPercent(-1)
+, mBufferingEventPending(false)
+, mQueueStarted(false)
 , mFlags(0)
 , mIsAsyncPrepare(false)
 , mVideoEventPending(false)
+, mRedrawEventPending(false)
+, mTouchDx(0)
+, mTouchDy(0)
 , mVideoPosition(0)
 , mDurationUs(0)
 {
 	LOGD("WhiteBeanPlayer()");
-	av_register_all();
-	avcodec_register_all();
-	avfilter_register_all();
+
+	memset(&mPrepareStats, 0, sizeof(mPrepareStats));
+	memset(&mSeekStats, 0, sizeof(mSeekStats));
+	memset(&mTrickStats, 0, sizeof(mTrickStats));
+	mTrickStats.rate = 1;
+	memset(&mPlaylistStats, 0, sizeof(mPlaylistStats));
 
 	mVideoEvent = shared_ptr<WhiteBeanEvent>(new WhiteBeanEvent(this, &WhiteBeanPlayer::onVideoEvent));
+	mRedrawEvent = shared_ptr<WhiteBeanEvent>(new WhiteBeanEvent(this, &WhiteBeanPlayer::onRedrawEvent));
+	mSurfaceEvent = shared_ptr<WhiteBeanEvent>(new WhiteBeanEvent(this, &WhiteBeanPlayer::onSurfaceEvent));
+	mSeekFrameEvent = shared_ptr<WhiteBeanEvent>(new WhiteBeanEvent(this, &WhiteBeanPlayer::onSeekFrameEvent));
+	mStepEvent = shared_ptr<WhiteBeanEvent>(new WhiteBeanEvent(this, &WhiteBeanPlayer::onStepEvent));
+	mPlaylistEvent = shared_ptr<WhiteBeanEvent>(new WhiteBeanEvent(this, &WhiteBeanPlayer::onPlaylistEvent));
+	mBufferingEvent = shared_ptr<WhiteBeanEvent>(new WhiteBeanEvent(this, &WhiteBeanPlayer::onBufferingEvent));
 }
 
 WhiteBeanPlayer::~WhiteBeanPlayer()
 {
 	LOGD("~WhiteBeanPlayer()");
+
+	mVideoSinkPtr.reset();
+
+	if (mNativeWindow) {
+		ANativeWindow_release(mNativeWindow);
+	}
+
+	if (mPendingWindow) {
+		ANativeWindow_release(mPendingWindow);
+	}
 }
 
 void WhiteBeanPlayer::setListener(shared_ptr<MediaPlayerListener> &listener)
@@ -133,6 +197,10 @@ int WhiteBeanPlayer::prepare()
 		mPreparedCondition.wait(autoLock);
 	}
 
+	if (!(mFlags & PREPARED)) {
+		return -1;
+	}
+
 	finishAsync_l();
 
 	notifyListener(MEDIA_PREPARED);
@@ -175,29 +243,128 @@ void WhiteBeanPlayer::onPrepareAsyncEvent()
 	LOGD("onPrepareAsyncEvent");
 	int ret = 0;
 	unique_lock<mutex> autoLock(mLock);
+	auto start = chrono::steady_clock::now();
+	future<int> audioPrepared;
+	int64_t audioUs = 0;
+
+	memset(&mPrepareStats, 0, sizeof(mPrepareStats));
+
+	// registration is only needed once something is opened
+	MediaRuntime::instance().initFFmpeg();
 
 	mSourcePtr = shared_ptr<MediaSource>(new MediaSource);
 	ret = mSourcePtr->open(mUri);
 	if (ret != 0) {
 		// cancel prepare
 		LOGD("Set datasource error");
-		goto out;
+		modifyFlags(PREPARING, CLEAR);
+		modifyFlags(PREPARE_CANCELLED, SET);
+		mPreparedCondition.notify_all();
+		return;
 	}
 
+	mPrepareStats.openUs = elapsedUs(start);
+
 	mSourcePtr->setListener(this);
 	
 	mSourcePtr->start();
 
+	// the audio decoder and sink come up on their own thread while this
+	// one opens the video decoder and shows the first frame
+	if (mSourcePtr->hasAudio()) {
+		shared_ptr<AudioPlayer> audioPlayer(new AudioPlayer);
+		audioPlayer->setSource(mSourcePtr);
+		mAudioPlayerPtr = audioPlayer;
+
+		audioPrepared = async(launch::async, [audioPlayer, &audioUs]() {
+			auto audioStart = chrono::steady_clock::now();
+			int err = audioPlayer->prepare();
+			audioUs = elapsedUs(audioStart);
+			return err;
+		});
+	}
+
 	if (mSourcePtr->hasVideo()) {
+		auto videoStart = chrono::steady_clock::now();
+
 		initVideoDecoder();
+		mPrepareStats.videoDecoderUs = elapsedUs(videoStart);
+
+		if (!mNativeWindow) {
+			mVideoDecoder.setSkipFrame(AVDISCARD_NONKEY);
+		}
+
+		if (mAudioOnly) {
+			applyAudioOnly_l();
+		} else if (mNativeWindow) {
+			showFirstFrame_l();
+			if (mFlags & FIRST_FRAME) {
+				mPrepareStats.firstFrameUs = elapsedUs(start);
+			}
+		}
+	}
+
+	if (audioPrepared.valid()) {
+		if (audioPrepared.get() < 0) {
+			LOGE("Audio prepare failed");
+			mAudioPlayerPtr.reset();
+		}
+		mPrepareStats.audioUs = audioUs;
 	}
 
+	mPrepareStats.totalUs = elapsedUs(start);
+
+	LOGI("Prepared in %lld us: open %lld us, video decoder %lld us, audio %lld us, first frame at %lld us",
+		 (long long)mPrepareStats.totalUs, (long long)mPrepareStats.openUs,
+		 (long long)mPrepareStats.videoDecoderUs, (long long)mPrepareStats.audioUs,
+		 (long long)mPrepareStats.firstFrameUs);
+
 	modifyFlags((PREPARING|PREPARE_CANCELLED|PREPARING_CONNECTED), CLEAR);
 	modifyFlags(PREPARED, SET);
- out:
+
+	if (mIsAsyncPrepare) {
+		finishAsync_l();
+		notifyListener(MEDIA_PREPARED);
+	}
+
 	mPreparedCondition.notify_all();
 }
 
+/*
+ * Decode and show the first picture during prepare, so that it is on
+ * screen before play() is called
+ */
+void WhiteBeanPlayer::showFirstFrame_l()
+{
+	auto deadline = chrono::steady_clock::now() + chrono::milliseconds(FIRST_FRAME_TIMEOUT_MS);
+
+	while (!mVideoDecoder.read(mVideoBuffer)) {
+		if (chrono::steady_clock::now() > deadline) {
+			LOGD("No first frame after %d ms", FIRST_FRAME_TIMEOUT_MS);
+			return;
+		}
+		this_thread::sleep_for(chrono::milliseconds(2));
+	}
+
+	if (!mVideoSinkPtr) {
+		initRenderer_l();
+	}
+
+	if (!mVideoSinkPtr) {
+		return;
+	}
+
+	mVideoSinkPtr->display(mVideoBuffer);
+	mVideoPosition = mVideoBuffer.getPts();
+	modifyFlags(FIRST_FRAME, SET);
+}
+
+WhiteBeanPlayer::PrepareStats WhiteBeanPlayer::getPrepareStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mPrepareStats;
+}
+
 void WhiteBeanPlayer::onVideoEvent()
 {
 	unique_lock<mutex> autoLock(mLock);
@@ -206,13 +373,21 @@ void WhiteBeanPlayer::onVideoEvent()
 
 	mVideoEventPending = false;
 
-	if (!mVideoSinkPtr) {		
+	if (!mVideoSinkPtr && mNativeWindow) {
 		initRenderer_l();
 	}
 
-	if (mVideoSinkPtr) {
+	if (mTrickRate == -1) {
+		presentReverseFrame_l();
+	} else if (mTrickRate != 1) {
+		presentTrickFrame_l();
+	} else if (mVideoSinkPtr) {
 		bool ret = false;
 
+		if (mVideoCatchUp) {
+			dropLateFrames_l();
+		}
+
 		if (mVideoBuffer.empty()) {
 			ret = mVideoDecoder.read(mVideoBuffer);
 		}
@@ -220,13 +395,138 @@ void WhiteBeanPlayer::onVideoEvent()
 		if (!mVideoBuffer.empty() && videoNeedRender(mVideoBuffer)) {
 			mVideoSinkPtr->display(mVideoBuffer);
 			mVideoPosition = mVideoBuffer.getPts();
+			mVideoCatchUp = false;
+			seekFrameShown_l();
 			ret = mVideoDecoder.read(mVideoBuffer);
+
+			// first frame of a playlist item
+			if (mVideoGapPending) {
+				int64_t gapUs = elapsedUs(mLastFrameTime);
+				mPlaylistStats.lastVideoGapUs = gapUs;
+				mPlaylistStats.maxVideoGapUs = max(mPlaylistStats.maxVideoGapUs, gapUs);
+				mPlaylistStats.lastVideoInUs = mVideoPosition;
+				mVideoGapPending = false;
+			}
+			mLastFrameTime = chrono::steady_clock::now();
 		}
+	} else {
+		dropLateFrames_l();
+	}
+
+	// switched to the next item here without waiting for the next poll
+	checkPlaylist_l();
+
+	// the end of the playlist pauses, an item without video stops here
+	if (!(mFlags & PLAYING) || !mSourcePtr->hasVideo() || mAudioOnly) {
+		return;
 	}
 
 	postVideoEvent_l();
 }
 
+/*
+ * Keep the video queue following the audio clock while nothing is shown.
+ * Without audio there is no clock, the decoder just waits on its full queue.
+ */
+void WhiteBeanPlayer::dropLateFrames_l()
+{
+	if (!mAudioPlayerPtr) {
+		return;
+	}
+
+	int64_t audioTimeUs = mAudioPlayerPtr->getCurTime();
+
+	if (mVideoBuffer.empty()) {
+		mVideoDecoder.read(mVideoBuffer);
+	}
+
+	while (!mVideoBuffer.empty() && mVideoBuffer.getPts() < audioTimeUs - LATE_DROP_US) {
+		mVideoPosition = mVideoBuffer.getPts();
+		mVideoDecoder.read(mVideoBuffer);
+	}
+}
+
+void WhiteBeanPlayer::setVideoSurface(ANativeWindow *nativeWindow)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (!mQueueStarted) {
+		// nothing is rendering, the first video event creates the sink
+		if (mNativeWindow) {
+			ANativeWindow_release(mNativeWindow);
+		}
+		mNativeWindow = nativeWindow;
+		return;
+	}
+
+	if (mPendingWindow) {
+		ANativeWindow_release(mPendingWindow);
+	}
+
+	mPendingWindow = nativeWindow;
+
+	if (!mSurfaceChangePending) {
+		mSurfaceChangePending = true;
+		mQueue.postEvent(mSurfaceEvent);
+	}
+
+	while (mSurfaceChangePending && mQueueStarted) {
+		mSurfaceCondition.wait(autoLock);
+	}
+}
+
+void WhiteBeanPlayer::onSurfaceEvent()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	applySurface_l();
+	mSurfaceCondition.notify_all();
+}
+
+/*
+ * Swap the sink without touching the source or the decoders. The EGL
+ * context and the renderer of the old sink are pooled, the new sink
+ * picks them up again.
+ */
+void WhiteBeanPlayer::applySurface_l()
+{
+	if (!mSurfaceChangePending) {
+		return;
+	}
+
+	mSurfaceChangePending = false;
+
+	mVideoSinkPtr.reset();
+
+	if (mNativeWindow) {
+		ANativeWindow_release(mNativeWindow);
+	}
+
+	mNativeWindow = mPendingWindow;
+	mPendingWindow = nullptr;
+
+	if (!(mFlags & PREPARED) || !mSourcePtr || !mSourcePtr->hasVideo()) {
+		return;
+	}
+
+	if (!mNativeWindow) {
+		LOGD("Surface detached, decode key frames only");
+		mVideoDecoder.setSkipFrame(AVDISCARD_NONKEY);
+		return;
+	}
+
+	LOGD("Surface attached");
+	mVideoDecoder.setSkipFrame(AVDISCARD_DEFAULT);
+	mVideoCatchUp = true;
+
+	initRenderer_l();
+
+	// show the held frame instead of a blank surface until the next one
+	if (mVideoSinkPtr && !mVideoBuffer.empty()) {
+		mVideoSinkPtr->display(mVideoBuffer);
+	}
+}
+
 void WhiteBeanPlayer::postVideoEvent_l(int64_t delayUs)
 {
 	if (mVideoEventPending) {
@@ -240,6 +540,14 @@ void WhiteBeanPlayer::postVideoEvent_l(int64_t delayUs)
 void WhiteBeanPlayer::reset_l()
 {
 	mUri = "";
+	mPlaylist.clear();
+	mPlaylistIndex = 0;
+	mNextFailed = false;
+	mLoopStartUs = -1;
+	mLoopEndUs = -1;
+	mBuffering.reset();
+	mBufferingPercent = -1;
+	modifyFlags(CACHE_UNDERRUN, CLEAR);
 }
 
 void WhiteBeanPlayer::stop()
@@ -251,6 +559,18 @@ void WhiteBeanPlayer::stop()
         mQueueStarted = false;
     }
 
+	{
+		unique_lock<mutex> touchLock(mTouchLock);
+		mRedrawEventPending = false;
+	}
+
+	{
+		// the surface event may have been dropped with the queue
+		unique_lock<mutex> autoLock(mLock);
+		applySurface_l();
+		mSurfaceCondition.notify_all();
+	}
+
 	if (mSourcePtr) {
 		mSourcePtr->stop();
 	}
@@ -260,6 +580,28 @@ void WhiteBeanPlayer::stop()
 	}
 
 	mVideoDecoder.stop();
+
+	if (mGopCachePtr) {
+		mGopCachePtr->stop();
+		mGopCachePtr.reset();
+	}
+
+	if (mPreload.valid()) {
+		mPreload.wait();
+	}
+
+	if (mNextVideoDecoderPtr) {
+		mNextVideoDecoderPtr->stop();
+	}
+
+	if (mNextSourcePtr) {
+		mNextSourcePtr->stop();
+	}
+
+	for (auto &retire : mRetiring) {
+		retire.wait();
+	}
+	mRetiring.clear();
 }
 
 void WhiteBeanPlayer::release()
@@ -276,14 +618,25 @@ void WhiteBeanPlayer::initRenderer_l()
 
 	mVideoSinkPtr = shared_ptr<VideoSink>(new EglSink(mNativeWindow));
 
-	int pano;
 	int sink_type = VIDEO_SINK_TYPE_NORMAL;
-	if (mSourcePtr && mSourcePtr->getFormat() && mSourcePtr->getFormat()->findInt32(kKeyPanoramic, pano)) {
+
+	switch (panoLayoutOf(mSourcePtr)) {
+	case PANO_LAYOUT_EQUIRECT:
 		sink_type = VIDEO_SINK_TYPE_PANORAMIC;
+		break;
+	case PANO_LAYOUT_CUBEMAP_3X2:
+		sink_type = VIDEO_SINK_TYPE_CUBEMAP;
+		break;
+	case PANO_LAYOUT_EAC_3X2:
+		sink_type = VIDEO_SINK_TYPE_EAC;
+		break;
+	default:
+		break;
 	}
 
 	if (mVideoSinkPtr->init(sink_type)) {
 		LOGE("Video sink init failed");
+		mVideoSinkPtr.reset();
 		return;
 	}
 }
@@ -308,6 +661,36 @@ int WhiteBeanPlayer::play()
 		return -1;
 	}
 
+	// played to the end, start over
+	if (mFlags & AT_EOS) {
+		modifyFlags(AT_EOS, CLEAR);
+		mSeekTargetMs = 0;
+		mSeekPreview = false;
+		mSeekQuiet = true;
+		mSeekAccurate = false;
+
+		if (mSeekInFlight) {
+			mSeekPending = true;
+		} else {
+			startSeek_l();
+		}
+	}
+
+	// the decoders are still where the steps started
+	if (mStepped) {
+		mStepped = false;
+		mSeekTargetMs = mVideoPosition / 1000;
+		mSeekPreview = false;
+		mSeekQuiet = true;
+		mSeekAccurate = true;
+
+		if (mSeekInFlight) {
+			mSeekPending = true;
+		} else {
+			startSeek_l();
+		}
+	}
+
 	if (mSourcePtr->hasAudio()) {
 		LOGD("Has audio");
 		if (!mAudioPlayerPtr) {
@@ -318,16 +701,79 @@ int WhiteBeanPlayer::play()
 
 			mAudioPlayerPtr->setSource(mSourcePtr);			
 		}
-		mAudioPlayerPtr->start();
+
+		// muted while in trick play, held back while buffering
+		if (mTrickRate == 1 && !(mFlags & CACHE_UNDERRUN)) {
+			mAudioPlayerPtr->start();
+		}
 	}
 
-	if (mSourcePtr->hasVideo()) {
-		postVideoEvent_l();
+	if (mTrickRate != 1) {
+		mTrickAnchorTime = chrono::steady_clock::now();
+	}
+
+	// everything is decoded already, no need to wait for a tick
+	if (mSourcePtr->hasVideo() && !mAudioOnly) {
+		postVideoEvent_l(0);
+	}
+
+	postPlaylistEvent_l();
+	postBufferingEvent_l();
+
+	return 0;
+}
+
+int WhiteBeanPlayer::setAudioOnly(bool audioOnly)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (audioOnly == mAudioOnly) {
+		return 0;
+	}
+
+	if (audioOnly && mSourcePtr && !mSourcePtr->hasAudio()) {
+		LOGE("No audio to play");
+		return -1;
 	}
 
+	if (audioOnly && mTrickRate != 1) {
+		LOGE("No audio in trick play");
+		return -1;
+	}
+
+	mAudioOnly = audioOnly;
+
+	// applied at the end of prepare otherwise
+	if (!(mFlags & PREPARED) || !mSourcePtr || !mSourcePtr->hasVideo()) {
+		return 0;
+	}
+
+	applyAudioOnly_l();
+
 	return 0;
 }
 
+void WhiteBeanPlayer::applyAudioOnly_l()
+{
+	LOGD("Audio only %d", mAudioOnly);
+
+	mSourcePtr->setVideoDiscard(mAudioOnly);
+
+	if (mAudioOnly) {
+		mVideoDecoder.suspend();
+		cancelPlayerEvents();
+		mVideoBuffer.reset();
+		return;
+	}
+
+	mVideoDecoder.wakeUp();
+	mVideoCatchUp = true;
+
+	if (mFlags & PLAYING) {
+		postVideoEvent_l();
+	}
+}
+
 int WhiteBeanPlayer::pause()
 {
 	unique_lock<mutex> autoLock(mLock);
@@ -336,14 +782,29 @@ int WhiteBeanPlayer::pause()
 		return 0;
 	}
 
+	pause_l();
+
+	return 0;
+}
+
+void WhiteBeanPlayer::pause_l()
+{
 	if (mAudioPlayerPtr) {
 		mAudioPlayerPtr->pause();
 	}
 	cancelPlayerEvents();
 
-	modifyFlags(PLAYING, CLEAR);
+	mQueue.cancelEvent(mPlaylistEvent->eventID());
+	mPlaylistEventPending = false;
+	mQueue.cancelEvent(mBufferingEvent->eventID());
+	mBufferingEventPending = false;
 
-	return 0;
+	// the trick clock stands still from here
+	if (mTrickRate != 1) {
+		mTrickAnchorUs = trickClockUs_l();
+	}
+
+	modifyFlags(PLAYING, CLEAR);
 }
 
 void WhiteBeanPlayer::modifyFlags(unsigned value, FlagMode mode)
@@ -409,70 +870,1045 @@ bool WhiteBeanPlayer::isPlaying() const
 	return mFlags & PLAYING;
 }
 
-int WhiteBeanPlayer::seekTo(int64_t msec)
+int WhiteBeanPlayer::seekTo(int64_t msec, bool preview)
 {
-	LOGD("Seek to %lld", msec);
+	LOGD("Seek to %lld%s", msec, preview ? " (preview)" : "");
 	unique_lock<mutex> autoLock(mLock);
 
-	mSourcePtr->seekTo(msec);
-	mVideoDecoder.seekTo(msec);
-	if (mAudioPlayerPtr) {
-		mAudioPlayerPtr->seekTo(msec);
+	if (!mSourcePtr) {
+		return -1;
+	}
+
+	mSeekStats.requested++;
+	mSeekTargetMs = msec;
+	mSeekPreview = preview;
+	mSeekQuiet = false;
+	mSeekAccurate = mSeekMode == SEEK_ACCURATE;
+	mStepped = false;
+	modifyFlags(AT_EOS, CLEAR);
+
+	if (!preview) {
+		mSeekRequestTime = chrono::steady_clock::now();
+		mSeekLatencyPending = true;
+	}
+
+	if (mSeekInFlight) {
+		// taken up when the running one completes
+		if (mSeekPending) {
+			mSeekStats.coalesced++;
+		}
+		mSeekPending = true;
+		return 0;
 	}
+
+	startSeek_l();
 	
 	return 0;
 }
 
-int WhiteBeanPlayer::getCurrentPosition()
+void WhiteBeanPlayer::startSeek_l()
 {
-	unique_lock<mutex> autoLock(mLock);
-	int64_t curPos = 0;
+	mSeekInFlight = true;
+	mSeekPending = false;
+	mSeekStats.executed++;
 
-	if (mAudioPlayerPtr) {
-		curPos = mAudioPlayerPtr->getCurTime();
+	if (mSeekPreview) {
+		modifyFlags(SEEK_PREVIEW, SET);
+		mVideoDecoder.setSkipFrame(AVDISCARD_NONKEY);
 	} else {
-		curPos = mVideoPosition;
+		modifyFlags(SEEK_PREVIEW, CLEAR);
+		if (mNativeWindow && mTrickRate == 1) {
+			mVideoDecoder.setSkipFrame(AVDISCARD_DEFAULT);
+		}
 	}
 
-	//Curpos = mVideoPosition > curPos ? mVideoPosition : curPos;
+	bool accurate = !mSeekPreview && mSeekAccurate && mTrickRate == 1;
 
-	return curPos/1000;
+	mSourcePtr->seekTo(mSeekTargetMs);
+	mVideoDecoder.seekTo(mSeekTargetMs, accurate);
+	if (mAudioPlayerPtr) {
+		mAudioPlayerPtr->seekTo(mSeekTargetMs, accurate);
+	}
 }
 
-int WhiteBeanPlayer::getDuration()
+/*
+ * Count the first frame shown once the last seek has completed
+ */
+void WhiteBeanPlayer::seekFrameShown_l()
 {
-	unique_lock<mutex> autoLock(mLock);
-	if (mDurationUs >= 0) {
-		return mDurationUs/1000;
+	if (mSeekInFlight) {
+		return;
 	}
 
-	return -1;
+	if (mFlags & SEEK_PREVIEW) {
+		mSeekStats.previews++;
+		modifyFlags(SEEK_PREVIEW, CLEAR);
+	} else if (mSeekLatencyPending) {
+		mSeekStats.lastLatencyUs = chrono::duration_cast<chrono::microseconds>(
+			chrono::steady_clock::now() - mSeekRequestTime).count();
+		mSeekLatencyPending = false;
+		LOGD("Seek to first frame %lld us", (long long)mSeekStats.lastLatencyUs);
+	}
 }
 
-void WhiteBeanPlayer::cancelPlayerEvents()
+/*
+ * While paused no video event runs, show the frame at the new position
+ * from here
+ */
+void WhiteBeanPlayer::onSeekFrameEvent()
 {
-	mQueue.cancelEvent(mVideoEvent->eventID());
-	mVideoEventPending = false;
-}
+	unique_lock<mutex> autoLock(mLock);
 
-int WhiteBeanPlayer::mediaNotify(int msg, int arg1, int arg2)
-{
-	switch (msg) {
-	case SOURCE_SEEK_COMPLETE:
-		onSeekComplete();
-		break;
-	default:
-		LOGD("Unknown message %d", msg);
-		break;
+	if (mSeekInFlight || (mFlags & PLAYING)) {
+		return;
 	}
 
-	return 0;
+	if (!mVideoSinkPtr) {
+		initRenderer_l();
+	}
+
+	if (!mVideoSinkPtr) {
+		return;
+	}
+
+	if (mVideoBuffer.empty() && !mVideoDecoder.read(mVideoBuffer)) {
+		if (chrono::steady_clock::now() < mSeekFrameDeadline) {
+			mQueue.postEventWithDelay(mSeekFrameEvent, 2000);
+		}
+		return;
+	}
+
+	mVideoSinkPtr->display(mVideoBuffer);
+	mVideoPosition = mVideoBuffer.getPts();
+	seekFrameShown_l();
 }
 
-void WhiteBeanPlayer::onSeekComplete()
+WhiteBeanPlayer::SeekStats WhiteBeanPlayer::getSeekStats() const
 {
 	unique_lock<mutex> autoLock(mLock);
-	
+	return mSeekStats;
+}
+
+void WhiteBeanPlayer::setSeekMode(int mode)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mSeekMode = mode;
+}
+
+int WhiteBeanPlayer::setPlaybackRate(int rate)
+{
+	LOGD("Playback rate %d", rate);
+	unique_lock<mutex> autoLock(mLock);
+
+	if (abs(rate) != 1 && (abs(rate) < MIN_TRICK_RATE || abs(rate) > MAX_TRICK_RATE)) {
+		LOGE("Unsupported playback rate %d", rate);
+		return -1;
+	}
+
+	if (!(mFlags & PREPARED) || !mSourcePtr || !mSourcePtr->hasVideo() || mAudioOnly) {
+		return -1;
+	}
+
+	if (rate == mTrickRate) {
+		return 0;
+	}
+
+	if (rate == -1 && initGopCache_l() < 0) {
+		return -1;
+	}
+
+	int64_t positionUs = mTrickRate != 1 ? trickClockUs_l() : mVideoPosition;
+	if (mTrickRate == 1 && mAudioPlayerPtr && !mStepped) {
+		positionUs = mAudioPlayerPtr->getCurTime();
+	}
+
+	mTrickRate = rate;
+	mTrickStats.rate = rate;
+	mStepped = false;
+
+	// reverse playback decodes every frame, in the GOP cache
+	bool trick = abs(rate) >= MIN_TRICK_RATE;
+	mSourcePtr->setTrickRate(trick ? rate : 0);
+	mVideoDecoder.setSkipFrame((trick || !mNativeWindow) ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT);
+	mVideoDecoder.setSkipLoopFilter(trick ? AVDISCARD_ALL : AVDISCARD_DEFAULT);
+
+	if (mAudioPlayerPtr && (mFlags & PLAYING)) {
+		if (rate != 1) {
+			mAudioPlayerPtr->pause();
+		} else if (!(mFlags & CACHE_UNDERRUN)) {
+			mAudioPlayerPtr->start();
+		}
+	}
+
+	if (rate == -1) {
+		// the decoders are left where they are, the frame on screen is the
+		// first one going back
+		anchorTrickClock_l(mVideoPosition);
+		return 0;
+	}
+
+	// drops what was queued at the old rate and starts over from here
+	mSeekTargetMs = positionUs / 1000;
+	mSeekPreview = false;
+	mSeekQuiet = true;
+	mSeekAccurate = mSeekMode == SEEK_ACCURATE;
+
+	if (mSeekInFlight) {
+		mSeekPending = true;
+		return 0;
+	}
+
+	startSeek_l();
+
+	return 0;
+}
+
+WhiteBeanPlayer::TrickStats WhiteBeanPlayer::getTrickStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	TrickStats stats = mTrickStats;
+	if (mTrickRate != 1) {
+		stats.elapsedUs = elapsedUs(mTrickStartTime);
+	}
+
+	return stats;
+}
+
+int64_t WhiteBeanPlayer::trickClockUs_l() const
+{
+	int64_t clockUs = mTrickAnchorUs;
+
+	if (mFlags & PLAYING) {
+		clockUs += mTrickRate * elapsedUs(mTrickAnchorTime);
+	}
+
+	if (clockUs < 0) {
+		return 0;
+	}
+
+	if (mDurationUs > 0 && clockUs > mDurationUs) {
+		return mDurationUs;
+	}
+
+	return clockUs;
+}
+
+void WhiteBeanPlayer::anchorTrickClock_l(int64_t positionUs)
+{
+	mTrickAnchorUs = positionUs;
+	mTrickAnchorTime = chrono::steady_clock::now();
+	mTrickStartTime = mTrickAnchorTime;
+	mTrickStats.shownFrames = 0;
+	mTrickStats.droppedFrames = 0;
+}
+
+void WhiteBeanPlayer::presentTrickFrame_l()
+{
+	int64_t clockUs = trickClockUs_l();
+	int direction = mTrickRate > 0 ? 1 : -1;
+
+	// the source lands a key frame about this far apart
+	int64_t spacingUs = abs(mTrickRate) * MediaSource::TRICK_FRAME_INTERVAL_US;
+
+	if (mVideoBuffer.empty()) {
+		mVideoDecoder.read(mVideoBuffer);
+	}
+
+	while (!mVideoBuffer.empty() && (clockUs - mVideoBuffer.getPts()) * direction > spacingUs) {
+		mTrickStats.droppedFrames++;
+		mVideoDecoder.read(mVideoBuffer);
+	}
+
+	if (mVideoBuffer.empty() || (mVideoBuffer.getPts() - clockUs) * direction > 0) {
+		return;
+	}
+
+	if (mVideoSinkPtr) {
+		mVideoSinkPtr->display(mVideoBuffer);
+		seekFrameShown_l();
+	}
+
+	mVideoPosition = mVideoBuffer.getPts();
+	mTrickStats.shownFrames++;
+	mVideoDecoder.read(mVideoBuffer);
+}
+
+/*
+ * Show the frame the backwards clock has reached. Frames it has already
+ * passed are skipped, and nothing waits for the cache: a frame still being
+ * decoded is shown on a later event.
+ */
+void WhiteBeanPlayer::presentReverseFrame_l()
+{
+	int64_t clockUs = trickClockUs_l();
+	int64_t ptsUs = mVideoPosition;
+	FrameBuffer frmbuf, due;
+
+	while (mGopCachePtr->getFrame(ptsUs, -1, frmbuf, 0) == 0 && frmbuf.getPts() >= clockUs) {
+		if (!due.empty()) {
+			mTrickStats.droppedFrames++;
+		}
+		due = frmbuf;
+		ptsUs = frmbuf.getPts();
+	}
+
+	if (due.empty()) {
+		return;
+	}
+
+	if (mVideoSinkPtr) {
+		mVideoSinkPtr->display(due);
+		seekFrameShown_l();
+	}
+
+	mVideoPosition = due.getPts();
+	mTrickStats.shownFrames++;
+}
+
+int WhiteBeanPlayer::initGopCache_l()
+{
+	if (mGopCachePtr) {
+		return 0;
+	}
+
+	int format = AV_PIX_FMT_YUV420P;
+	mVideoDecoder.getMetaData().findInt32(kKeyColorFormat, format);
+
+	shared_ptr<GopCache> cache(new GopCache(mGopCacheBudget));
+	if (cache->open(mUri, format) < 0 || cache->start() < 0) {
+		LOGE("Gop cache init failed");
+		return -1;
+	}
+
+	mGopCachePtr = cache;
+
+	return 0;
+}
+
+int WhiteBeanPlayer::stepFrame(int delta)
+{
+	LOGD("Step frame %d", delta);
+	unique_lock<mutex> autoLock(mLock);
+
+	if (delta != 1 && delta != -1) {
+		return -1;
+	}
+
+	if (!(mFlags & PREPARED) || !mSourcePtr || !mSourcePtr->hasVideo() || mAudioOnly) {
+		return -1;
+	}
+
+	if (mTrickRate != 1) {
+		LOGE("No frame stepping in trick play");
+		return -1;
+	}
+
+	if (mFlags & PLAYING) {
+		pause_l();
+	}
+
+	if (initGopCache_l() < 0) {
+		return -1;
+	}
+
+	shared_ptr<GopCache> cache = mGopCachePtr;
+	int64_t fromUs = mVideoPosition;
+	FrameBuffer frmbuf;
+
+	// may decode a whole GOP, the player stays responsive meanwhile
+	autoLock.unlock();
+	int ret = cache->getFrame(fromUs, delta, frmbuf, STEP_TIMEOUT_MS);
+	autoLock.lock();
+
+	if (ret < 0) {
+		LOGD("No frame to step to from %lld", (long long)fromUs);
+		return -1;
+	}
+
+	// played or moved elsewhere meanwhile
+	if ((mFlags & PLAYING) || mTrickRate != 1 || mVideoPosition != fromUs) {
+		return -1;
+	}
+
+	mVideoPosition = frmbuf.getPts();
+	mStepped = true;
+	mStepBuffer = frmbuf;
+	mQueue.postEvent(mStepEvent);
+
+	return 0;
+}
+
+void WhiteBeanPlayer::onStepEvent()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mStepBuffer.empty()) {
+		return;
+	}
+
+	if (!mVideoSinkPtr) {
+		initRenderer_l();
+	}
+
+	if (mVideoSinkPtr) {
+		mVideoSinkPtr->display(mStepBuffer);
+	}
+
+	mStepBuffer.reset();
+}
+
+void WhiteBeanPlayer::setFrameCacheSize(size_t bytes)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	mGopCacheBudget = bytes;
+	if (mGopCachePtr) {
+		mGopCachePtr->setBudget(bytes);
+	}
+}
+
+GopCache::Stats WhiteBeanPlayer::getGopCacheStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (!mGopCachePtr) {
+		GopCache::Stats stats;
+		memset(&stats, 0, sizeof(stats));
+		return stats;
+	}
+
+	return mGopCachePtr->getStats();
+}
+
+int WhiteBeanPlayer::setPlaylist(const vector<string> &uris)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (uris.empty() || (mFlags & (PREPARING | PREPARED))) {
+		return -1;
+	}
+
+	reset_l();
+
+	mPlaylist = uris;
+	mUri = uris[0];
+
+	{
+		unique_lock<mutex> autoLock(mStateLock);
+		mStats.mURI = mUri;
+	}
+
+	return 0;
+}
+
+void WhiteBeanPlayer::setLooping(bool looping)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	// the item preloaded may not be the next one any more
+	if (mLoopEndUs < 0 && looping != !!(mFlags & LOOPING)) {
+		dropPreload_l();
+	}
+
+	modifyFlags(LOOPING, looping ? SET : CLEAR);
+}
+
+bool WhiteBeanPlayer::isLooping() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mFlags & LOOPING;
+}
+
+int WhiteBeanPlayer::getPlaylistIndex() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mPlaylistIndex;
+}
+
+WhiteBeanPlayer::PlaylistStats WhiteBeanPlayer::getPlaylistStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	PlaylistStats stats = mPlaylistStats;
+	stats.index = mPlaylistIndex;
+
+	return stats;
+}
+
+bool WhiteBeanPlayer::nextUri_l(string &uri, int &index) const
+{
+	// the loop head of an A-B loop is the same item again
+	if (mLoopEndUs >= 0) {
+		uri = mUri;
+		index = mPlaylistIndex;
+		return true;
+	}
+
+	// a single data source only loops
+	if (mPlaylist.empty()) {
+		if (!(mFlags & LOOPING) || mUri.empty()) {
+			return false;
+		}
+		uri = mUri;
+		index = 0;
+		return true;
+	}
+
+	index = mPlaylistIndex + 1;
+	if (index >= (int)mPlaylist.size()) {
+		if (!(mFlags & LOOPING)) {
+			return false;
+		}
+		index = 0;
+	}
+
+	uri = mPlaylist[index];
+
+	return true;
+}
+
+/*
+ * Open the next item, start demuxing and prime its decoders while the
+ * current one plays on. Its audio decoder is handed to the audio player
+ * last, from then on the sink may splice to it at any time.
+ */
+void WhiteBeanPlayer::startPreload_l()
+{
+	if (mPreload.valid() || mNextSourcePtr || mNextFailed || !nextUri_l(mNextUri, mNextIndex)) {
+		return;
+	}
+
+	LOGD("Preload item %d %s", mNextIndex, mNextUri.c_str());
+
+	shared_ptr<MediaSource> source(new MediaSource);
+	shared_ptr<MediaDecoder> videoDecoder(new MediaDecoder);
+	shared_ptr<AudioPlayer> audioPlayer = mAudioPlayerPtr;
+	IMediaListener *listener = this;
+	string uri = mNextUri;
+	int64_t startUs = mLoopEndUs >= 0 ? mLoopStartUs : -1;
+	int64_t endUs = mLoopEndUs;
+
+	mNextSourcePtr = source;
+	mNextVideoDecoderPtr = videoDecoder;
+	mNextStartUs = startUs;
+
+	mPreload = async(launch::async, [source, videoDecoder, audioPlayer, listener, uri,
+									 startUs, endUs]() -> int64_t {
+		auto start = chrono::steady_clock::now();
+
+		if (source->open(uri) != 0) {
+			LOGE("Open next item failed");
+			return -1;
+		}
+
+		// nothing is demuxed yet, the seek needs no handshake
+		if (startUs > 0 && source->seekTo_l(startUs / 1000) < 0) {
+			LOGE("Seek of the loop head failed");
+			return -1;
+		}
+
+		source->setListener(listener);
+		source->start();
+
+		if (source->hasVideo()) {
+			if (videoDecoder->open(source, source->getVideoStreamId()) < 0) {
+				LOGE("Open next video decoder failed");
+				source->stop();
+				return -1;
+			}
+			videoDecoder->setListener(source.get());
+			videoDecoder->setStartTarget(startUs);
+			videoDecoder->setEndTarget(endUs);
+			videoDecoder->start();
+		}
+
+		if (audioPlayer && source->hasAudio() && audioPlayer->setNextSource(source, startUs, endUs) < 0) {
+			videoDecoder->stop();
+			source->stop();
+			return -1;
+		}
+
+		return elapsedUs(start);
+	});
+}
+
+/*
+ * Preload the next item near the end of the current one, and move over to
+ * it once the current one has played out. When the audio spliced, the
+ * audio clock is the next item's already, and the video frames left of the
+ * current one would never be due, so video follows right away.
+ */
+void WhiteBeanPlayer::checkPlaylist_l()
+{
+	if (!(mFlags & PLAYING) || !mSourcePtr || mTrickRate != 1 || mSeekInFlight || mStepped) {
+		return;
+	}
+
+	int64_t positionUs = mAudioPlayerPtr ? mAudioPlayerPtr->getCurTime() : mVideoPosition;
+
+	// the loop head is kept ready all the time, it may come up any moment
+	if (mLoopEndUs >= 0 || mSourcePtr->eof()
+		|| (mDurationUs > 0 && positionUs >= mDurationUs - PRELOAD_AHEAD_US)) {
+		startPreload_l();
+	}
+
+	if (!finishPreload_l(false)) {
+		return;
+	}
+
+	bool spliced = mAudioPlayerPtr && mAudioPlayerPtr->getSource() != mSourcePtr;
+	bool ended;
+
+	if (mAudioPlayerPtr) {
+		// video beyond the last audio frame would never be due
+		ended = mAudioPlayerPtr->ended();
+	} else {
+		ended = !mSourcePtr->hasVideo() || mAudioOnly
+			|| (mVideoDecoder.eos() && mVideoBuffer.empty());
+	}
+
+	if (!spliced && !ended) {
+		return;
+	}
+
+	if (mNextSourcePtr) {
+		advancePlaylist_l();
+	} else {
+		completePlayback_l();
+	}
+}
+
+/*
+ * Take the result of the preload once it is done, false while it runs
+ */
+bool WhiteBeanPlayer::finishPreload_l(bool wait)
+{
+	if (!mPreload.valid()) {
+		return true;
+	}
+
+	if (!wait && mPreload.wait_for(chrono::seconds(0)) != future_status::ready) {
+		return false;
+	}
+
+	int64_t preloadUs = mPreload.get();
+	if (preloadUs < 0) {
+		LOGE("Preload of item %d failed, the playlist ends here", mNextIndex);
+		mNextSourcePtr.reset();
+		mNextVideoDecoderPtr.reset();
+		mNextFailed = true;
+	} else {
+		mPlaylistStats.lastPreloadUs = preloadUs;
+		LOGD("Item %d preloaded in %lld us", mNextIndex, (long long)preloadUs);
+	}
+
+	return true;
+}
+
+/*
+ * Forget the next item, for a change of what comes next
+ */
+void WhiteBeanPlayer::dropPreload_l()
+{
+	finishPreload_l(true);
+
+	// the audio is on it already, the rest has to follow
+	if (mNextSourcePtr && mAudioPlayerPtr && mAudioPlayerPtr->getSource() == mNextSourcePtr) {
+		advancePlaylist_l();
+		return;
+	}
+
+	if (mAudioPlayerPtr) {
+		mAudioPlayerPtr->clearNextSource();
+	}
+
+	if (mNextVideoDecoderPtr) {
+		mNextVideoDecoderPtr->stop();
+	}
+
+	if (mNextSourcePtr) {
+		mNextSourcePtr->stop();
+	}
+
+	mNextVideoDecoderPtr.reset();
+	mNextSourcePtr.reset();
+	mNextIndex = -1;
+	mNextFailed = false;
+}
+
+int WhiteBeanPlayer::setLoopRange(int64_t startMs, int64_t endMs)
+{
+	LOGD("Loop range %lld - %lld", startMs, endMs);
+	unique_lock<mutex> autoLock(mLock);
+
+	if (!(mFlags & PREPARED) || !mSourcePtr) {
+		return -1;
+	}
+
+	if (endMs >= 0 && (startMs < 0 || startMs >= endMs
+					   || (mDurationUs > 0 && endMs * 1000 > mDurationUs))) {
+		LOGE("Invalid loop range");
+		return -1;
+	}
+
+	int64_t oldEndUs = mLoopEndUs;
+
+	mLoopStartUs = endMs >= 0 ? startMs * 1000 : -1;
+	mLoopEndUs = endMs >= 0 ? endMs * 1000 : -1;
+
+	// the loop head was decoded for the old range
+	dropPreload_l();
+
+	mVideoDecoder.setEndTarget(mLoopEndUs);
+	if (mAudioPlayerPtr) {
+		mAudioPlayerPtr->setEndTarget(mLoopEndUs);
+	}
+
+	// the frames after the old end are dropped already, refill from the
+	// current position. A position past the new end wraps by itself.
+	if (oldEndUs >= 0 && (mLoopEndUs < 0 || mLoopEndUs > oldEndUs)) {
+		int64_t positionUs = mAudioPlayerPtr ? mAudioPlayerPtr->getCurTime() : mVideoPosition;
+
+		mSeekTargetMs = positionUs / 1000;
+		mSeekPreview = false;
+		mSeekQuiet = true;
+		mSeekAccurate = true;
+
+		if (mSeekInFlight) {
+			mSeekPending = true;
+		} else {
+			startSeek_l();
+		}
+	}
+
+	return 0;
+}
+
+void WhiteBeanPlayer::advancePlaylist_l()
+{
+	shared_ptr<MediaSource> oldSource = mSourcePtr;
+	// keeps the decoder of the played out item after the swap
+	shared_ptr<MediaDecoder> oldVideoDecoder = mNextVideoDecoderPtr;
+	shared_ptr<MediaDecoder> oldAudioDecoder;
+	shared_ptr<AudioPlayer> oldAudioPlayer;
+	shared_ptr<GopCache> oldGopCache = mGopCachePtr;
+
+	if (mNextSourcePtr->hasVideo()) {
+		mVideoDecoder.swap(*oldVideoDecoder);
+	} else {
+		// the next decoder was never opened, ours retires with its item
+		// and leaves nothing behind to read from
+		oldVideoDecoder = shared_ptr<MediaDecoder>(new MediaDecoder);
+		oldVideoDecoder->swap(mVideoDecoder);
+	}
+	mSourcePtr = mNextSourcePtr;
+	mNextSourcePtr.reset();
+	mNextVideoDecoderPtr.reset();
+	mGopCachePtr.reset();
+
+	mUri = mNextUri;
+	mPlaylistIndex = mNextIndex;
+	mNextIndex = -1;
+
+	{
+		unique_lock<mutex> autoLock(mStateLock);
+		mStats.mURI = mUri;
+	}
+
+	mPlaylistStats.lastVideoOutUs = mVideoPosition;
+	mVideoBuffer.reset();
+	mVideoPosition = max(mNextStartUs, (int64_t)0);
+	mDurationUs = 0;
+	mBufferingPercent = -1;
+	finishAsync_l();
+
+	if (mAudioPlayerPtr) {
+		if (mAudioPlayerPtr->getSource() == mSourcePtr) {
+			AudioPlayer::SpliceStats splice = mAudioPlayerPtr->getSpliceStats();
+			mPlaylistStats.lastAudioGapUs = splice.lastGapUs;
+			mPlaylistStats.maxAudioGapUs = splice.maxGapUs;
+			mPlaylistStats.lastAudioOutUs = splice.lastOutUs;
+			mPlaylistStats.lastAudioInUs = splice.lastInUs;
+			oldAudioDecoder = mAudioPlayerPtr->takeRetired();
+		} else {
+			// nothing to splice to, the next item has no audio
+			oldAudioPlayer = mAudioPlayerPtr;
+			mAudioPlayerPtr.reset();
+		}
+	}
+
+	// no audio before, the sink has to be opened now
+	if (!mAudioPlayerPtr && mSourcePtr->hasAudio()) {
+		mAudioPlayerPtr = shared_ptr<AudioPlayer>(new AudioPlayer);
+		mAudioPlayerPtr->setSource(mSourcePtr);
+		if (mAudioPlayerPtr->start() < 0) {
+			LOGE("Audio start failed");
+			mAudioPlayerPtr.reset();
+		}
+	}
+
+	if (mSourcePtr->hasVideo()) {
+		if (!mNativeWindow) {
+			mVideoDecoder.setSkipFrame(AVDISCARD_NONKEY);
+		}
+
+		if (mAudioOnly) {
+			mSourcePtr->setVideoDiscard(true);
+			mVideoDecoder.suspend();
+		}
+	}
+
+	// the sink renders any frame format, only the projection is fixed
+	if (mVideoSinkPtr) {
+		if (!mSourcePtr->hasVideo()) {
+			mVideoSinkPtr.reset();
+		} else if (panoLayoutOf(oldSource) == panoLayoutOf(mSourcePtr)) {
+			mPlaylistStats.rendererReuses++;
+		} else {
+			mVideoSinkPtr.reset();
+		}
+	}
+
+	mVideoGapPending = mSourcePtr->hasVideo() && !mAudioOnly && mNativeWindow;
+	mPlaylistStats.transitions++;
+
+	// video events run only for items with video, the playlist event
+	// keeps an audio only item going
+	if (!mSourcePtr->hasVideo() || mAudioOnly) {
+		cancelPlayerEvents();
+	} else if (mFlags & PLAYING) {
+		postVideoEvent_l();
+	}
+
+	LOGI("Playlist item %d started, audio gap %lld us",
+		 mPlaylistIndex, (long long)mPlaylistStats.lastAudioGapUs);
+
+	// joining the decoder threads of the old item is left to another
+	// thread, a future still running must not be waited for here
+	reapRetired_l();
+	mRetiring.push_back(async(launch::async, [oldSource, oldVideoDecoder, oldAudioDecoder,
+											  oldAudioPlayer, oldGopCache]() {
+		if (oldAudioPlayer) {
+			oldAudioPlayer->stop();
+		}
+		if (oldAudioDecoder) {
+			oldAudioDecoder->stop();
+		}
+		if (oldGopCache) {
+			oldGopCache->stop();
+		}
+		oldVideoDecoder->stop();
+		oldSource->stop();
+	}));
+
+	notifyListener(MEDIA_INFO, MEDIA_INFO_STARTED_AS_NEXT, mPlaylistIndex);
+}
+
+/*
+ * Drop the retire futures that are done, destroying one that is not would
+ * block until it is
+ */
+void WhiteBeanPlayer::reapRetired_l()
+{
+	for (auto it = mRetiring.begin(); it != mRetiring.end(); ) {
+		if (it->wait_for(chrono::seconds(0)) == future_status::ready) {
+			it = mRetiring.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void WhiteBeanPlayer::completePlayback_l()
+{
+	LOGD("Playback complete");
+
+	pause_l();
+	modifyFlags(AT_EOS, SET);
+
+	notifyListener(MEDIA_PLAYBACK_COMPLETE);
+}
+
+void WhiteBeanPlayer::postPlaylistEvent_l()
+{
+	if (mPlaylistEventPending) {
+		return;
+	}
+
+	mPlaylistEventPending = true;
+	mQueue.postEventWithDelay(mPlaylistEvent, PLAYLIST_POLL_US);
+}
+
+/*
+ * Audio only playback has no video events to move the playlist on
+ */
+void WhiteBeanPlayer::onPlaylistEvent()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	mPlaylistEventPending = false;
+
+	checkPlaylist_l();
+
+	if (mFlags & PLAYING) {
+		postPlaylistEvent_l();
+	}
+}
+
+int WhiteBeanPlayer::setBufferingWatermarks(int64_t lowMs, int64_t highMs)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (lowMs < 0 || highMs < lowMs) {
+		LOGE("Invalid buffering watermarks %lld, %lld", (long long)lowMs, (long long)highMs);
+		return -1;
+	}
+
+	return mBuffering.setWatermarks(lowMs * 1000, highMs * 1000);
+}
+
+BufferingMonitor::Stats WhiteBeanPlayer::getBufferingStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mBuffering.getStats();
+}
+
+/*
+ * The audio is the clock, it is held while less than the low watermark is
+ * demuxed ahead and the video waits on it. The end of the file or a full
+ * queue ends buffering whatever the watermark, nothing more is coming in.
+ */
+void WhiteBeanPlayer::updateBuffering_l()
+{
+	if (!mSourcePtr || mSeekInFlight || mTrickRate != 1 || mStepped) {
+		return;
+	}
+
+	int64_t bufferedUs = mSourcePtr->getBufferedUs();
+	bool eof = mSourcePtr->eof();
+
+	switch (mBuffering.update(bufferedUs, eof || mSourcePtr->bufferFull())) {
+	case BufferingMonitor::BUFFERING_START:
+		modifyFlags(CACHE_UNDERRUN, SET);
+		if (mAudioPlayerPtr) {
+			mAudioPlayerPtr->pause();
+		}
+		notifyListener(MEDIA_INFO, MEDIA_INFO_BUFFERING_START);
+		break;
+	case BufferingMonitor::BUFFERING_END:
+		modifyFlags(CACHE_UNDERRUN, CLEAR);
+		if (mAudioPlayerPtr && (mFlags & PLAYING)) {
+			mAudioPlayerPtr->start();
+		}
+		notifyListener(MEDIA_INFO, MEDIA_INFO_BUFFERING_END);
+		break;
+	default:
+		break;
+	}
+
+	if (mDurationUs <= 0) {
+		return;
+	}
+
+	int percent = 100;
+	if (!eof) {
+		int64_t positionUs = mAudioPlayerPtr ? mAudioPlayerPtr->getCurTime() : mVideoPosition;
+		percent = min<int64_t>(100, max<int64_t>(0, positionUs + bufferedUs) * 100 / mDurationUs);
+	}
+
+	if (percent != mBufferingPercent) {
+		mBufferingPercent = percent;
+		notifyListener(MEDIA_BUFFERING_UPDATE, percent);
+	}
+}
+
+void WhiteBeanPlayer::postBufferingEvent_l()
+{
+	if (mBufferingEventPending) {
+		return;
+	}
+
+	mBufferingEventPending = true;
+	mQueue.postEventWithDelay(mBufferingEvent, BUFFERING_POLL_US);
+}
+
+void WhiteBeanPlayer::onBufferingEvent()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	mBufferingEventPending = false;
+
+	updateBuffering_l();
+
+	if (mFlags & PLAYING) {
+		postBufferingEvent_l();
+	}
+}
+
+int WhiteBeanPlayer::getCurrentPosition()
+{
+	unique_lock<mutex> autoLock(mLock);
+	int64_t curPos = 0;
+
+	if (mStepped) {
+		curPos = mVideoPosition;
+	} else if (mTrickRate != 1) {
+		curPos = trickClockUs_l();
+	} else if (mAudioPlayerPtr) {
+		curPos = mAudioPlayerPtr->getCurTime();
+	} else {
+		curPos = mVideoPosition;
+	}
+
+	//Curpos = mVideoPosition > curPos ? mVideoPosition : curPos;
+
+	return curPos/1000;
+}
+
+int WhiteBeanPlayer::getDuration()
+{
+	unique_lock<mutex> autoLock(mLock);
+	if (mDurationUs >= 0) {
+		return mDurationUs/1000;
+	}
+
+	return -1;
+}
+
+void WhiteBeanPlayer::cancelPlayerEvents()
+{
+	mQueue.cancelEvent(mVideoEvent->eventID());
+	mVideoEventPending = false;
+}
+
+int WhiteBeanPlayer::mediaNotify(int msg, int arg1, int arg2)
+{
+	switch (msg) {
+	case SOURCE_SEEK_COMPLETE:
+		onSeekComplete(arg1);
+		break;
+	default:
+		LOGD("Unknown message %d", msg);
+		break;
+	}
+
+	return 0;
+}
+
+void WhiteBeanPlayer::onSeekComplete(int status)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mSeekPending) {
+		// the target moved on meanwhile, the decoders stay halted and
+		// nothing is decoded for this one
+		startSeek_l();
+		return;
+	}
+
+	mSeekInFlight = false;
+	
 	if (mAudioPlayerPtr) {
 		mAudioPlayerPtr->resume();
 	}
@@ -480,13 +1916,80 @@ void WhiteBeanPlayer::onSeekComplete()
 
 	if (!mVideoBuffer.empty()) {
 		mVideoBuffer.reset();
-	}	
+	}
+
+	// nothing moved, the next seek starts afresh
+	if (status < 0) {
+		LOGE("Seek to %lld ms failed", (long long)mSeekTargetMs);
+		mSeekStats.failed++;
+		mSeekLatencyPending = false;
+		modifyFlags(SEEK_PREVIEW, CLEAR);
+
+		if (!mSeekPreview && !mSeekQuiet) {
+			notifyListener(MEDIA_SEEK_COMPLETE, status);
+		}
+		return;
+	}
+
+	if (mSourcePtr->hasVideo() && mNativeWindow && !mAudioOnly && !(mFlags & PLAYING)) {
+		int timeoutMs = FIRST_FRAME_TIMEOUT_MS;
+		if (!mSeekPreview && mSeekAccurate) {
+			timeoutMs = ACCURATE_SEEK_TIMEOUT_MS;
+		}
+		mSeekFrameDeadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+		mQueue.postEvent(mSeekFrameEvent);
+	}
+
+	if (mTrickRate != 1) {
+		anchorTrickClock_l(mSeekTargetMs * 1000);
+	}
+
+	// playing backwards goes on from the target
+	if (mTrickRate == -1) {
+		mVideoPosition = mSeekTargetMs * 1000;
+	}
+
+	if (!mSeekPreview && !mSeekQuiet) {
+		notifyListener(MEDIA_SEEK_COMPLETE);
+	}
 }
 
+/*
+ * Called from the UI thread. The view is changed and redrawn on the queue
+ * thread, which owns the EGL context, without waiting for the next frame.
+ */
 void WhiteBeanPlayer::onTouchMoveEvent(float dx, float dy)
 {
+	unique_lock<mutex> autoLock(mTouchLock);
+
+	mTouchDx += dx;
+	mTouchDy += dy;
+
+	if (!mQueueStarted || mRedrawEventPending) {
+		return;
+	}
+
+	mRedrawEventPending = true;
+	mQueue.postEvent(mRedrawEvent);
+}
+
+void WhiteBeanPlayer::onRedrawEvent()
+{
+	unique_lock<mutex> autoLock(mLock);
+	float dx, dy;
+
+	{
+		unique_lock<mutex> touchLock(mTouchLock);
+		dx = mTouchDx;
+		dy = mTouchDy;
+		mTouchDx = 0;
+		mTouchDy = 0;
+		mRedrawEventPending = false;
+	}
+
 	if (mVideoSinkPtr) {
 		mVideoSinkPtr->onTouchMoveEvent(dx, dy);
+		mVideoSinkPtr->redraw();
 	}
 }
 	
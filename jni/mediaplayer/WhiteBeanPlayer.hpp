@@ -9,11 +9,18 @@
 #define JNI_MEDIAPLAYER_WHITEBEANPLAYER_H_
 
 #include <string>
+#include <vector>
+#include <list>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <mutex>
 #include <memory>
 #include <android/native_window_jni.h>
 #include "TimedEventQueue.h"
 #include "AudioPlayer.hpp"
+#include "mediabase/GopCache.hpp"
+#include "mediabase/BufferingMonitor.hpp"
 #include "mediasink/videosink/VideoSink.hpp"
 #include "mediasink/videosink/egl/EglSink.hpp"
 
@@ -27,6 +34,30 @@ public:
 	
 class WhiteBeanPlayer: public IMediaListener {
 public:
+	// msg of MediaPlayerListener::notify(), and ext1 of MEDIA_INFO
+	enum media_event_type {
+		MEDIA_NOP               = 0, // interface test message
+		MEDIA_PREPARED          = 1,
+		MEDIA_PLAYBACK_COMPLETE = 2,
+		MEDIA_BUFFERING_UPDATE  = 3,
+		MEDIA_SEEK_COMPLETE     = 4,
+		MEDIA_SET_VIDEO_SIZE    = 5,
+		MEDIA_STARTED           = 6,
+		MEDIA_PAUSED            = 7,
+		MEDIA_STOPPED           = 8,
+		MEDIA_SKIPPED           = 9,
+		MEDIA_TIMED_TEXT        = 99,
+		MEDIA_ERROR             = 100,
+		MEDIA_INFO              = 200,
+		MEDIA_SUBTITLE_DATA     = 201,
+	};
+
+	enum media_info_type {
+		MEDIA_INFO_STARTED_AS_NEXT = 2,
+		MEDIA_INFO_BUFFERING_START = 701,
+		MEDIA_INFO_BUFFERING_END   = 702,
+	};
+
 	WhiteBeanPlayer();
 	~WhiteBeanPlayer();
 
@@ -43,14 +74,162 @@ public:
 	int getCurrentPosition();
 	int getDuration();
 
-	void setVideoSurface(ANativeWindow *nativeWindow) {
-		mNativeWindow = nativeWindow;
-	}
+	/*
+	 * Attach a surface, or detach with nullptr. The player takes over the
+	 * window reference. Decoding goes on while detached, and the call only
+	 * returns once the previous window is not used any more, so it can be
+	 * called from surfaceDestroyed().
+	 */
+	void setVideoSurface(ANativeWindow *nativeWindow);
+
+	/*
+	 * Audio only playback, e.g. in background: video is neither demuxed
+	 * nor decoded and the video decoder memory is released. Leaving the
+	 * mode resumes video at the next key frame after the audio clock.
+	 */
+	int setAudioOnly(bool audioOnly);
 
 	void onTouchMoveEvent(float dx, float dy);
 
 	bool isPlaying() const;
-	int seekTo(int64_t msec);
+	/*
+	 * Requests arriving while a seek is running collapse to the newest one,
+	 * the decoders are not resumed for a target that is already stale.
+	 * A preview seek, while a seek bar is dragged, decodes keyframes only
+	 * and shows the one at or before msec. The seek on release goes back
+	 * to decoding every frame.
+	 */
+	int seekTo(int64_t msec, bool preview = false);
+
+	struct SeekStats {
+		int requested;
+		int executed;		// seeks actually run through the decoders
+		int coalesced;		// requests replaced before they ran
+		int previews;		// preview frames shown
+		int failed;			// the source could not seek, playback went on
+		int64_t lastLatencyUs;	// last non-preview request to its first frame
+	};
+
+	SeekStats getSeekStats() const;
+
+	enum SeekMode {
+		SEEK_KEYFRAME = 0,	// start at the key frame before the target, fastest
+		SEEK_ACCURATE,		// decode from there and start exactly at the target
+	};
+
+	/*
+	 * How non-preview seeks land, SEEK_KEYFRAME by default. Previews always
+	 * stop at key frames.
+	 */
+	void setSeekMode(int mode);
+
+	/*
+	 * Fast forward at 2 to 64 times normal speed, rewind at -2 to -64, back
+	 * to normal at 1. Only key frames are demuxed and decoded, without the
+	 * loop filter, and shown on a clock running at rate while audio is
+	 * muted. Each change restarts from the current position.
+	 * At -1 every frame is played backwards out of the GOP cache, starting
+	 * from the frame on screen.
+	 */
+	int setPlaybackRate(int rate);
+
+	static const int MIN_TRICK_RATE = 2;
+	static const int MAX_TRICK_RATE = 64;
+
+	struct TrickStats {
+		int rate;
+		int shownFrames;
+		int droppedFrames;	// decoded but already a key frame behind the clock
+		int64_t elapsedUs;	// since the rate took effect
+	};
+
+	TrickStats getTrickStats() const;
+
+	/*
+	 * Show the next (1) or previous (-1) frame, pausing first if playing.
+	 * Frames come from the GOP cache, decoded apart from playback, so
+	 * stepping back does not seek. Playing again starts at the frame
+	 * stepped to. Refused during trick play.
+	 */
+	int stepFrame(int delta);
+
+	// memory for decoded frames kept by stepping and reverse playback
+	void setFrameCacheSize(size_t bytes);
+
+	GopCache::Stats getGopCacheStats() const;
+
+	/*
+	 * Where the last prepare spent its time, in us. Audio is prepared in
+	 * parallel with the video decoder and the first frame, firstFrameUs is
+	 * counted from the start of prepare, 0 if no frame was shown.
+	 */
+	struct PrepareStats {
+		int64_t openUs;
+		int64_t videoDecoderUs;
+		int64_t audioUs;
+		int64_t firstFrameUs;
+		int64_t totalUs;
+	};
+
+	PrepareStats getPrepareStats() const;
+
+	/*
+	 * Play uris one after the other, the first as by setDataSource(). Near
+	 * the end of each item the next one is opened and its decoders primed,
+	 * its audio takes over in the same sink without a gap and the renderer
+	 * is kept when the picture layout matches. Each new item is reported
+	 * as MEDIA_INFO MEDIA_INFO_STARTED_AS_NEXT with its index, the end of
+	 * the list as MEDIA_PLAYBACK_COMPLETE.
+	 */
+	int setPlaylist(const std::vector<std::string> &uris);
+
+	// go on with the first item after the last, or the data source again
+	void setLooping(bool looping);
+	bool isLooping() const;
+
+	int getPlaylistIndex() const;
+
+	/*
+	 * Loop from startMs to endMs of the current item, endMs -1 stops. The
+	 * loop head, from startMs on, is kept decoded ahead on a second source
+	 * of the file, and the decoders playing stop exactly at endMs, audio at
+	 * the sample, so the wrap splices like a playlist transition instead
+	 * of seeking.
+	 */
+	int setLoopRange(int64_t startMs, int64_t endMs);
+
+	struct PlaylistStats {
+		int index;
+		int transitions;
+		int rendererReuses;		// transitions that kept the video sink
+		int64_t lastPreloadUs;	// opening the next item and its decoders
+		int64_t lastAudioGapUs;	// the audio sink waited across the splice
+		int64_t maxAudioGapUs;
+		int64_t lastVideoGapUs;	// last frame of an item to the first of the next
+		int64_t maxVideoGapUs;
+		// where the last transition left the old item and entered the new
+		// one, in us of each, the loop end and start for an A-B loop
+		int64_t lastAudioOutUs;
+		int64_t lastAudioInUs;
+		int64_t lastVideoOutUs;
+		int64_t lastVideoInUs;
+	};
+
+	PlaylistStats getPlaylistStats() const;
+
+	// the next item is opened this long before the current one ends
+	static const int64_t PRELOAD_AHEAD_US = 5000000;
+
+	/*
+	 * Playback stops for buffering once less than lowMs is demuxed ahead of
+	 * it and goes on from highMs, reported as MEDIA_INFO with
+	 * MEDIA_INFO_BUFFERING_START and MEDIA_INFO_BUFFERING_END. While playing,
+	 * how far into the file is buffered is reported in percent as
+	 * MEDIA_BUFFERING_UPDATE.
+	 */
+	int setBufferingWatermarks(int64_t lowMs, int64_t highMs);
+
+	BufferingMonitor::Stats getBufferingStats() const;
 
 private:
 	friend struct WhiteBeanEvent;
@@ -88,31 +267,115 @@ private:
         SLOW_DECODER_HACK   = 0x40000,
 		};
 
-	enum media_event_type {
-		MEDIA_NOP               = 0, // interface test message
-		MEDIA_PREPARED          = 1,
-		MEDIA_PLAYBACK_COMPLETE = 2,
-		MEDIA_BUFFERING_UPDATE  = 3,
-		MEDIA_SEEK_COMPLETE     = 4,
-		MEDIA_SET_VIDEO_SIZE    = 5,
-		MEDIA_STARTED           = 6,
-		MEDIA_PAUSED            = 7,
-		MEDIA_STOPPED           = 8,
-		MEDIA_SKIPPED           = 9,
-		MEDIA_TIMED_TEXT        = 99,
-		MEDIA_ERROR             = 100,
-		MEDIA_INFO              = 200,
-		MEDIA_SUBTITLE_DATA     = 201,
-	};
-
 	std::shared_ptr<MediaPlayerListener> mListener;
 	mutable std::mutex mLock;
 	mutable std::mutex mStateLock;
 	std::condition_variable mPreparedCondition;
 
 	ANativeWindow *mNativeWindow;
+
+	// surface changes are applied on the queue thread, which owns the sink
+	ANativeWindow *mPendingWindow;
+	bool mSurfaceChangePending;
+	std::condition_variable mSurfaceCondition;
+	std::shared_ptr<TimedEventQueue::Event> mSurfaceEvent;
+
+	// frames further than this behind the audio clock are dropped while
+	// no surface is attached, or until one is shown after a reattach
+	static const int64_t LATE_DROP_US = 40000;
+	bool mVideoCatchUp;
+	bool mAudioOnly;
+
+	static const int FIRST_FRAME_TIMEOUT_MS = 1000;
+	// an accurate seek may decode a whole GOP before its frame
+	static const int ACCURATE_SEEK_TIMEOUT_MS = 5000;
+	PrepareStats mPrepareStats;
+
+	// one seek runs at a time, later requests only move the target
+	bool mSeekInFlight;
+	bool mSeekPending;
+	bool mSeekPreview;
+	int mSeekMode;
+	bool mSeekAccurate;
+	int64_t mSeekTargetMs;
+	bool mSeekLatencyPending;
+	std::chrono::steady_clock::time_point mSeekRequestTime;
+	std::chrono::steady_clock::time_point mSeekFrameDeadline;
+	std::shared_ptr<TimedEventQueue::Event> mSeekFrameEvent;
+	SeekStats mSeekStats;
+	// seeks run by a rate change are not reported
+	bool mSeekQuiet;
+
+	// trick play clock, anchored at the position a rate took effect
+	int64_t trickClockUs_l() const;
+	void anchorTrickClock_l(int64_t positionUs);
+	void presentTrickFrame_l();
+	void presentReverseFrame_l();
+	int mTrickRate;
+	int64_t mTrickAnchorUs;
+	std::chrono::steady_clock::time_point mTrickAnchorTime;
+	std::chrono::steady_clock::time_point mTrickStartTime;
+	TrickStats mTrickStats;
+
+	// frames for stepping and reverse playback, created on first use
+	int initGopCache_l();
+	void onStepEvent();
+	static const int STEP_TIMEOUT_MS = 2000;
+	std::shared_ptr<GopCache> mGopCachePtr;
+	size_t mGopCacheBudget;
+	// shown by the queue thread, which owns the sink
+	FrameBuffer mStepBuffer;
+	std::shared_ptr<TimedEventQueue::Event> mStepEvent;
+	// the frame on screen was stepped to, playback has to catch up
+	bool mStepped;
+
+	// the next item is opened on a thread of its own and taken over by
+	// the queue thread once the current one has played out
+	bool nextUri_l(std::string &uri, int &index) const;
+	void startPreload_l();
+	bool finishPreload_l(bool wait);
+	void dropPreload_l();
+	void checkPlaylist_l();
+	void advancePlaylist_l();
+	void completePlayback_l();
+	void reapRetired_l();
+	void postPlaylistEvent_l();
+	void onPlaylistEvent();
+	static const int64_t PLAYLIST_POLL_US = 100000;
+	std::vector<std::string> mPlaylist;
+	int mPlaylistIndex;
+	int mNextIndex;
+	std::string mNextUri;
+	int64_t mNextStartUs;
+	// A-B loop, -1 when not looping
+	int64_t mLoopStartUs;
+	int64_t mLoopEndUs;
+	std::future<int64_t> mPreload;	// us taken, -1 if it failed
+	bool mNextFailed;
+	std::shared_ptr<MediaSource> mNextSourcePtr;
+	std::shared_ptr<MediaDecoder> mNextVideoDecoderPtr;
+	// stop what the last items left behind, a short A-B loop can wrap
+	// again before the last one is done
+	std::list<std::future<void> > mRetiring;
+	std::shared_ptr<TimedEventQueue::Event> mPlaylistEvent;
+	bool mPlaylistEventPending;
+	PlaylistStats mPlaylistStats;
+	bool mVideoGapPending;
+	std::chrono::steady_clock::time_point mLastFrameTime;
+
+	// the clock stops while the source falls behind, polled as the
+	// playlist is since audio only playback has no video events
+	void updateBuffering_l();
+	void postBufferingEvent_l();
+	void onBufferingEvent();
+	static const int64_t BUFFERING_POLL_US = 100000;
+	BufferingMonitor mBuffering;
+	int mBufferingPercent;
+	std::shared_ptr<TimedEventQueue::Event> mBufferingEvent;
+	bool mBufferingEventPending;
     TimedEventQueue mQueue;
-    bool mQueueStarted;
+    // written under mLock, also read by the touch path under mTouchLock
+    std::atomic<bool> mQueueStarted;
 	std::shared_ptr<MediaSource> mSourcePtr;
 	std::shared_ptr<AudioPlayer> mAudioPlayerPtr;
 	std::shared_ptr<VideoSink>   mVideoSinkPtr;
@@ -134,6 +397,13 @@ private:
 	std::shared_ptr<TimedEventQueue::Event> mVideoEvent;
 	bool mVideoEventPending;
 
+	// touch moves are accumulated here and applied by one redraw event
+	std::mutex mTouchLock;
+	std::shared_ptr<TimedEventQueue::Event> mRedrawEvent;
+	bool mRedrawEventPending;
+	float mTouchDx;
+	float mTouchDy;
+
 	int64_t mVideoPosition;
 	int64_t mDurationUs;
 	
@@ -146,10 +416,20 @@ private:
 	void cancelPlayerEvents();
 	
 	int prepareAsync_l();
+	void pause_l();
 	void finishAsync_l();
 	void onVideoEvent();
+	void onRedrawEvent();
+	void onSurfaceEvent();
+	void applySurface_l();
+	void dropLateFrames_l();
+	void applyAudioOnly_l();
+	void showFirstFrame_l();
 	void onPrepareAsyncEvent();
-	void onSeekComplete();
+	void onSeekComplete(int status);
+	void startSeek_l();
+	void onSeekFrameEvent();
+	void seekFrameShown_l();
 	void reset_l();
 	void initRenderer_l();
 	int initVideoDecoder();
@@ -0,0 +1,100 @@
+/*
+ * AVIOBridge.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <stdio.h>
+#include "log.hpp"
+#include "AVIOBridge.hpp"
+
+extern "C" {
+#include "libavutil/mem.h"
+#include "libavutil/error.h"
+}
+
+using namespace std;
+
+namespace whitebean {
+
+AVIOBridge::AVIOBridge(shared_ptr<ByteReader> reader)
+: mReader(reader)
+, mCtx(nullptr)
+{
+
+}
+
+AVIOBridge::~AVIOBridge()
+{
+	if (mCtx) {
+		// the context may have swapped its buffer
+		av_freep(&mCtx->buffer);
+		av_freep(&mCtx);
+	}
+}
+
+int AVIOBridge::init(int bufferSize)
+{
+	uint8_t *buffer = (uint8_t *)av_malloc(bufferSize);
+	if (!buffer) {
+		return -1;
+	}
+
+	mCtx = avio_alloc_context(buffer, bufferSize, 0, this, readPacket, nullptr, seek);
+	if (!mCtx) {
+		LOGE("Alloc avio context failed");
+		av_free(buffer);
+		return -1;
+	}
+
+	mCtx->seekable = mReader->size() >= 0 ? AVIO_SEEKABLE_NORMAL : 0;
+
+	return 0;
+}
+
+//static
+int AVIOBridge::readPacket(void *opaque, uint8_t *buf, int size)
+{
+	AVIOBridge *me = (AVIOBridge *)opaque;
+
+	int ret = me->mReader->read(buf, size);
+	if (ret == 0) {
+		return AVERROR_EOF;
+	}
+
+	return ret < 0 ? AVERROR(EIO) : ret;
+}
+
+//static
+int64_t AVIOBridge::seek(void *opaque, int64_t offset, int whence)
+{
+	AVIOBridge *me = (AVIOBridge *)opaque;
+	ByteReader *reader = me->mReader.get();
+	int64_t size = reader->size();
+
+	whence &= ~AVSEEK_FORCE;
+
+	switch (whence) {
+	case AVSEEK_SIZE:
+		return size >= 0 ? size : AVERROR(ENOSYS);
+	case SEEK_SET:
+		break;
+	case SEEK_CUR:
+		offset += reader->tell();
+		break;
+	case SEEK_END:
+		if (size < 0) {
+			return AVERROR(ENOSYS);
+		}
+		offset += size;
+		break;
+	default:
+		return AVERROR(EINVAL);
+	}
+
+	int64_t pos = reader->seek(offset);
+
+	return pos < 0 ? AVERROR(EIO) : pos;
+}
+
+}
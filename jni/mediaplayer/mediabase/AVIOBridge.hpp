@@ -0,0 +1,53 @@
+/*
+ * AVIOBridge.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_AVIOBRIDGE_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_AVIOBRIDGE_H_
+
+#include <memory>
+#include "ByteReader.hpp"
+
+extern "C" {
+#include "libavformat/avio.h"
+}
+
+namespace whitebean {
+
+/*
+ * AVIOContext reading from a ByteReader, set as AVFormatContext::pb with
+ * AVFMT_FLAG_CUSTOM_IO. It must outlive the format context using it.
+ */
+class AVIOBridge {
+public:
+	static const int DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+	explicit AVIOBridge(std::shared_ptr<ByteReader> reader);
+	~AVIOBridge();
+
+	int init(int bufferSize = DEFAULT_BUFFER_SIZE);
+
+	AVIOContext *get() const {
+		return mCtx;
+	}
+
+	std::shared_ptr<ByteReader> getReader() const {
+		return mReader;
+	}
+
+private:
+	AVIOBridge(const AVIOBridge &) = delete;
+	AVIOBridge &operator=(const AVIOBridge &) = delete;
+
+	static int readPacket(void *opaque, uint8_t *buf, int size);
+	static int64_t seek(void *opaque, int64_t offset, int whence);
+
+	std::shared_ptr<ByteReader> mReader;
+	AVIOContext *mCtx;
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * BufferingMonitor.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include "log.hpp"
+#include "BufferingMonitor.hpp"
+
+namespace whitebean {
+
+BufferingMonitor::BufferingMonitor(int64_t lowUs, int64_t highUs)
+	: mLowUs(DEFAULT_LOW_WATERMARK_US)
+	, mHighUs(DEFAULT_HIGH_WATERMARK_US)
+	, mBuffering(false)
+	, mStats({0, 0, 0})
+{
+	setWatermarks(lowUs, highUs);
+}
+
+int BufferingMonitor::setWatermarks(int64_t lowUs, int64_t highUs)
+{
+	if (lowUs < 0) {
+		LOGE("invalid buffering watermark %lld\n", (long long)lowUs);
+		return -1;
+	}
+
+	mLowUs = lowUs;
+	mHighUs = highUs < lowUs ? lowUs : highUs;
+
+	return 0;
+}
+
+BufferingMonitor::Event BufferingMonitor::update(int64_t bufferedUs, bool complete)
+{
+	if (!mBuffering) {
+		if (complete || bufferedUs >= mLowUs) {
+			return NONE;
+		}
+
+		mBuffering = true;
+		mStartTime = std::chrono::steady_clock::now();
+		mStats.underruns++;
+		LOGD("buffering start, %lld us buffered\n", (long long)bufferedUs);
+
+		return BUFFERING_START;
+	}
+
+	if (!complete && bufferedUs < mHighUs) {
+		return NONE;
+	}
+
+	mBuffering = false;
+	mStats.lastBufferingUs = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - mStartTime).count();
+	mStats.bufferingUs += mStats.lastBufferingUs;
+	LOGD("buffering end after %lld us, %lld us buffered\n",
+		 (long long)mStats.lastBufferingUs, (long long)bufferedUs);
+
+	return BUFFERING_END;
+}
+
+void BufferingMonitor::reset()
+{
+	mBuffering = false;
+}
+
+}
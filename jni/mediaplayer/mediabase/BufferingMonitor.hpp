@@ -0,0 +1,84 @@
+/*
+ * BufferingMonitor.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_BUFFERINGMONITOR_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_BUFFERINGMONITOR_H_
+
+#include <stdint.h>
+#include <chrono>
+
+namespace whitebean {
+
+/*
+ * Buffering state of a playing source, from the demuxed duration queued in
+ * its tracks. Playback stops for buffering when the queue drops under the
+ * low watermark and goes on once it is back over the high one, or the
+ * source has nothing more to give. The gap between the two keeps a source
+ * read just about at the playback rate from stopping on every packet.
+ */
+class BufferingMonitor {
+public:
+	enum Event {
+		NONE = 0,
+		BUFFERING_START,
+		BUFFERING_END,
+	};
+
+	struct Stats {
+		int underruns;
+		int64_t bufferingUs;		// summed over the underruns
+		int64_t lastBufferingUs;
+	};
+
+	static const int64_t DEFAULT_LOW_WATERMARK_US = 300000;
+	static const int64_t DEFAULT_HIGH_WATERMARK_US = 2000000;
+
+	explicit BufferingMonitor(int64_t lowUs = DEFAULT_LOW_WATERMARK_US,
+							  int64_t highUs = DEFAULT_HIGH_WATERMARK_US);
+
+	/*
+	 * high is raised to low when under it. Returns -1 on a negative low.
+	 */
+	int setWatermarks(int64_t lowUs, int64_t highUs);
+
+	int64_t getLowWatermarkUs() const {
+		return mLowUs;
+	}
+
+	int64_t getHighWatermarkUs() const {
+		return mHighUs;
+	}
+
+	/*
+	 * Feed the buffered duration, complete once the source is at its end or
+	 * can not queue more. Returns the transition, if any.
+	 */
+	Event update(int64_t bufferedUs, bool complete);
+
+	bool buffering() const {
+		return mBuffering;
+	}
+
+	/*
+	 * Leave buffering without an event, for seeks and stops. Stats stay.
+	 */
+	void reset();
+
+	Stats getStats() const {
+		return mStats;
+	}
+
+private:
+	int64_t mLowUs;
+	int64_t mHighUs;
+	bool mBuffering;
+	std::chrono::steady_clock::time_point mStartTime;
+	Stats mStats;
+};
+
+}
+
+#endif
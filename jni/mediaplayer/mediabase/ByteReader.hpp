@@ -0,0 +1,44 @@
+/*
+ * ByteReader.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_BYTEREADER_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_BYTEREADER_H_
+
+#include <stdint.h>
+
+namespace whitebean {
+
+/*
+ * Random access byte stream under the demuxer, see AVIOBridge. Readers can
+ * be stacked, one reading through another.
+ */
+class ByteReader {
+public:
+	ByteReader() {}
+	virtual ~ByteReader() {}
+
+	/*
+	 * Read up to size bytes at the current position.
+	 * Returns the byte count, 0 at the end, -1 on error.
+	 */
+	virtual int read(uint8_t *buf, int size) = 0;
+
+	/*
+	 * Move to an absolute position, returns it or -1
+	 */
+	virtual int64_t seek(int64_t pos) = 0;
+
+	virtual int64_t tell() const = 0;
+
+	/*
+	 * Total size in bytes, -1 if unknown
+	 */
+	virtual int64_t size() const = 0;
+};
+
+}
+
+#endif
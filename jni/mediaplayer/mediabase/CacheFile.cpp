@@ -0,0 +1,85 @@
+/*
+ * CacheFile.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <atomic>
+#include "log.hpp"
+#include "CacheFile.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+bool CacheFile::localPath(const string &uri, string &path)
+{
+	if (uri.compare(0, 7, "file://") == 0) {
+		path = uri.substr(7);
+	} else if (uri.compare(0, 5, "file:") == 0) {
+		path = uri.substr(5);
+	} else if (uri.find("://") != string::npos) {
+		return false;
+	} else {
+		path = uri;
+	}
+
+	return true;
+}
+
+bool CacheFile::getFileKey(const string &uri, string &path, int64_t &size, int64_t &mtimeNs)
+{
+	struct stat st;
+
+	if (!localPath(uri, path) || stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+		return false;
+	}
+
+	size = st.st_size;
+	mtimeNs = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+
+	return true;
+}
+
+uint64_t CacheFile::hash(const void *data, size_t size, uint64_t seed)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+	uint64_t hash = seed;
+
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+int CacheFile::writeAtomic(const string &path, const function<bool(FILE *fp)> &write)
+{
+	static atomic<unsigned int> count(0);
+
+	// scans of a cache directory drop these, see HttpCache
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", (int)getpid(), count++);
+	string tmpPath = path + suffix;
+
+	FILE *fp = fopen(tmpPath.c_str(), "wb");
+	if (!fp) {
+		LOGE("Open %s failed", tmpPath.c_str());
+		return -1;
+	}
+
+	bool written = write(fp);
+
+	if (fclose(fp) != 0 || !written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+		LOGE("Write %s failed", path.c_str());
+		unlink(tmpPath.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * CacheFile.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_CACHEFILE_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_CACHEFILE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+
+namespace whitebean {
+
+/*
+ * What the on-disk caches share: the key of a local file, the hash their
+ * entry names are made of, and the write that never leaves a partial
+ * entry behind.
+ */
+class CacheFile {
+public:
+	static const uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+
+	/*
+	 * The file a plain path or file: uri names, false for anything else
+	 */
+	static bool localPath(const std::string &uri, std::string &path);
+
+	/*
+	 * Size and mtime of the regular file uri names, an entry made for
+	 * another version of it is stale. False if it is not a local file.
+	 */
+	static bool getFileKey(const std::string &uri, std::string &path, int64_t &size, int64_t &mtimeNs);
+
+	/*
+	 * FNV-1a, chained through seed. The entries hold what was hashed in
+	 * full, a collision is only a miss.
+	 */
+	static uint64_t hash(const void *data, size_t size, uint64_t seed = HASH_SEED);
+	static uint64_t hash(const std::string &str, uint64_t seed = HASH_SEED) {
+		return hash(str.data(), str.size(), seed);
+	}
+
+	/*
+	 * Write path through write() on a file next to it, renamed over path
+	 * once complete: a reader sees the old entry or the whole new one.
+	 * Writers of the same path on other threads or processes do not
+	 * clash, the last rename wins.
+	 */
+	static int writeAtomic(const std::string &path, const std::function<bool(FILE *fp)> &write);
+};
+
+}
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * Clock.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_CLOCK_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_CLOCK_H_
+
+#include <stdint.h>
+#include <chrono>
+
+namespace whitebean {
+
+/*
+ * The monotonic clock in microseconds, only meaningful as a difference
+ */
+inline int64_t nowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline int64_t elapsedUs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ * FileReader.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include "log.hpp"
+#include "FileReader.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+FileReader::FileReader(int mode, size_t readAhead)
+: mMode(mode)
+, mReadAhead(readAhead > 0 ? readAhead : DEFAULT_READ_AHEAD)
+, mFd(-1)
+, mSize(0)
+, mPos(0)
+, mMap(nullptr)
+, mAdvisedEnd(0)
+, mBufferPos(0)
+, mBufferLength(0)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+FileReader::~FileReader()
+{
+	close();
+}
+
+int FileReader::open(const string &path)
+{
+	struct stat st;
+
+	close();
+
+	mFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (mFd < 0) {
+		LOGE("Open %s failed %s", path.c_str(), strerror(errno));
+		return -1;
+	}
+
+	if (fstat(mFd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		LOGE("%s is not a regular file", path.c_str());
+		close();
+		return -1;
+	}
+
+	mSize = st.st_size;
+	mPos = 0;
+
+	if (mMode == MODE_MMAP && mSize > 0 && (uint64_t)mSize <= SIZE_MAX) {
+		void *map = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+		if (map != MAP_FAILED) {
+			mMap = (uint8_t *)map;
+			madvise(mMap, mSize, MADV_SEQUENTIAL);
+			mAdvisedEnd = 0;
+			return 0;
+		}
+
+		LOGD("Map %s failed %s, reading buffered", path.c_str(), strerror(errno));
+	}
+
+	mMode = MODE_BUFFERED;
+	posix_fadvise(mFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	mBuffer.reset(new uint8_t[mReadAhead]);
+	mBufferPos = 0;
+	mBufferLength = 0;
+
+	return 0;
+}
+
+void FileReader::close()
+{
+	if (mMap) {
+		munmap(mMap, mSize);
+		mMap = nullptr;
+	}
+
+	if (mFd >= 0) {
+		::close(mFd);
+		mFd = -1;
+	}
+
+	mBuffer.reset();
+	mBufferLength = 0;
+}
+
+int FileReader::read(uint8_t *buf, int size)
+{
+	if (mFd < 0 || size < 0) {
+		return -1;
+	}
+
+	if (mPos >= mSize || size == 0) {
+		return 0;
+	}
+
+	int ret = mMap ? readMapped(buf, size) : readBuffered(buf, size);
+	if (ret > 0) {
+		mStats.bytesRead += ret;
+	}
+
+	return ret;
+}
+
+int FileReader::readMapped(uint8_t *buf, int size)
+{
+	int64_t len = min<int64_t>(size, mSize - mPos);
+
+	// keep one window requested ahead of the reader, half of it is refreshed
+	// at a time so that the hint never runs out mid read
+	if (mPos + len > mAdvisedEnd - (int64_t)mReadAhead / 2 || mPos < mAdvisedEnd - 2 * (int64_t)mReadAhead) {
+		int64_t page = sysconf(_SC_PAGESIZE);
+		int64_t start = mPos / page * page;
+		int64_t end = min<int64_t>(mPos + len + mReadAhead, mSize);
+
+		madvise(mMap + start, end - start, MADV_WILLNEED);
+		mAdvisedEnd = end;
+		mStats.syscalls++;
+	}
+
+	memcpy(buf, mMap + mPos, len);
+	mPos += len;
+
+	return len;
+}
+
+int FileReader::readBuffered(uint8_t *buf, int size)
+{
+	if (mPos < mBufferPos || mPos >= mBufferPos + (int64_t)mBufferLength) {
+		// large reads skip the buffer
+		if ((size_t)size >= mReadAhead) {
+			ssize_t n = pread(mFd, buf, size, mPos);
+			mStats.syscalls++;
+			if (n < 0) {
+				LOGE("Read failed %s", strerror(errno));
+				return -1;
+			}
+			mPos += n;
+			return n;
+		}
+
+		ssize_t n = pread(mFd, mBuffer.get(), mReadAhead, mPos);
+		mStats.syscalls++;
+		if (n < 0) {
+			LOGE("Read failed %s", strerror(errno));
+			mBufferLength = 0;
+			return -1;
+		}
+
+		mBufferPos = mPos;
+		mBufferLength = n;
+		if (n == 0) {
+			return 0;
+		}
+	}
+
+	size_t offset = mPos - mBufferPos;
+	size_t len = min<size_t>(size, mBufferLength - offset);
+
+	memcpy(buf, mBuffer.get() + offset, len);
+	mPos += len;
+
+	return len;
+}
+
+int64_t FileReader::seek(int64_t pos)
+{
+	if (mFd < 0 || pos < 0) {
+		return -1;
+	}
+
+	mPos = pos;
+	mStats.seeks++;
+
+	return mPos;
+}
+
+}
@@ -0,0 +1,87 @@
+/*
+ * FileReader.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_FILEREADER_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_FILEREADER_H_
+
+#include <stddef.h>
+#include <string>
+#include <memory>
+#include "ByteReader.hpp"
+
+namespace whitebean {
+
+/*
+ * Local file reader. MODE_MMAP maps the whole file, reads are copies and
+ * seeks only move the position; the kernel is told the access is
+ * sequential and the next window is requested ahead of the reader.
+ * MODE_BUFFERED pread()s readAhead bytes at a time, seeks inside the
+ * buffer cost nothing. A file that can not be mapped, e.g. larger than the
+ * address space, is read buffered.
+ */
+class FileReader: public ByteReader {
+public:
+	enum {
+		MODE_MMAP,
+		MODE_BUFFERED,
+	};
+
+	struct Stats {
+		int64_t syscalls;	// pread/madvise/lseek issued after open
+		int64_t bytesRead;
+		int64_t seeks;
+	};
+
+	static const size_t DEFAULT_READ_AHEAD = 1024 * 1024;
+
+	explicit FileReader(int mode = MODE_MMAP, size_t readAhead = DEFAULT_READ_AHEAD);
+	virtual ~FileReader();
+
+	int open(const std::string &path);
+	void close();
+
+	virtual int read(uint8_t *buf, int size) override;
+	virtual int64_t seek(int64_t pos) override;
+	virtual int64_t tell() const override {
+		return mPos;
+	}
+	virtual int64_t size() const override {
+		return mSize;
+	}
+
+	int getMode() const {
+		return mMode;
+	}
+
+	Stats getStats() const {
+		return mStats;
+	}
+
+private:
+	int readMapped(uint8_t *buf, int size);
+	int readBuffered(uint8_t *buf, int size);
+
+	int mMode;
+	size_t mReadAhead;
+	int mFd;
+	int64_t mSize;
+	int64_t mPos;
+
+	// MODE_MMAP
+	uint8_t *mMap;
+	int64_t mAdvisedEnd;
+
+	// MODE_BUFFERED, bytes [mBufferPos, mBufferPos + mBufferLength) of the file
+	std::unique_ptr<uint8_t[]> mBuffer;
+	int64_t mBufferPos;
+	size_t mBufferLength;
+
+	Stats mStats;
+};
+
+}
+
+#endif
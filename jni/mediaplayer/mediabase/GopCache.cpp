@@ -0,0 +1,520 @@
+/*
+ * GopCache.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <string.h>
+#include <chrono>
+#include "log.hpp"
+#include "GopCache.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+GopCache::GopCache(size_t budget)
+: mStreamId(-1)
+, mOutFormat(-1)
+, mBudget(budget)
+, mCachedBytes(0)
+, mServedPts(AV_NOPTS_VALUE)
+, mDirection(-1)
+, mCoverStart(AV_NOPTS_VALUE)
+, mCoverEnd(AV_NOPTS_VALUE)
+, mFirstPts(AV_NOPTS_VALUE)
+, mLastPts(AV_NOPTS_VALUE)
+, mRequestPending(false)
+, mRequestRunning(false)
+, mGeneration(0)
+{
+	mFilterCtx.bufferSinkCtx = nullptr;
+	mFilterCtx.bufferSrcCtx = nullptr;
+	memset(&mRequest, 0, sizeof(mRequest));
+	memset(&mRunRequest, 0, sizeof(mRunRequest));
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+GopCache::~GopCache()
+{
+	stop();
+}
+
+int GopCache::open(const string &uri, int outFormat)
+{
+	mSource = shared_ptr<MediaSource>(new MediaSource);
+
+	// only ever jumps to a key frame and reads one GOP from there
+	mSource->setPrefetchSize(0);
+
+	if (mSource->open(uri) < 0) {
+		LOGE("Gop cache open %s failed", uri.c_str());
+		return -1;
+	}
+
+	mStreamId = mSource->getVideoStreamId();
+	if (mStreamId < 0) {
+		LOGE("Gop cache needs a video stream");
+		return -1;
+	}
+
+	mCodecPtr = openStreamCodec(mSource->getFmtCtxPtr()->streams[mStreamId]);
+	if (!mCodecPtr) {
+		return -1;
+	}
+
+	mOutFormat = outFormat;
+
+	return 0;
+}
+
+int GopCache::start()
+{
+	return MediaThread::start();
+}
+
+void GopCache::stop()
+{
+	if (!isRunning()) {
+		return;
+	}
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+		mStopped = true;
+		mCondition.notify_all();
+	}
+
+	// mStopped is only touched under the lock, not through MediaThread::stop()
+	mThread.join();
+	mRunning = false;
+
+	if (mSource) {
+		mSource->stop();
+	}
+}
+
+int GopCache::getFrame(int64_t pts, int step, FrameBuffer &frmbuf, int timeoutMs)
+{
+	if (step != 1 && step != -1) {
+		return -1;
+	}
+
+	unique_lock<mutex> autoLock(mLock);
+
+	auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+	bool waited = false;
+
+	mDirection = step;
+
+	while (!mStopped) {
+		int index = lookup_l(pts, step);
+
+		if (index >= 0) {
+			frmbuf = mFrames[index];
+			mServedPts = frmbuf.getPts();
+
+			if (waited) {
+				mStats.misses++;
+			} else {
+				mStats.hits++;
+			}
+
+			// decode the next run while this one is shown, once less than
+			// half the budget is left in this direction
+			size_t ahead = step < 0 ? index : mFrames.size() - 1 - index;
+			if (ahead * (mCachedBytes / mFrames.size()) < mBudget / 2) {
+				request_l(step < 0 ? mCoverStart : mCoverEnd, step);
+			}
+
+			return 0;
+		}
+
+		if ((step < 0 && mFirstPts != AV_NOPTS_VALUE && pts <= mFirstPts)
+			|| (step > 0 && mLastPts != AV_NOPTS_VALUE && pts >= mLastPts)) {
+			return -1;
+		}
+
+		// inside the cached run the new one is decoded to join it
+		int64_t anchor = pts;
+		if (!mFrames.empty() && pts >= mCoverStart && pts <= mCoverEnd) {
+			anchor = step < 0 ? mCoverStart : mCoverEnd;
+		}
+
+		request_l(anchor, step);
+
+		int generation = mGeneration;
+		int failedRuns = mStats.failedRuns;
+		if (timeoutMs <= 0
+			|| !mCondition.wait_until(autoLock, deadline,
+									  [&] { return mGeneration != generation || mStopped; })) {
+			return -1;
+		}
+
+		// not retried in a loop, the next call asks again
+		if (mStats.failedRuns != failedRuns && lookup_l(pts, step) < 0) {
+			return -1;
+		}
+
+		waited = true;
+	}
+
+	return -1;
+}
+
+void GopCache::setBudget(size_t bytes)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	mBudget = bytes;
+	evict_l(mDirection);
+}
+
+GopCache::Stats GopCache::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	Stats stats = mStats;
+	stats.cachedBytes = mCachedBytes;
+	stats.cachedFrames = mFrames.size();
+
+	return stats;
+}
+
+int GopCache::lookup_l(int64_t pts, int step) const
+{
+	if (mFrames.empty() || pts < mCoverStart || pts > mCoverEnd) {
+		return -1;
+	}
+
+	// every frame between mCoverStart and mCoverEnd is cached
+	if (step > 0) {
+		for (size_t i = 0; i < mFrames.size(); ++i) {
+			if (mFrames[i].getPts() > pts) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	for (size_t i = mFrames.size(); i-- > 0; ) {
+		if (mFrames[i].getPts() < pts) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void GopCache::request_l(int64_t anchorUs, int direction)
+{
+	if (mRequestPending && mRequest.anchorUs == anchorUs && mRequest.direction == direction) {
+		return;
+	}
+
+	if (mRequestRunning && mRunRequest.anchorUs == anchorUs && mRunRequest.direction == direction) {
+		return;
+	}
+
+	if ((direction < 0 && mFirstPts != AV_NOPTS_VALUE && anchorUs <= mFirstPts)
+		|| (direction > 0 && mLastPts != AV_NOPTS_VALUE && anchorUs >= mLastPts)) {
+		return;
+	}
+
+	mRequest.anchorUs = anchorUs;
+	mRequest.direction = direction;
+	mRequestPending = true;
+	mCondition.notify_all();
+}
+
+void GopCache::merge_l(const Request &request, deque<FrameBuffer> &run, size_t bytes)
+{
+	if (run.empty()) {
+		// the run got to the end of the stream, nothing on that side
+		if (request.direction < 0) {
+			mFirstPts = request.anchorUs;
+		} else {
+			mLastPts = request.anchorUs;
+		}
+		return;
+	}
+
+	bool joins = !mFrames.empty()
+		&& request.anchorUs == (request.direction < 0 ? mCoverStart : mCoverEnd);
+
+	if (!joins) {
+		mFrames.clear();
+		mCachedBytes = 0;
+	}
+
+	if (request.direction < 0) {
+		for (auto it = run.rbegin(); it != run.rend(); ++it) {
+			mFrames.push_front(*it);
+		}
+		mCoverStart = run.front().getPts();
+		if (!joins) {
+			mCoverEnd = request.anchorUs;
+		}
+	} else {
+		for (auto it = run.begin(); it != run.end(); ++it) {
+			mFrames.push_back(*it);
+		}
+		mCoverEnd = run.back().getPts();
+		if (!joins) {
+			mCoverStart = request.anchorUs;
+		}
+	}
+
+	mCachedBytes += bytes;
+	evict_l(request.direction);
+}
+
+void GopCache::evict_l(int direction)
+{
+	// first the frames the reader has passed, then the far end of the ones
+	// ahead, down to the one frame a step needs
+	while (mCachedBytes > mBudget && mFrames.size() > 1) {
+		bool passed = mServedPts != AV_NOPTS_VALUE
+			&& (direction < 0 ? mFrames.back().getPts() > mServedPts
+							  : mFrames.front().getPts() < mServedPts);
+		bool back = direction < 0 ? passed : !passed;
+
+		if (back) {
+			mCachedBytes -= mFrames.back().vsize();
+			mFrames.pop_back();
+			if (!mFrames.empty()) {
+				mCoverEnd = mFrames.back().getPts();
+			}
+		} else {
+			mCachedBytes -= mFrames.front().vsize();
+			mFrames.pop_front();
+			if (!mFrames.empty()) {
+				mCoverStart = mFrames.front().getPts();
+			}
+		}
+
+		mStats.evictedFrames++;
+	}
+
+	if (mFrames.empty()) {
+		mCachedBytes = 0;
+		mCoverStart = AV_NOPTS_VALUE;
+		mCoverEnd = AV_NOPTS_VALUE;
+	}
+}
+
+void GopCache::threadEntry()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	while (!mStopped) {
+		if (!mRequestPending) {
+			mCondition.wait(autoLock);
+			continue;
+		}
+
+		Request request = mRequest;
+		size_t budget = mBudget / 2;
+		mRequestPending = false;
+		mRequestRunning = true;
+		mRunRequest = request;
+
+		autoLock.unlock();
+
+		deque<FrameBuffer> run;
+		size_t bytes = 0;
+		auto start = chrono::steady_clock::now();
+
+		int ret = decodeRun(request, budget, run, bytes);
+
+		int64_t decodeUs = chrono::duration_cast<chrono::microseconds>(
+			chrono::steady_clock::now() - start).count();
+
+		autoLock.lock();
+
+		mRequestRunning = false;
+		mStats.runs++;
+		mStats.decodeUs += decodeUs;
+
+		// the bounds stay as they were, the next step asks again
+		if (ret < 0) {
+			LOGE("Gop cache run %s %lld failed", request.direction < 0 ? "before" : "after",
+				 (long long)request.anchorUs);
+			mStats.failedRuns++;
+			mGeneration++;
+			mCondition.notify_all();
+			continue;
+		}
+
+		LOGD("Gop cache run %s %lld: %d frames in %lld us", request.direction < 0 ? "before" : "after",
+			 (long long)request.anchorUs, (int)run.size(), (long long)decodeUs);
+
+		merge_l(request, run, bytes);
+		mGeneration++;
+		mCondition.notify_all();
+	}
+}
+
+int GopCache::decodeRun(const Request &request, size_t budget, deque<FrameBuffer> &run, size_t &bytes)
+{
+	AVFormatContext *ctx = mSource->getFmtCtxPtr().get();
+	AVRational time_base = ctx->streams[mStreamId]->time_base;
+
+	// back from toUs(), a tick early going backwards so that the key frame
+	// at the anchor itself is not the one found
+	int64_t ts = request.anchorUs * time_base.den / ((int64_t)US_IN_SECOND * time_base.num);
+	if (request.direction < 0) {
+		ts--;
+	}
+
+	bytes = 0;
+
+	if (av_seek_frame(ctx, mStreamId, ts, AVSEEK_FLAG_BACKWARD) < 0) {
+		// before the first frame there is nothing to find, an empty run
+		int64_t startTime = ctx->streams[mStreamId]->start_time;
+		if (request.direction < 0 && startTime != AV_NOPTS_VALUE && ts < startTime) {
+			LOGD("Gop cache no frame before %lld", (long long)ts);
+			return 0;
+		}
+
+		LOGE("Gop cache seek to %lld failed", (long long)ts);
+		return -1;
+	}
+
+	avcodec_flush_buffers(mCodecPtr.get());
+
+	bool draining = false;
+	bool done = false;
+
+	while (!done && !stopped()) {
+		AVPacket packet;
+		av_init_packet(&packet);
+		packet.data = NULL;
+		packet.size = 0;
+
+		if (!draining) {
+			int ret = av_read_frame(ctx, &packet);
+			if (ret == AVERROR(EAGAIN)) {
+				continue;
+			} else if (ret < 0 && ret != AVERROR_EOF && !(ctx->pb && avio_feof(ctx->pb))) {
+				LOGE("Gop cache read failed (%d)", ret);
+				return -1;
+			} else if (ret < 0) {
+				// the frames still held by the decoder are drained out
+				draining = true;
+			} else if (packet.stream_index != mStreamId) {
+				av_packet_unref(&packet);
+				continue;
+			}
+		}
+
+		int ret = avcodec_send_packet(mCodecPtr.get(), draining ? NULL : &packet);
+		av_packet_unref(&packet);
+
+		// a packet the decoder rejects is skipped
+		if (ret < 0 && !draining) {
+			continue;
+		}
+
+		while (!done) {
+			FrameBuffer frmbuf;
+
+			ret = avcodec_receive_frame(mCodecPtr.get(), frmbuf.getDataPtr());
+			if (ret < 0) {
+				// wants the next packet, or has nothing left once draining
+				done = draining;
+				break;
+			}
+
+			ret = addFrame(request, budget, frmbuf, run, bytes);
+			if (ret < 0) {
+				return -1;
+			}
+			done = ret > 0;
+		}
+	}
+
+	return stopped() ? -1 : 0;
+}
+
+/*
+ * Put a decoded frame in the run, 1 once the run is complete
+ */
+int GopCache::addFrame(const Request &request, size_t budget, FrameBuffer &frmbuf,
+					   deque<FrameBuffer> &run, size_t &bytes)
+{
+	int64_t pts = frmbuf.getPts();
+	if (pts == AV_NOPTS_VALUE) {
+		return 0;
+	}
+
+	int64_t ptsUs = toUs(pts);
+
+	// frames come out in pts order
+	if (request.direction < 0) {
+		if (ptsUs >= request.anchorUs) {
+			return 1;
+		}
+	} else if (ptsUs <= request.anchorUs) {
+		return 0;
+	}
+
+	FrameBuffer out;
+	if (convert(frmbuf, out) < 0) {
+		return -1;
+	}
+
+	out.setPts(ptsUs);
+	size_t size = out.vsize();
+
+	if (request.direction > 0 && !run.empty() && bytes + size > budget) {
+		return 1;
+	}
+
+	run.push_back(out);
+	bytes += size;
+
+	// going backwards the frames nearest the anchor are the ones kept
+	while (request.direction < 0 && bytes > budget && run.size() > 1) {
+		bytes -= run.front().vsize();
+		run.pop_front();
+	}
+
+	return 0;
+}
+
+int GopCache::convert(FrameBuffer &frmbuf, FrameBuffer &out)
+{
+	if (frmbuf.getFormat() == mOutFormat) {
+		out = frmbuf;
+		return 0;
+	}
+
+	if (!mFilterCtx.filterGraph && initVideoFilters(mFilterCtx, mCodecPtr.get()) < 0) {
+		LOGE("Init video filter failed");
+		return -1;
+	}
+
+	if (av_buffersrc_add_frame_flags(mFilterCtx.bufferSrcCtx, frmbuf.getDataPtr(), 0) < 0
+		|| av_buffersink_get_frame(mFilterCtx.bufferSinkCtx, out.getDataPtr()) < 0) {
+		LOGE("Gop cache filter frame failed");
+		return -1;
+	}
+
+	return 0;
+}
+
+int64_t GopCache::toUs(int64_t pts) const
+{
+	// as Codec::timeScaleToUs(), so that the pts match the player's frames
+	AVRational time_base = mSource->getTimeScaleOfTrack(mStreamId);
+	return pts * US_IN_SECOND * time_base.num / time_base.den;
+}
+
+bool GopCache::stopped()
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mStopped;
+}
+
+}
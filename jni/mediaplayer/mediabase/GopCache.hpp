@@ -0,0 +1,124 @@
+/*
+ * GopCache.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_GOPCACHE_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_GOPCACHE_H_
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "MediaThread.hpp"
+#include "MediaSource.hpp"
+#include "MediaCodec.hpp"
+#include "FrameBuffer.hpp"
+
+namespace whitebean {
+
+/*
+ * Decoded pictures around the current one, for frame stepping and reverse
+ * playback. A worker with its own demuxer and decoder decodes from the key
+ * frame before a position and keeps a run of consecutive frames in pts
+ * order, so going back one frame costs nothing while the run lasts. When
+ * frames are served in either direction the next run that way is decoded
+ * ahead of time. The frames held stay within the byte budget, though at
+ * least one is kept: a run is capped at half of it, and frames at the end
+ * the reader moves away from are evicted first.
+ */
+class GopCache: public MediaThread {
+public:
+	struct Stats {
+		int64_t cachedBytes;
+		int cachedFrames;
+		int hits;			// frames served without waiting
+		int misses;			// frames the worker had to decode first
+		int runs;			// runs decoded
+		int failedRuns;		// decode errors, left for the next request
+		int64_t decodeUs;	// time spent decoding them
+		int evictedFrames;	// dropped to stay in the budget
+	};
+
+	static const size_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+	explicit GopCache(size_t budget = DEFAULT_BUDGET);
+	virtual ~GopCache();
+
+	/*
+	 * Open the video stream of uri. Pictures come out in outFormat, which
+	 * is what the player's video decoder outputs, converted to YUV420P
+	 * when the decoder gives something else.
+	 */
+	int open(const std::string &uri, int outFormat);
+
+	int start();
+	void stop();
+
+	/*
+	 * The frame next to the one at pts (in us), step is 1 or -1. Waits
+	 * up to timeoutMs for the worker if it is not cached. Returns -1 at
+	 * either end of the stream, on timeout or when decoding failed.
+	 */
+	int getFrame(int64_t pts, int step, FrameBuffer &frmbuf, int timeoutMs);
+
+	// evicts right away if the cache holds more
+	void setBudget(size_t bytes);
+
+	Stats getStats() const;
+
+private:
+	struct Request {
+		int64_t anchorUs;
+		int direction;
+	};
+
+	virtual void threadEntry() override;
+	int lookup_l(int64_t pts, int step) const;
+	void request_l(int64_t anchorUs, int direction);
+	void merge_l(const Request &request, std::deque<FrameBuffer> &run, size_t bytes);
+	void evict_l(int direction);
+	int decodeRun(const Request &request, size_t budget, std::deque<FrameBuffer> &run, size_t &bytes);
+	int addFrame(const Request &request, size_t budget, FrameBuffer &frmbuf,
+				 std::deque<FrameBuffer> &run, size_t &bytes);
+	int convert(FrameBuffer &frmbuf, FrameBuffer &out);
+	int64_t toUs(int64_t pts) const;
+	bool stopped();
+
+	std::shared_ptr<MediaSource>    mSource;
+	std::shared_ptr<AVCodecContext> mCodecPtr;
+	FilterContext mFilterCtx;
+	int mStreamId;
+	int mOutFormat;
+
+	mutable std::mutex mLock;
+	std::condition_variable mCondition;
+
+	size_t mBudget;
+	std::deque<FrameBuffer> mFrames;	// consecutive frames in pts order
+	size_t mCachedBytes;
+	int64_t mServedPts;					// last frame handed out
+	int mDirection;						// of the last step
+
+	// every frame with a pts in [mCoverStart, mCoverEnd] is in mFrames
+	int64_t mCoverStart;
+	int64_t mCoverEnd;
+
+	// there are no frames before mFirstPts or after mLastPts
+	int64_t mFirstPts;
+	int64_t mLastPts;
+
+	Request mRequest;
+	Request mRunRequest;		// being decoded
+	bool mRequestPending;
+	bool mRequestRunning;
+	int mGeneration;		// bumped by every run merged
+	Stats mStats;
+};
+
+}
+
+#endif
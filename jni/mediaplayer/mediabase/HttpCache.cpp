@@ -0,0 +1,329 @@
+/*
+ * HttpCache.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <vector>
+#include "log.hpp"
+#include "HttpCache.hpp"
+#include "CacheFile.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+static const uint32_t BLOCK_MAGIC = 'WBHC';
+static const uint32_t BLOCK_VERSION = 1;
+
+struct BlockHeader {
+	uint32_t magic;
+	uint32_t version;
+	int64_t size;		// of the resource
+	int64_t index;
+	uint32_t length;
+	uint32_t uriLength;
+};
+
+HttpCache::HttpCache(int64_t capacity)
+: mCapacity(capacity)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+HttpCache &HttpCache::instance()
+{
+	static HttpCache cache;
+	return cache;
+}
+
+string HttpCache::getName(uint64_t hash, int64_t index)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx_%lld.blk", (unsigned long long)hash, (long long)index);
+
+	return name;
+}
+
+int HttpCache::setDirectory(const string &dir)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	mLru.clear();
+	mBlocks.clear();
+	mStats.cachedBytes = 0;
+	mDirectory.clear();
+
+	string path = dir + "/http";
+	if (mkdir(path.c_str(), 0700) != 0 && errno != EEXIST) {
+		LOGE("Create %s failed %s", path.c_str(), strerror(errno));
+		return -1;
+	}
+
+	mDirectory = path;
+	scan_l();
+	evict_l();
+
+	return 0;
+}
+
+bool HttpCache::enabled() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return !mDirectory.empty();
+}
+
+void HttpCache::setCapacity(int64_t bytes)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mCapacity = bytes;
+	evict_l();
+}
+
+// rebuild the use order from the mtimes, oldest first
+void HttpCache::scan_l()
+{
+	struct Found {
+		string name;
+		uint64_t hash;
+		int64_t bytes;
+		int64_t mtimeNs;
+	};
+
+	DIR *dir = opendir(mDirectory.c_str());
+	if (!dir) {
+		return;
+	}
+
+	vector<Found> found;
+	struct dirent *entry;
+
+	while ((entry = readdir(dir)) != nullptr) {
+		string name = entry->d_name;
+		string path = mDirectory + "/" + name;
+		unsigned long long hash;
+		long long index;
+		struct stat st;
+
+		// left over by a store that did not finish
+		if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+			unlink(path.c_str());
+			continue;
+		}
+
+		if (sscanf(name.c_str(), "%16llx_%lld.blk", &hash, &index) != 2
+			|| getName(hash, index) != name
+			|| stat(path.c_str(), &st) != 0) {
+			continue;
+		}
+
+		found.push_back({name, hash, (int64_t)st.st_size,
+						 (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec});
+	}
+
+	closedir(dir);
+
+	sort(found.begin(), found.end(), [](const Found &a, const Found &b) {
+		return a.mtimeNs < b.mtimeNs;
+	});
+
+	for (const Found &f : found) {
+		insert_l(f.name, f.hash, f.bytes);
+	}
+
+	LOGD("Http cache %d blocks, %lld bytes", (int)mLru.size(), (long long)mStats.cachedBytes);
+}
+
+void HttpCache::insert_l(const string &name, uint64_t hash, int64_t bytes)
+{
+	auto found = mBlocks.find(name);
+	if (found != mBlocks.end()) {
+		// the file was replaced, only the accounting goes
+		mStats.cachedBytes -= found->second->bytes;
+		mLru.erase(found->second);
+		mBlocks.erase(found);
+	}
+
+	mLru.push_front({name, hash, bytes});
+	mBlocks[name] = mLru.begin();
+	mStats.cachedBytes += bytes;
+}
+
+void HttpCache::erase_l(list<Block>::iterator it)
+{
+	unlink((mDirectory + "/" + it->name).c_str());
+	mStats.cachedBytes -= it->bytes;
+	mBlocks.erase(it->name);
+	mLru.erase(it);
+}
+
+void HttpCache::evict_l()
+{
+	// the block just used stays, even alone over the capacity
+	while (mStats.cachedBytes > mCapacity && mLru.size() > 1) {
+		erase_l(prev(mLru.end()));
+		mStats.evictions++;
+	}
+}
+
+int HttpCache::load(const string &uri, int64_t index, uint8_t *buf, int64_t &size)
+{
+	uint64_t hash = CacheFile::hash(uri);
+	string name = getName(hash, index);
+	string path;
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+
+		if (mDirectory.empty()) {
+			return -1;
+		}
+
+		auto found = mBlocks.find(name);
+		if (found == mBlocks.end()) {
+			mStats.misses++;
+			return -1;
+		}
+
+		mLru.splice(mLru.begin(), mLru, found->second);
+		path = mDirectory + "/" + name;
+	}
+
+	// read unlocked, a block evicted meanwhile is just a miss
+	FILE *fp = fopen(path.c_str(), "rb");
+	BlockHeader header;
+	vector<char> entryUri;
+	bool valid = false;
+
+	if (fp) {
+		valid = fread(&header, sizeof(header), 1, fp) == 1
+			 && header.magic == BLOCK_MAGIC
+			 && header.version == BLOCK_VERSION
+			 && header.index == index
+			 && header.length > 0 && header.length <= (uint32_t)BLOCK_SIZE
+			 && header.uriLength == uri.size();
+
+		if (valid) {
+			entryUri.resize(header.uriLength);
+			valid = fread(entryUri.data(), 1, entryUri.size(), fp) == entryUri.size()
+				 && uri.compare(0, uri.size(), entryUri.data(), entryUri.size()) == 0
+				 && fread(buf, 1, header.length, fp) == header.length;
+		}
+
+		fclose(fp);
+	}
+
+	unique_lock<mutex> autoLock(mLock);
+
+	if (!valid) {
+		auto found = mBlocks.find(name);
+		if (found != mBlocks.end()) {
+			erase_l(found->second);
+		}
+		mStats.misses++;
+		return -1;
+	}
+
+	// the use order outlives the process
+	utimes(path.c_str(), nullptr);
+	mStats.hits++;
+	size = header.size;
+
+	return header.length;
+}
+
+int HttpCache::store(const string &uri, int64_t index, const uint8_t *buf, int length, int64_t size)
+{
+	if (length <= 0 || length > BLOCK_SIZE) {
+		return -1;
+	}
+
+	uint64_t hash = CacheFile::hash(uri);
+	string name = getName(hash, index);
+	string dir;
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+
+		if (mDirectory.empty()) {
+			return -1;
+		}
+
+		dir = mDirectory;
+	}
+
+	BlockHeader header;
+	header.magic = BLOCK_MAGIC;
+	header.version = BLOCK_VERSION;
+	header.size = size;
+	header.index = index;
+	header.length = length;
+	header.uriLength = uri.size();
+
+	string path = dir + "/" + name;
+	int ret = CacheFile::writeAtomic(path, [&](FILE *fp) {
+		return fwrite(&header, sizeof(header), 1, fp) == 1
+			&& fwrite(uri.data(), 1, uri.size(), fp) == uri.size()
+			&& fwrite(buf, 1, length, fp) == (size_t)length;
+	});
+
+	if (ret < 0) {
+		return -1;
+	}
+
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mDirectory != dir) {
+		unlink(path.c_str());
+		return -1;
+	}
+
+	insert_l(name, hash, sizeof(header) + uri.size() + length);
+	mStats.stores++;
+	evict_l();
+
+	return 0;
+}
+
+void HttpCache::remove(const string &uri)
+{
+	unique_lock<mutex> autoLock(mLock);
+	uint64_t hash = CacheFile::hash(uri);
+
+	for (auto it = mLru.begin(); it != mLru.end(); ) {
+		auto next = std::next(it);
+		if (it->hash == hash) {
+			erase_l(it);
+		}
+		it = next;
+	}
+}
+
+void HttpCache::clear()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	while (!mLru.empty()) {
+		erase_l(mLru.begin());
+	}
+}
+
+HttpCache::Stats HttpCache::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	Stats stats = mStats;
+	stats.blocks = mLru.size();
+
+	return stats;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * HttpCache.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_HTTPCACHE_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_HTTPCACHE_H_
+
+#include <stdint.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace whitebean {
+
+/*
+ * Byte ranges of HTTP resources kept on disk, in fixed size blocks at
+ * block aligned offsets, one file per block under <dir>/http. Only the
+ * blocks that were fetched are there, so a resource can be cached in
+ * parts. Each block holds the uri and the size of the resource it was
+ * fetched from, a resource found at another size is dropped. When the
+ * blocks add up to more than the capacity the least recently used go
+ * first; the use order is kept in the block mtimes and read back when the
+ * directory is set. Without a directory every lookup is a miss.
+ */
+class HttpCache {
+public:
+	struct Stats {
+		int hits;
+		int misses;
+		int stores;
+		int evictions;
+		int blocks;
+		int64_t cachedBytes;
+	};
+
+	static const int BLOCK_SIZE = 256 * 1024;
+	static const int64_t DEFAULT_CAPACITY = 256 * 1024 * 1024;
+
+	explicit HttpCache(int64_t capacity = DEFAULT_CAPACITY);
+
+	// shared by the players of the process
+	static HttpCache &instance();
+
+	/*
+	 * Blocks already under dir are taken over
+	 */
+	int setDirectory(const std::string &dir);
+
+	bool enabled() const;
+
+	// evicts right away when lowered
+	void setCapacity(int64_t bytes);
+
+	/*
+	 * Copy block index of uri into buf, BLOCK_SIZE bytes. Returns its
+	 * length, short only for the last block, or -1 on a miss. size is set
+	 * to the resource size, -1 if the server did not tell.
+	 */
+	int load(const std::string &uri, int64_t index, uint8_t *buf, int64_t &size);
+
+	int store(const std::string &uri, int64_t index, const uint8_t *buf, int length, int64_t size);
+
+	/*
+	 * Drop the blocks of uri, for a resource that changed
+	 */
+	void remove(const std::string &uri);
+
+	void clear();
+
+	Stats getStats() const;
+
+private:
+	struct Block {
+		std::string name;
+		uint64_t hash;
+		int64_t bytes;		// on disk
+	};
+
+	HttpCache(const HttpCache &) = delete;
+	HttpCache &operator=(const HttpCache &) = delete;
+
+	std::string getName(uint64_t hash, int64_t index);
+	void scan_l();
+	void insert_l(const std::string &name, uint64_t hash, int64_t bytes);
+	void erase_l(std::list<Block>::iterator it);
+	void evict_l();
+
+	mutable std::mutex mLock;
+	std::string mDirectory;
+	int64_t mCapacity;
+
+	// most recently used first
+	std::list<Block> mLru;
+	std::unordered_map<std::string, std::list<Block>::iterator> mBlocks;
+	Stats mStats;
+};
+
+}
+
+#endif
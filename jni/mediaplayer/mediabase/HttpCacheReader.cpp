@@ -0,0 +1,261 @@
+/*
+ * HttpCacheReader.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "log.hpp"
+#include "HttpCacheReader.hpp"
+#include "Clock.hpp"
+
+extern "C" {
+#include "libavutil/dict.h"
+}
+
+using namespace std;
+
+namespace whitebean {
+
+HttpCacheReader::HttpCacheReader(HttpCache &cache)
+: mCache(cache)
+, mSize(-1)
+, mHaveSize(false)
+, mPos(0)
+, mIO(nullptr)
+, mIOPos(-1)
+, mInterrupted(false)
+, mBlockIndex(-1)
+, mBlockLength(0)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+HttpCacheReader::~HttpCacheReader()
+{
+	close();
+}
+
+bool HttpCacheReader::isHttp(const string &uri)
+{
+	return uri.compare(0, 7, "http://") == 0 || uri.compare(0, 8, "https://") == 0;
+}
+
+int HttpCacheReader::open(const string &uri)
+{
+	close();
+
+	mUri = uri;
+	mInterrupted = false;
+	mBlock.resize(HttpCache::BLOCK_SIZE);
+
+	// a replay starts from the cache without asking the server
+	int64_t size;
+	int len = mCache.load(uri, 0, mBlock.data(), size);
+	if (len > 0) {
+		countCached();
+		mBlockIndex = 0;
+		mBlockLength = len;
+		mSize = size;
+		mHaveSize = true;
+		return 0;
+	}
+
+	return connect(0);
+}
+
+void HttpCacheReader::close()
+{
+	disconnect();
+	mUri.clear();
+	mSize = -1;
+	mHaveSize = false;
+	mPos = 0;
+	mBlockIndex = -1;
+	mBlockLength = 0;
+}
+
+void HttpCacheReader::interrupt()
+{
+	mInterrupted = true;
+}
+
+HttpCacheReader::Stats HttpCacheReader::getStats() const
+{
+	unique_lock<mutex> autoLock(mStatsLock);
+	return mStats;
+}
+
+void HttpCacheReader::countCached()
+{
+	unique_lock<mutex> autoLock(mStatsLock);
+	mStats.cachedBlocks++;
+}
+
+int HttpCacheReader::interruptCallback(void *opaque)
+{
+	return ((HttpCacheReader *)opaque)->mInterrupted ? 1 : 0;
+}
+
+int HttpCacheReader::connect(int64_t pos)
+{
+	disconnect();
+
+	AVDictionary *opts = nullptr;
+	av_dict_set_int(&opts, "offset", pos, 0);
+	av_dict_set_int(&opts, "rw_timeout", DEFAULT_TIMEOUT_US, 0);
+
+	AVIOInterruptCB cb = {interruptCallback, this};
+	int ret = avio_open2(&mIO, mUri.c_str(), AVIO_FLAG_READ, &cb, &opts);
+	av_dict_free(&opts);
+
+	if (ret < 0) {
+		LOGE("Connect %s at %lld failed %d", mUri.c_str(), (long long)pos, ret);
+		mIO = nullptr;
+		return -1;
+	}
+
+	{
+		unique_lock<mutex> autoLock(mStatsLock);
+		mStats.connects++;
+	}
+	mIOPos = pos;
+
+	int64_t size = avio_size(mIO);
+	if (size < 0) {
+		size = -1;
+	}
+
+	// the resource changed since it was cached, none of it is any good
+	if (mHaveSize && size != mSize) {
+		LOGD("%s size %lld, was %lld", mUri.c_str(), (long long)size, (long long)mSize);
+		mCache.remove(mUri);
+		mBlockIndex = -1;
+	}
+
+	mSize = size;
+	mHaveSize = true;
+
+	return 0;
+}
+
+void HttpCacheReader::disconnect()
+{
+	if (mIO) {
+		avio_closep(&mIO);
+	}
+	mIOPos = -1;
+}
+
+int HttpCacheReader::read(uint8_t *buf, int size)
+{
+	if (mInterrupted) {
+		return -1;
+	}
+
+	if (size <= 0 || (mSize >= 0 && mPos >= mSize)) {
+		return 0;
+	}
+
+	int64_t index = mPos / HttpCache::BLOCK_SIZE;
+	if (index != mBlockIndex && loadBlock(index) < 0) {
+		return -1;
+	}
+
+	// a short block is the last one
+	int offset = mPos - index * HttpCache::BLOCK_SIZE;
+	if (offset >= mBlockLength) {
+		return 0;
+	}
+
+	int n = min(size, mBlockLength - offset);
+	memcpy(buf, mBlock.data() + offset, n);
+	mPos += n;
+
+	return n;
+}
+
+int64_t HttpCacheReader::seek(int64_t pos)
+{
+	if (pos < 0) {
+		return -1;
+	}
+
+	// nothing is fetched until the next read
+	mPos = pos;
+
+	return pos;
+}
+
+int HttpCacheReader::loadBlock(int64_t index)
+{
+	int64_t size;
+	int len = mCache.load(mUri, index, mBlock.data(), size);
+
+	if (len > 0 && size == mSize) {
+		countCached();
+		mBlockIndex = index;
+		mBlockLength = len;
+		return 0;
+	}
+
+	return fetchBlock(index);
+}
+
+int HttpCacheReader::fetchBlock(int64_t index)
+{
+	int64_t start = index * HttpCache::BLOCK_SIZE;
+
+	mBlockIndex = -1;
+
+	if (mIOPos != start && connect(start) < 0) {
+		return -1;
+	}
+
+	auto fetchStart = chrono::steady_clock::now();
+	int len = 0;
+
+	while (len < HttpCache::BLOCK_SIZE) {
+		int n = avio_read(mIO, mBlock.data() + len, HttpCache::BLOCK_SIZE - len);
+		if (n == AVERROR_EOF || n == 0) {
+			break;
+		}
+
+		if (n < 0) {
+			LOGE("Read %s at %lld failed %d", mUri.c_str(), (long long)(start + len), n);
+			disconnect();
+			return -1;
+		}
+
+		len += n;
+	}
+
+	mIOPos = start + len;
+	{
+		unique_lock<mutex> autoLock(mStatsLock);
+		mStats.fetchUs += elapsedUs(fetchStart);
+		mStats.fetchedBytes += len;
+		if (len > 0) {
+			mStats.fetchedBlocks++;
+		}
+	}
+
+	mBlockIndex = index;
+	mBlockLength = len;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	// a short block is only kept as the known end of the resource, it could
+	// have been cut short by the server too
+	if (len == HttpCache::BLOCK_SIZE || (mSize >= 0 && start + len == mSize)) {
+		mCache.store(mUri, index, mBlock.data(), len, mSize);
+	}
+
+	return 0;
+}
+
+}
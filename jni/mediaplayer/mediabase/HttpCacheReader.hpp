@@ -0,0 +1,103 @@
+/*
+ * HttpCacheReader.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_HTTPCACHEREADER_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_HTTPCACHEREADER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ByteReader.hpp"
+#include "HttpCache.hpp"
+
+extern "C" {
+#include "libavformat/avio.h"
+}
+
+namespace whitebean {
+
+/*
+ * Reads an http(s) resource a cache block at a time, from the HttpCache
+ * when the block is there and from the server otherwise, storing what it
+ * fetched. The connection is opened at the first missing block and kept
+ * while the misses follow each other, a jump opens a new one at the block
+ * with a range request. A resource whose first block is cached is opened
+ * without connecting at all. Reading ahead is left to a PrefetchReader on
+ * top, which makes the fetches and the cache writes run off the demux
+ * thread.
+ */
+class HttpCacheReader: public ByteReader {
+public:
+	struct Stats {
+		int cachedBlocks;		// served from the cache
+		int fetchedBlocks;		// from the server
+		int connects;
+		int64_t fetchedBytes;
+		int64_t fetchUs;
+	};
+
+	// a stalled connection fails after this long
+	static const int64_t DEFAULT_TIMEOUT_US = 10000000;
+
+	explicit HttpCacheReader(HttpCache &cache = HttpCache::instance());
+	virtual ~HttpCacheReader();
+
+	static bool isHttp(const std::string &uri);
+
+	int open(const std::string &uri);
+	void close();
+
+	/*
+	 * Fail the read in progress and any after it, from any thread
+	 */
+	void interrupt();
+
+	virtual int read(uint8_t *buf, int size) override;
+	virtual int64_t seek(int64_t pos) override;
+	virtual int64_t tell() const override {
+		return mPos;
+	}
+	virtual int64_t size() const override {
+		return mSize;
+	}
+
+	// safe while the reader runs on a prefetch thread
+	Stats getStats() const;
+
+private:
+	HttpCacheReader(const HttpCacheReader &) = delete;
+	HttpCacheReader &operator=(const HttpCacheReader &) = delete;
+
+	static int interruptCallback(void *opaque);
+	int connect(int64_t pos);
+	void disconnect();
+	int loadBlock(int64_t index);
+	void countCached();
+	int fetchBlock(int64_t index);
+
+	HttpCache &mCache;
+	std::string mUri;
+	int64_t mSize;
+	bool mHaveSize;		// from the cache or a connection
+	int64_t mPos;
+
+	AVIOContext *mIO;
+	int64_t mIOPos;
+	std::atomic<bool> mInterrupted;
+
+	std::vector<uint8_t> mBlock;
+	int64_t mBlockIndex;
+	int mBlockLength;
+
+	mutable std::mutex mStatsLock;
+	Stats mStats;
+};
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * KeyframeIndex.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <algorithm>
+#include "log.hpp"
+#include "KeyframeIndex.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+static const uint32_t MAX_ENTRIES = 1 << 22;
+
+static bool entryBefore(const KeyframeIndex::Entry &entry, int64_t ts)
+{
+	return entry.ts < ts;
+}
+
+void KeyframeIndex::addPacket(int64_t ts, int64_t pos, bool key)
+{
+	if (ts < 0) {
+		return;
+	}
+
+	if (key) {
+		if (mSpanStart < 0) {
+			mSpanStart = ts;
+		}
+
+		if (pos >= 0) {
+			auto it = lower_bound(mEntries.begin(), mEntries.end(), ts, entryBefore);
+			if (it == mEntries.end() || it->ts != ts) {
+				mEntries.insert(it, Entry{ts, pos});
+				mDirty = true;
+			}
+		}
+	}
+
+	if (mSpanStart >= 0 && ts > mSpanEnd) {
+		mSpanEnd = ts;
+	}
+}
+
+void KeyframeIndex::closeSpan()
+{
+	if (mSpanStart < 0 || mSpanEnd < mSpanStart) {
+		mSpanStart = mSpanEnd = -1;
+		return;
+	}
+
+	pair<int64_t, int64_t> span(mSpanStart, mSpanEnd);
+	vector<pair<int64_t, int64_t> > merged;
+
+	for (auto &s : mSpans) {
+		if (s.second < span.first || s.first > span.second) {
+			merged.push_back(s);
+		} else {
+			span.first = min(span.first, s.first);
+			span.second = max(span.second, s.second);
+		}
+	}
+
+	merged.push_back(span);
+	sort(merged.begin(), merged.end());
+	mSpans.swap(merged);
+
+	mSpanStart = mSpanEnd = -1;
+	mDirty = true;
+}
+
+void KeyframeIndex::discontinuity()
+{
+	closeSpan();
+}
+
+bool KeyframeIndex::lookup(int64_t ts, Entry &entry) const
+{
+	bool covered = mSpanStart >= 0 && ts >= mSpanStart && ts <= mSpanEnd;
+
+	for (size_t i = 0; !covered && i < mSpans.size(); ++i) {
+		covered = ts >= mSpans[i].first && ts <= mSpans[i].second;
+	}
+
+	if (!covered) {
+		return false;
+	}
+
+	auto it = upper_bound(mEntries.begin(), mEntries.end(), ts,
+						  [](int64_t t, const Entry &e) { return t < e.ts; });
+	if (it == mEntries.begin()) {
+		return false;
+	}
+
+	entry = *(--it);
+
+	return true;
+}
+
+void KeyframeIndex::setEntries(const vector<Entry> &entries)
+{
+	mEntries = entries;
+	sort(mEntries.begin(), mEntries.end(),
+		 [](const Entry &a, const Entry &b) { return a.ts < b.ts; });
+	mDirty = true;
+}
+
+int KeyframeIndex::write(FILE *fp)
+{
+	closeSpan();
+
+	uint32_t counts[3] = {(uint32_t)mMode, (uint32_t)mEntries.size(), (uint32_t)mSpans.size()};
+
+	if (fwrite(counts, sizeof(counts), 1, fp) != 1
+		|| fwrite(mEntries.data(), sizeof(Entry), mEntries.size(), fp) != mEntries.size()) {
+		return -1;
+	}
+
+	for (auto &s : mSpans) {
+		int64_t span[2] = {s.first, s.second};
+		if (fwrite(span, sizeof(span), 1, fp) != 1) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int KeyframeIndex::read(FILE *fp)
+{
+	uint32_t counts[3];
+
+	if (fread(counts, sizeof(counts), 1, fp) != 1 || counts[1] > MAX_ENTRIES || counts[2] > MAX_ENTRIES) {
+		return -1;
+	}
+
+	vector<Entry> entries(counts[1]);
+	vector<pair<int64_t, int64_t> > spans;
+
+	if (fread(entries.data(), sizeof(Entry), entries.size(), fp) != entries.size()) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < counts[2]; ++i) {
+		int64_t span[2];
+		if (fread(span, sizeof(span), 1, fp) != 1) {
+			return -1;
+		}
+		spans.push_back(make_pair(span[0], span[1]));
+	}
+
+	mMode = counts[0];
+	mEntries.swap(entries);
+	mSpans.swap(spans);
+	mSpanStart = mSpanEnd = -1;
+	mDirty = false;
+
+	return 0;
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+ * KeyframeIndex.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_KEYFRAMEINDEX_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_KEYFRAMEINDEX_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <utility>
+#include <vector>
+
+namespace whitebean {
+
+/*
+ * Keyframe timestamps and byte offsets of one stream, collected while its
+ * packets are demuxed. Only stretches that were demuxed without a jump are
+ * complete, so lookups only succeed inside such a span: there the nearest
+ * keyframe before the timestamp is known to be the right one.
+ *
+ * MODE_BYTES entries are packet offsets to seek to with AVSEEK_FLAG_BYTE,
+ * for formats that otherwise seek by scanning (MPEG-TS, raw streams).
+ * MODE_DEMUXER entries are a copy of the index the demuxer builds itself
+ * (e.g. Matroska without cues), given back to it on the next open.
+ */
+class KeyframeIndex {
+public:
+	enum {
+		MODE_NONE,
+		MODE_BYTES,
+		MODE_DEMUXER,
+	};
+
+	struct Entry {
+		int64_t ts;		// in stream time base
+		int64_t pos;
+	};
+
+	KeyframeIndex(): mMode(MODE_NONE), mSpanStart(-1), mSpanEnd(-1), mDirty(false) {}
+
+	void setMode(int mode) {
+		mMode = mode;
+	}
+
+	int getMode() const {
+		return mMode;
+	}
+
+	/*
+	 * A demuxed packet of the indexed stream
+	 */
+	void addPacket(int64_t ts, int64_t pos, bool key);
+
+	/*
+	 * The next packet does not follow the last one, after a seek
+	 */
+	void discontinuity();
+
+	/*
+	 * Keyframe at or before ts, if ts lies in a span demuxed in one go
+	 */
+	bool lookup(int64_t ts, Entry &entry) const;
+
+	/*
+	 * Replace the entries, for MODE_DEMUXER snapshots
+	 */
+	void setEntries(const std::vector<Entry> &entries);
+
+	const std::vector<Entry> &getEntries() const {
+		return mEntries;
+	}
+
+	bool isDirty() const {
+		return mDirty;
+	}
+
+	void clearDirty() {
+		mDirty = false;
+	}
+
+	int write(FILE *fp);
+	int read(FILE *fp);
+
+private:
+	void closeSpan();
+
+	int mMode;
+	std::vector<Entry> mEntries;	// sorted by ts
+	std::vector<std::pair<int64_t, int64_t> > mSpans;	// sorted, disjoint
+	int64_t mSpanStart;		// span being demuxed, from its first keyframe
+	int64_t mSpanEnd;
+	bool mDirty;
+};
+
+}
+
+#endif
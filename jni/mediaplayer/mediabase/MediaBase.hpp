@@ -39,7 +39,7 @@ public:
 	virtual ~IMediaListener() {}
 
 	enum MESSAGE {
-		SOURCE_SEEK_COMPLETE = 0,
+		SOURCE_SEEK_COMPLETE = 0,	// arg1 0, or -1 if the seek failed
 		DECODER_CLEAR_COMPLETE,
 	};
 
@@ -60,6 +60,8 @@ public:
 	    EVENT_SEEK,
 		EVENT_CLEAR,
 		EVENT_EXIT,
+		EVENT_SUSPEND,
+		EVENT_WAKEUP,
 		EVENT_NUM,
 	};
 
@@ -44,6 +44,9 @@ int Codec::open_l()
 
 	LOGD("Video/Audio codec id %d", mCodecPtr->codec_id);
 
+	// let decoded frames be referenced instead of copied
+	mCodecPtr->refcounted_frames = 1;
+
 	if (avcodec_open2(mCodecPtr.get(), codec, NULL) < 0) {
 		LOGE("open decoder failed");
 		return -1;
@@ -69,8 +72,13 @@ int Codec::stop()
 	return 0;
 }	
 
-void Codec::clear()
+void Codec::clear(int64_t targetUs)
 {
+	{
+		unique_lock<mutex> autoLock(mBaseLock);
+		mPendingSeekTargetUs = targetUs;
+	}
+
 	mQueue.postEvent(mEvents[EVENT_CLEAR]);
 }
 
@@ -80,7 +88,118 @@ void Codec::clear_l()
 		mFrameQueue.pop();
 	}
 
-	avcodec_flush_buffers(mCodecPtr.get());
+	{
+		unique_lock<mutex> autoLock(mBaseLock);
+		mEos = false;
+	}
+
+	if (!mSuspended) {
+		avcodec_flush_buffers(mCodecPtr.get());
+	}
+}
+
+void Codec::suspend()
+{
+	mQueue.postEvent(mEvents[EVENT_SUSPEND]);
+}
+
+void Codec::wakeUp()
+{
+	mQueue.postEvent(mEvents[EVENT_WAKEUP]);
+}
+
+void Codec::applySkipFrame()
+{
+	int skip, skipLoopFilter;
+
+	{
+		unique_lock<mutex> autoLock(mBaseLock);
+		skip = mSkipFrame;
+		skipLoopFilter = mSkipLoopFilter;
+	}
+
+	mCodecPtr->skip_loop_filter = (enum AVDiscard)skipLoopFilter;
+
+	if (mCodecPtr->skip_frame == skip) {
+		return;
+	}
+
+	if (skip < mCodecPtr->skip_frame) {
+		mWaitKeyFrame = true;
+	}
+
+	LOGD("Skip frame %d -> %d", mCodecPtr->skip_frame, skip);
+	mCodecPtr->skip_frame = (enum AVDiscard)skip;
+}
+
+bool Codec::beforeSeekTarget(const FrameBuffer &frmbuf)
+{
+	if (mSeekTargetUs < 0) {
+		return false;
+	}
+
+	const AVFrame *frame = frmbuf.getDataPtr();
+	if (frame->pkt_pts == AV_NOPTS_VALUE) {
+		return false;
+	}
+
+	// the frame shown at the target is the one whose duration covers it
+	AVRational time_base = mSource->getTimeScaleOfTrack(mStreamId);
+	int64_t endPts = frame->pkt_pts + av_frame_get_pkt_duration(frame);
+	if (av_rescale_q(endPts, time_base, AV_TIME_BASE_Q) <= mSeekTargetUs) {
+		countDiscarded();
+		return true;
+	}
+
+	mSeekTargetUs = -1;
+
+	return false;
+}
+
+void Codec::countDiscarded()
+{
+	unique_lock<mutex> autoLock(mBaseLock);
+	mDiscardedFrames++;
+}
+
+bool Codec::afterEndTarget(const FrameBuffer &frmbuf)
+{
+	int64_t endUs;
+
+	{
+		unique_lock<mutex> autoLock(mBaseLock);
+		endUs = mEndTargetUs;
+	}
+
+	const AVFrame *frame = frmbuf.getDataPtr();
+	if (endUs < 0 || frame->pkt_pts == AV_NOPTS_VALUE) {
+		return false;
+	}
+
+	// a frame starting at the end target is not shown any more
+	AVRational time_base = mSource->getTimeScaleOfTrack(mStreamId);
+	if (av_rescale_q(frame->pkt_pts, time_base, AV_TIME_BASE_Q) < endUs) {
+		return false;
+	}
+
+	setEos();
+
+	return true;
+}
+
+bool Codec::reachedEos() const
+{
+	unique_lock<mutex> autoLock(mBaseLock);
+	return mEos;
+}
+
+void Codec::setEos()
+{
+	unique_lock<mutex> autoLock(mBaseLock);
+	if (!mEos) {
+		LOGD("Decoder %d reached the end of stream", mStreamId);
+		mEos = true;
+	}
 }
 
 void Codec::timeScaleToUs(FrameBuffer &frmbuf)
@@ -101,10 +220,18 @@ void Codec::initEvents()
 															  this, &Codec::onClearEvent));	
 	mEvents[EVENT_EXIT] = shared_ptr<TimedEventQueue::Event> (new MediaEvent<Codec>(
 															  this, &Codec::onExitEvent));
+	mEvents[EVENT_SUSPEND] = shared_ptr<TimedEventQueue::Event> (new MediaEvent<Codec>(
+															  this, &Codec::onSuspendEvent));
+	mEvents[EVENT_WAKEUP] = shared_ptr<TimedEventQueue::Event> (new MediaEvent<Codec>(
+															  this, &Codec::onWakeUpEvent));
 }
 	
 void Codec::onWaitEvent()
 {
+	if (mSuspended) {
+		return;
+	}
+
 	if (waiting()) {
 		this_thread::sleep_for(chrono::milliseconds(10));		
 		mQueue.postEvent(mEvents[EVENT_WAIT]);
@@ -131,6 +258,11 @@ void Codec::onClearEvent()
 	
 	clear_l();
 
+	{
+		unique_lock<mutex> autoLock(mBaseLock);
+		mSeekTargetUs = mPendingSeekTargetUs;
+	}
+
 	halt();
 	mQueue.postEvent(mEvents[EVENT_WAIT]);
 	
@@ -142,8 +274,49 @@ void Codec::onExitEvent()
 
 }
 
-AudioDecoder::AudioDecoder()
+void Codec::onSuspendEvent()
+{
+	if (mSuspended) {
+		return;
+	}
+
+	mQueue.cancelEvent(mEvents[EVENT_WAIT]->eventID());
+	mQueue.cancelEvent(mEvents[EVENT_WORK]->eventID());
+
+	clear_l();
+
+	// closing frees the buffer pools once the queued frames are gone
+	avcodec_close(mCodecPtr.get());
+	mSuspended = true;
+
+	LOGD("Decoder %d suspended", mStreamId);
+}
+
+void Codec::onWakeUpEvent()
+{
+	if (!mSuspended) {
+		return;
+	}
+
+	AVCodec *codec = avcodec_find_decoder(mCodecPtr->codec_id);
+	if (!codec || avcodec_open2(mCodecPtr.get(), codec, NULL) < 0) {
+		LOGE("Reopen decoder %d failed", mStreamId);
+		return;
+	}
+
+	mSuspended = false;
+
+	// the packets after the wake up start anywhere in a GOP
+	mWaitKeyFrame = true;
+
+	LOGD("Decoder %d woken up", mStreamId);
+
+	mQueue.postEvent(mEvents[EVENT_WAIT]);
+}
+
+AudioDecoder::AudioDecoder(int outSampleRate)
 : mSampleRate(0)
+, mOutSampleRate(outSampleRate)
 , mChannels(0)
 , mSampleFmt(0)
 {
@@ -163,7 +336,11 @@ int AudioDecoder::open(shared_ptr<MediaSource> source)
 	mSampleRate = mCodecPtr->sample_rate;
 	mSampleFmt = mCodecPtr->sample_fmt;
 
-	mMetaData.setInt32(kKeySampleRate, mSampleRate);
+	if (mOutSampleRate <= 0) {
+		mOutSampleRate = mSampleRate;
+	}
+
+	mMetaData.setInt32(kKeySampleRate, mOutSampleRate);
 		
 	if (initFilters() < 0) {
 		LOGE("Init filters failed");
@@ -195,7 +372,7 @@ int AudioDecoder::initFilters()
     AVFilterInOut *inputs  = avfilter_inout_alloc();
     static const enum AVSampleFormat out_sample_fmts[] = { AV_SAMPLE_FMT_S16, static_cast<AVSampleFormat>(-1) };
     static const int64_t out_channel_layouts[] = { AV_CH_LAYOUT_MONO, AV_CH_LAYOUT_STEREO, -1 };
-    static const int out_sample_rates[] = { mSampleRate, -1 };
+    const int out_sample_rates[] = { mOutSampleRate, -1 };
     AVRational time_base = mAVFmtCtxPtr->streams[mStreamId]->time_base;
 	
 	mFilterCtx.filterGraph = shared_ptr<AVFilterGraph>(avfilter_graph_alloc(),
@@ -257,7 +434,7 @@ int AudioDecoder::initFilters()
 	//args is reused
 	snprintf(args, sizeof(args),
 			 "aresample=%d,aformat=sample_fmts=s16:channel_layouts=stereo",
-			 mSampleRate);
+			 mOutSampleRate);
 	LOGD("audio filter output desc %s", args);
     if ((ret = avfilter_graph_parse_ptr(mFilterCtx.filterGraph.get(), args,
                                         &inputs, &outputs, NULL)) < 0) {
@@ -287,9 +464,21 @@ int AudioDecoder::decode()
 		return ERR_AGAIN;
 	}
 
+	// at the end target, nothing more until the next clear
+	if (reachedEos()) {
+		this_thread::sleep_for(chrono::milliseconds(10));
+		return ERR_AGAIN;
+	}
+
+	// taken before the read, the packets are all queued once it is set
+	bool eof = mSource->eof();
+
 	PacketBuffer pktbuf;
 	if (!mTracksPtr->readAudio(pktbuf) || pktbuf.empty()) {
 		LOGD("Audio decoder read packet failed");
+		if (eof) {
+			setEos();
+		}
 		this_thread::sleep_for(chrono::milliseconds(10));
 		return ERR_AGAIN;
 	}
@@ -328,14 +517,94 @@ int AudioDecoder::decode()
 	LOGD("Audio filter frame success");
 
 	timeScaleToUs(filtfrmbuf);
+	if (!trimToSeekTarget(filtfrmbuf) || !trimToEndTarget(filtfrmbuf)) {
+		return 0;
+	}
+
 	mFrameQueue.push(filtfrmbuf);	
 	
 	return 0;
 }
 
+bool AudioDecoder::trimToSeekTarget(FrameBuffer &frmbuf)
+{
+	if (mSeekTargetUs < 0) {
+		return true;
+	}
+
+	AVFrame *frame = frmbuf.getDataPtr();
+	int64_t skip = av_rescale(mSeekTargetUs - frmbuf.getPts(), frame->sample_rate, US_IN_SECOND);
+
+	if (skip >= frame->nb_samples) {
+		countDiscarded();
+		return false;
+	}
+
+	if (skip > 0) {
+		// start the frame at the target sample, the buffer is only
+		// referenced, so moving the plane pointers is enough
+		enum AVSampleFormat format = (enum AVSampleFormat)frame->format;
+		int channels = av_frame_get_channels(frame);
+		int planar = av_sample_fmt_is_planar(format);
+		int planes = planar ? channels : 1;
+		int offset = skip * av_get_bytes_per_sample(format) * (planar ? 1 : channels);
+
+		for (int i = 0; i < planes; ++i) {
+			frame->extended_data[i] += offset;
+		}
+		if (frame->extended_data != frame->data) {
+			for (int i = 0; i < planes && i < AV_NUM_DATA_POINTERS; ++i) {
+				frame->data[i] += offset;
+			}
+		}
+
+		frame->nb_samples -= skip;
+		frmbuf.setPts(mSeekTargetUs);
+	}
+
+	mSeekTargetUs = -1;
+
+	return true;
+}
+
+/*
+ * Cut the frame at the end target sample, the last one queued before eos
+ */
+bool AudioDecoder::trimToEndTarget(FrameBuffer &frmbuf)
+{
+	int64_t endUs;
+
+	{
+		unique_lock<mutex> autoLock(mBaseLock);
+		endUs = mEndTargetUs;
+	}
+
+	if (endUs < 0) {
+		return true;
+	}
+
+	AVFrame *frame = frmbuf.getDataPtr();
+	int64_t keep = av_rescale(endUs - frmbuf.getPts(), frame->sample_rate, US_IN_SECOND);
+
+	if (keep >= frame->nb_samples) {
+		return true;
+	}
+
+	setEos();
+
+	if (keep <= 0) {
+		return false;
+	}
+
+	frame->nb_samples = keep;
+
+	return true;
+}
+
 VideoDecoder::VideoDecoder()
 : mWidth(0)
 , mHeight(0)  
+, mPassThrough(false)
 {
 
 }
@@ -353,14 +622,40 @@ int VideoDecoder::open(shared_ptr<MediaSource> source)
 	mWidth = mCodecPtr->width;
 	mHeight = mCodecPtr->height;
 
+	int pano = 0;
+	mSource->getFormat()->findInt32(kKeyPanoramic, pano);
+
+	mPassThrough = isRenderableFormat(mCodecPtr->pix_fmt, pano);
+	if (mPassThrough) {
+		LOGD("Render pixel format %d directly", mCodecPtr->pix_fmt);
+		mMetaData.setInt32(kKeyColorFormat, mCodecPtr->pix_fmt);
+		return 0;
+	}
+
 	if (initFilters() < 0) {
 		LOGD("Init video filter failed");
 		return -1;
 	}
 
+	mMetaData.setInt32(kKeyColorFormat, AV_PIX_FMT_YUV420P);
+
 	return 0;
 }
 
+bool VideoDecoder::isRenderableFormat(int format, bool panoramic)
+{
+	switch (format) {
+	case AV_PIX_FMT_YUV420P:
+		return true;
+	case AV_PIX_FMT_NV12:
+	case AV_PIX_FMT_NV21:
+	case AV_PIX_FMT_YUV420P10LE:
+		return !panoramic;
+	default:
+		return false;
+	}
+}
+
 bool VideoDecoder::read(FrameBuffer &frmbuf)
 {
 	if (mFrameQueue.empty()) {
@@ -387,15 +682,35 @@ int VideoDecoder::decode()
 		return ERR_AGAIN;
 	}
 
+	// drained already, nothing left to do until the next clear
+	if (reachedEos()) {
+		this_thread::sleep_for(chrono::milliseconds(10));
+		return ERR_AGAIN;
+	}
+
+	bool eof = mSource->eof();
+	bool draining = false;
+
 	PacketBuffer pktbuf;
 	if (!mTracksPtr->readVideo(pktbuf) || pktbuf.empty()) {
 		LOGD("Video decoder read packet failed");
-		this_thread::sleep_for(chrono::milliseconds(10));
-		return ERR_AGAIN;
+		if (!eof) {
+			this_thread::sleep_for(chrono::milliseconds(10));
+			return ERR_AGAIN;
+		}
+
+		// out of packets at the end of the file, empty packets drain the
+		// frames the codec holds back for reordering
+		AVPacket *pkt = pktbuf.getDataPtr();
+		pkt->data = NULL;
+		pkt->size = 0;
+		draining = true;
 	}
 
 	LOGD("Audio decoder read packet ok");
 
+	applySkipFrame();
+
 	FrameBuffer frmbuf, filtfrmbuf;
 
 	ret = avcodec_decode_video2(mCodecPtr.get(), frmbuf.getDataPtr(), &gotframe, pktbuf.getDataPtr());
@@ -404,12 +719,40 @@ int VideoDecoder::decode()
 		return ERR_AGAIN;
 	}
 	if (!gotframe) {
+		if (draining) {
+			setEos();
+			return ERR_AGAIN;
+		}
 		LOGE("Video decode failed");
 		return ERR_AGAIN;
 	}
 
 	LOGD("Video decoder frame success");
 
+	if (mWaitKeyFrame) {
+		if (!frmbuf.getDataPtr()->key_frame) {
+			return 0;
+		}
+		mWaitKeyFrame = false;
+	}
+
+	// decoded only as a reference for the frames up to the seek target
+	if (beforeSeekTarget(frmbuf) || afterEndTarget(frmbuf)) {
+		return 0;
+	}
+
+	if (mPassThrough && frmbuf.getFormat() == mCodecPtr->pix_fmt) {
+		timeScaleToUs(frmbuf);
+		mFrameQueue.push(frmbuf);
+		return 0;
+	}
+
+	// format changed midstream, convert from here on
+	if (!mFilterCtx.filterGraph && initFilters() < 0) {
+		LOGE("Init video filter failed");
+		return ERR_INVALID;
+	}
+
 	if (av_buffersrc_add_frame_flags(mFilterCtx.bufferSrcCtx, frmbuf.getDataPtr(), 0) < 0) {
 		LOGE("Error while feeding the audio filtergraph");
 		return ERR_INVALID;
@@ -433,7 +776,8 @@ int VideoDecoder::decode()
 	return 0;
 }	
 
-int VideoDecoder::initFilters()
+int initVideoFilters(FilterContext &filterCtx, AVCodecContext *codec,
+					 int width, int height, int format)
 {
 	char args[512];
     int ret = 0;
@@ -441,11 +785,11 @@ int VideoDecoder::initFilters()
     AVFilter *vbuffersink = avfilter_get_by_name("buffersink");
     AVFilterInOut *outputs = avfilter_inout_alloc();
     AVFilterInOut *inputs  = avfilter_inout_alloc();
-	enum AVPixelFormat pix_fmts[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NONE };
+	enum AVPixelFormat pix_fmts[] = { (enum AVPixelFormat)format, AV_PIX_FMT_NONE };
 
-	mFilterCtx.filterGraph = shared_ptr<AVFilterGraph>(avfilter_graph_alloc(),
+	filterCtx.filterGraph = shared_ptr<AVFilterGraph>(avfilter_graph_alloc(),
 											 [](AVFilterGraph *p){avfilter_graph_free(&p);});
-    if (!inputs || !outputs || !mFilterCtx.filterGraph) {
+    if (!inputs || !outputs || !filterCtx.filterGraph) {
     	LOGE("Alloc filter graph failed");
 		ret = -1;
     	goto end;
@@ -453,29 +797,29 @@ int VideoDecoder::initFilters()
 
 	snprintf(args, sizeof(args),
              "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
-			 mCodecPtr->width, mCodecPtr->height,
-			 mCodecPtr->pix_fmt,
-			 mCodecPtr->time_base.num,
-			 mCodecPtr->time_base.den,
-			 mCodecPtr->sample_aspect_ratio.num,
-			 mCodecPtr->sample_aspect_ratio.den);
+			 codec->width, codec->height,
+			 codec->pix_fmt,
+			 codec->time_base.num,
+			 codec->time_base.den,
+			 codec->sample_aspect_ratio.num,
+			 codec->sample_aspect_ratio.den);
 	LOGD("Buffer args: %s", args);
 
-    ret = avfilter_graph_create_filter(&mFilterCtx.bufferSrcCtx, vbuffersrc, "in",
-                                       args, NULL, mFilterCtx.filterGraph.get());
+    ret = avfilter_graph_create_filter(&filterCtx.bufferSrcCtx, vbuffersrc, "in",
+                                       args, NULL, filterCtx.filterGraph.get());
 	if (ret < 0) {
 		LOGE("Create filter in failed");
 		goto end;
 	}
 
-    ret = avfilter_graph_create_filter(&mFilterCtx.bufferSinkCtx, vbuffersink, "out",
-                                       NULL, NULL, mFilterCtx.filterGraph.get());
+    ret = avfilter_graph_create_filter(&filterCtx.bufferSinkCtx, vbuffersink, "out",
+                                       NULL, NULL, filterCtx.filterGraph.get());
 	if (ret < 0) {
 		LOGE("Create filter out failed");		
 		goto end;
 	}
 
-    ret = av_opt_set_int_list(mFilterCtx.bufferSinkCtx, "pix_fmts", pix_fmts,
+    ret = av_opt_set_int_list(filterCtx.bufferSinkCtx, "pix_fmts", pix_fmts,
                               AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
     if (ret < 0) {
     	LOGE("Cannot set output pixel format");
@@ -483,25 +827,31 @@ int VideoDecoder::initFilters()
     }	
 
     outputs->name       = av_strdup("in");
-    outputs->filter_ctx = mFilterCtx.bufferSrcCtx;
+    outputs->filter_ctx = filterCtx.bufferSrcCtx;
     outputs->pad_idx    = 0;
     outputs->next       = NULL;
 
     inputs->name       = av_strdup("out");
-    inputs->filter_ctx = mFilterCtx.bufferSinkCtx;
+    inputs->filter_ctx = filterCtx.bufferSinkCtx;
     inputs->pad_idx    = 0;
     inputs->next       = NULL;
 
 	//args is reused
-	snprintf(args, sizeof(args), "format=pix_fmts=yuv420p");
+	if (width > 0 && height > 0) {
+		snprintf(args, sizeof(args), "scale=%d:%d:flags=bilinear,format=pix_fmts=%s",
+				 width, height, av_get_pix_fmt_name((enum AVPixelFormat)format));
+	} else {
+		snprintf(args, sizeof(args), "format=pix_fmts=%s",
+				 av_get_pix_fmt_name((enum AVPixelFormat)format));
+	}
 	LOGD("audio filter output desc %s", args);
-    if ((ret = avfilter_graph_parse_ptr(mFilterCtx.filterGraph.get(), args,
+    if ((ret = avfilter_graph_parse_ptr(filterCtx.filterGraph.get(), args,
                                         &inputs, &outputs, NULL)) < 0) {
 		LOGE("Graph parse failed");
 		goto end;
 	}
 
-    if ((ret = avfilter_graph_config(mFilterCtx.filterGraph.get(), NULL)) < 0) {
+    if ((ret = avfilter_graph_config(filterCtx.filterGraph.get(), NULL)) < 0) {
 		LOGE("Graph config failed");
         goto end;
 	}	
@@ -512,10 +862,43 @@ end:
 	return ret;
 }
 
-int MediaDecoder::open(shared_ptr<MediaSource> source, int streamid)
+int VideoDecoder::initFilters()
+{
+	return initVideoFilters(mFilterCtx, mCodecPtr.get());
+}
+
+shared_ptr<AVCodecContext> openStreamCodec(AVStream *st, int threads)
+{
+	AVCodec *codec = avcodec_find_decoder(st->codecpar->codec_id);
+	if (!codec) {
+		LOGE("Can't find decoder");
+		return nullptr;
+	}
+
+	shared_ptr<AVCodecContext> codecPtr(avcodec_alloc_context3(codec),
+										[](AVCodecContext *p){avcodec_free_context(&p);});
+	if (!codecPtr || avcodec_parameters_to_context(codecPtr.get(), st->codecpar) < 0) {
+		LOGE("Codec context failed");
+		return nullptr;
+	}
+
+	// let decoded frames be referenced instead of copied
+	codecPtr->refcounted_frames = 1;
+	codecPtr->time_base = st->time_base;
+	codecPtr->thread_count = threads;
+
+	if (avcodec_open2(codecPtr.get(), codec, NULL) < 0) {
+		LOGE("open decoder failed");
+		return nullptr;
+	}
+
+	return codecPtr;
+}
+
+int MediaDecoder::open(shared_ptr<MediaSource> source, int streamid, int outSampleRate)
 {
 	if (streamid == source->getAudioStreamId()) {
-		mDelegatePtr = unique_ptr<Codec>(new AudioDecoder);
+		mDelegatePtr = unique_ptr<Codec>(new AudioDecoder(outSampleRate));
 	} else if (streamid == source->getVideoStreamId()) {
 	   	mDelegatePtr = unique_ptr<Codec>(new VideoDecoder);
 	} else {
@@ -23,6 +23,7 @@ extern "C" {
 #include "libavfilter/buffersink.h"
 #include "libavfilter/buffersrc.h"
 #include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
 }
 
 namespace whitebean {
@@ -32,33 +33,130 @@ struct FilterContext {
 	AVFilterContext *bufferSinkCtx;
 	AVFilterContext *bufferSrcCtx;	
 };
+
+/*
+ * Graph converting the pictures of codec to YUV420P, for the formats
+ * the video sinks cannot render. With a width and height they are also
+ * scaled, and format picks another output pixel format.
+ */
+int initVideoFilters(FilterContext &filterCtx, AVCodecContext *codec,
+					 int width = 0, int height = 0, int format = AV_PIX_FMT_YUV420P);
+
+/*
+ * An opened decoder of its own for st, for decoding apart from the player
+ */
+std::shared_ptr<AVCodecContext> openStreamCodec(AVStream *st, int threads = 1);
 	
 class Codec: public MediaBase {
 public:
     Codec():mFrameQueue(16)
+		   , mSkipFrame(AVDISCARD_DEFAULT)
+		   , mSkipLoopFilter(AVDISCARD_DEFAULT)
+		   , mWaitKeyFrame(false)
+		   , mSuspended(false)
+		   , mSeekTargetUs(-1)
+		   , mPendingSeekTargetUs(-1)
+		   , mDiscardedFrames(0)
+		   , mEos(false)
+		   , mEndTargetUs(-1)
 		   {}
 	virtual ~Codec() {}
 
 	virtual int open(std::shared_ptr<MediaSource> source) = 0;
 	virtual bool read(FrameBuffer &frmbuf) = 0;
 	virtual void timeScaleToUs(FrameBuffer &frmbuf);
-	virtual void clear();
+	/*
+	 * Flush for a seek. With a target pts in us the frames before it are
+	 * still decoded, as the ones after depend on them, but dropped instead
+	 * of queued, and the audio frame across it is cut at the target sample.
+	 */
+	virtual void clear(int64_t targetUs = -1);
 	virtual int start();
 	virtual int stop();
 
+	/*
+	 * AVDiscard level for the frames decoded from now on. When going back
+	 * to a lower level, frames are dropped until the next key frame so that
+	 * no picture references a skipped one.
+	 */
+	void setSkipFrame(int discard) {
+		std::unique_lock<std::mutex> autoLock(mBaseLock);
+		mSkipFrame = discard;
+	}
+
+	/*
+	 * AVDiscard level for the deblocking filter, AVDISCARD_ALL for trick
+	 * play, where each picture is only up for a moment.
+	 */
+	void setSkipLoopFilter(int discard) {
+		std::unique_lock<std::mutex> autoLock(mBaseLock);
+		mSkipLoopFilter = discard;
+	}
+
+	/*
+	 * Stop the decode loop and close the codec, which gives its frame pool
+	 * and threads back. wakeUp() reopens it, the first frame out is a key
+	 * frame.
+	 */
+	void suspend();
+	void wakeUp();
+
 	virtual MetaData& getMetaData() {
 		return mMetaData;
 	}
+
+	// frames dropped before seek targets so far
+	int getDiscardedFrames() const {
+		std::unique_lock<std::mutex> autoLock(mBaseLock);
+		return mDiscardedFrames;
+	}
+
+	/*
+	 * Frames before startUs are decoded but dropped, as after an accurate
+	 * seek, for a decoder that starts on a source seeked ahead. Call it
+	 * before start().
+	 */
+	void setStartTarget(int64_t startUs) {
+		std::unique_lock<std::mutex> autoLock(mBaseLock);
+		mSeekTargetUs = startUs;
+	}
+
+	/*
+	 * The stream ends at endUs, -1 for the end of the file: later frames
+	 * are dropped, the audio frame across it is cut at the sample, and
+	 * eos() is reported from there.
+	 */
+	void setEndTarget(int64_t endUs) {
+		std::unique_lock<std::mutex> autoLock(mBaseLock);
+		mEndTargetUs = endUs;
+	}
+
+	/*
+	 * The source hit the end of the file, or the end target was reached,
+	 * and every frame of the stream was read, until the next clear
+	 */
+	bool eos() const {
+		std::unique_lock<std::mutex> autoLock(mBaseLock);
+		return mEos && mFrameQueue.empty();
+	}
 protected:	
 	virtual int initFilters() {return 0;}
 	int open_l();
 	void clear_l();
+	void applySkipFrame();
+	bool beforeSeekTarget(const FrameBuffer &frmbuf);
+	bool afterEndTarget(const FrameBuffer &frmbuf);
+	void countDiscarded();
+	void setEos();
+	bool reachedEos() const;
     virtual int decode() { return 0;}
 	virtual void initEvents();
 	virtual void onWaitEvent();
 	virtual void onWorkEvent();
 	virtual void onClearEvent();
 	virtual void onExitEvent();	
+	virtual void onSuspendEvent();
+	virtual void onWakeUpEvent();
 
 	std::shared_ptr<MediaSource>     mSource;
 	std::shared_ptr<AVFormatContext> mAVFmtCtxPtr;
@@ -68,11 +166,26 @@ protected:
 	FilterContext mFilterCtx;
 	MetaData mMetaData;
 	int mStreamId;
+	int mSkipFrame;
+	int mSkipLoopFilter;
+	bool mWaitKeyFrame;
+	bool mSuspended;
+
+	// owned by the decode thread, taken from the pending one on clear
+	int64_t mSeekTargetUs;
+	int64_t mPendingSeekTargetUs;
+	int mDiscardedFrames;
+	bool mEos;
+	int64_t mEndTargetUs;
 };
 
 class AudioDecoder : public Codec {
 public:
-	AudioDecoder();
+	/*
+	 * outSampleRate 0 keeps the rate of the stream, otherwise the frames
+	 * are resampled to it, for a sink opened at another rate
+	 */
+	explicit AudioDecoder(int outSampleRate = 0);
 
 	virtual int open(std::shared_ptr<MediaSource> source) override;	
 	virtual bool read(FrameBuffer &frmbuf) override;
@@ -80,8 +193,11 @@ public:
 private:
 	virtual int initFilters() override;
 	virtual int decode() override;
+	bool trimToSeekTarget(FrameBuffer &frmbuf);
+	bool trimToEndTarget(FrameBuffer &frmbuf);
 	
 	int mSampleRate;
+	int mOutSampleRate;
 	int mChannels;
 	int mSampleFmt;
 };
@@ -96,8 +212,15 @@ private:
 	virtual int initFilters() override;
 	virtual int decode() override;
 
+	/*
+	 * Whether the video sinks can render this pixel format without a
+	 * conversion pass
+	 */
+	static bool isRenderableFormat(int format, bool panoramic);
+
 	int mWidth;
 	int mHeight;
+	bool mPassThrough;
 };
 
 class MediaDecoder {
@@ -105,10 +228,13 @@ public:
 	MediaDecoder() {}
 	virtual ~MediaDecoder() {}
 
-	int open(std::shared_ptr<MediaSource> source, int streamid);
+	/*
+	 * outSampleRate is the rate of the audio frames, 0 for the stream's own
+	 */
+	int open(std::shared_ptr<MediaSource> source, int streamid, int outSampleRate = 0);
 	
 	bool read(FrameBuffer &frmbuf) {
-		return mDelegatePtr->read(frmbuf);		
+		return mDelegatePtr && mDelegatePtr->read(frmbuf);
 	}
 	
 	int start() {
@@ -125,16 +251,75 @@ public:
 		}
 	}
 
-	int seekTo(int64_t msec) {
+	/*
+	 * The source lands on the key frame before msec. An accurate seek
+	 * decodes from there and starts the output exactly at msec.
+	 */
+	int seekTo(int64_t msec, bool accurate = false) {
 		if (mDelegatePtr) {
-			mDelegatePtr->clear();
+			mDelegatePtr->clear(accurate ? msec * 1000 : -1);
 		}
 		return 0;
 	}
 
 	// resume frome halt
 	void resume() {
-		mDelegatePtr->resume();
+		if (mDelegatePtr) {
+			mDelegatePtr->resume();
+		}
+	}
+
+	void setSkipFrame(int discard) {
+		if (mDelegatePtr) {
+			mDelegatePtr->setSkipFrame(discard);
+		}
+	}
+
+	void setSkipLoopFilter(int discard) {
+		if (mDelegatePtr) {
+			mDelegatePtr->setSkipLoopFilter(discard);
+		}
+	}
+
+	void suspend() {
+		if (mDelegatePtr) {
+			mDelegatePtr->suspend();
+		}
+	}
+
+	void wakeUp() {
+		if (mDelegatePtr) {
+			mDelegatePtr->wakeUp();
+		}
+	}
+
+	int getDiscardedFrames() const {
+		return mDelegatePtr ? mDelegatePtr->getDiscardedFrames() : 0;
+	}
+
+	bool eos() const {
+		return mDelegatePtr && mDelegatePtr->eos();
+	}
+
+	void setStartTarget(int64_t startUs) {
+		if (mDelegatePtr) {
+			mDelegatePtr->setStartTarget(startUs);
+		}
+	}
+
+	void setEndTarget(int64_t endUs) {
+		if (mDelegatePtr) {
+			mDelegatePtr->setEndTarget(endUs);
+		}
+	}
+
+	bool opened() const {
+		return mDelegatePtr != nullptr;
+	}
+
+	// trade decoders with other, for handing over to the next playlist item
+	void swap(MediaDecoder &other) {
+		mDelegatePtr.swap(other.mDelegatePtr);
 	}
 
 	MetaData& getMetaData () {
@@ -142,7 +327,9 @@ public:
 	}
 
 	void setListener(IMediaListener *listener) {
-		mDelegatePtr->setListener(listener);
+		if (mDelegatePtr) {
+			mDelegatePtr->setListener(listener);
+		}
 	}
 private:
 	std::unique_ptr<Codec> mDelegatePtr;
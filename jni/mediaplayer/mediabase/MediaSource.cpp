@@ -6,8 +6,12 @@
  */
 
 #include <errno.h>
+#include <stdlib.h>
 #include "log.hpp"
 #include "MediaSource.hpp"
+#include "StreamInfoCache.hpp"
+#include "CacheFile.hpp"
+#include "AVIOBridge.hpp"
 
 using namespace std;
 
@@ -18,38 +22,158 @@ MediaSource::~MediaSource()
 
 }
 
+static bool streamInfoComplete(AVFormatContext *fmtptr)
+{
+	for (unsigned int i = 0; i < fmtptr->nb_streams; i++) {
+		AVCodecContext *codec = fmtptr->streams[i]->codec;
+
+		if (AVMEDIA_TYPE_VIDEO == codec->codec_type
+			&& (codec->width == 0 || codec->pix_fmt == AV_PIX_FMT_NONE)) {
+			return false;
+		}
+
+		if (AVMEDIA_TYPE_AUDIO == codec->codec_type
+			&& (codec->sample_rate == 0 || codec->channels == 0)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int MediaSource::findStreamInfo(AVFormatContext *fmtptr)
+{
+	if (avformat_find_stream_info(fmtptr, NULL) < 0) {
+		LOGE("find stream info failed");
+		return -1;
+	}
+
+	if ((mProbeSize > 0 || mAnalyzeDurationUs > 0) && !streamInfoComplete(fmtptr)) {
+		// carries on from what was read already
+		LOGD("Stream info incomplete at the probe limits, probing further");
+		fmtptr->probesize = 5000000;
+		fmtptr->max_analyze_duration = 0;
+		if (avformat_find_stream_info(fmtptr, NULL) < 0) {
+			LOGE("find stream info failed");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 int MediaSource::open(const string uri)
 {
 	AVFormatContext *fmtptr = nullptr;
+	auto start = chrono::steady_clock::now();
+	bool cached = false;
+	shared_ptr<AVIOBridge> io;
+	shared_ptr<ByteReader> upstream;
+	string path;
 	
 	mFormat = make_shared<MetaData>();
 	if (!mFormat) {
 		goto failed;
 	}
+
+	fmtptr = avformat_alloc_context();
+	if (!fmtptr) {
+		goto failed;
+	}
+
+	if (mProbeSize > 0) {
+		fmtptr->probesize = mProbeSize;
+	}
+	if (mAnalyzeDurationUs > 0) {
+		fmtptr->max_analyze_duration = mAnalyzeDurationUs;
+	}
+
+	// local files and, with a cache directory, http(s) are read through our
+	// own readers, anything else or what they can not open goes to the
+	// FFmpeg protocols
+	upstream = mReaderPtr;
+	if (!upstream && HttpCacheReader::isHttp(uri) && HttpCache::instance().enabled()) {
+		shared_ptr<HttpCacheReader> http(new HttpCacheReader);
+
+		if (http->open(uri) == 0) {
+			upstream = http;
+			mHttpPtr = http;
+		}
+	}
+
+	if (!upstream && mLocalIO != LOCAL_IO_PROTOCOL && CacheFile::localPath(uri, path)) {
+		shared_ptr<FileReader> file(new FileReader(mLocalIO, mReadAhead));
+
+		if (file->open(path) == 0) {
+			upstream = file;
+		}
+	}
+
+	if (upstream) {
+		shared_ptr<ByteReader> reader = upstream;
+
+		if (mPrefetchSize > 0) {
+			mPrefetchPtr = shared_ptr<PrefetchReader>(new PrefetchReader(upstream, mPrefetchSize));
+			mPrefetchPtr->start();
+			reader = mPrefetchPtr;
+		}
+
+		io = shared_ptr<AVIOBridge>(new AVIOBridge(reader));
+		if (io->init() == 0) {
+			fmtptr->pb = io->get();
+			fmtptr->flags |= AVFMT_FLAG_CUSTOM_IO;
+		} else {
+			io.reset();
+			closeReaders();
+		}
+	}
 	
+	// frees the context on failure
 	if ((avformat_open_input(&fmtptr, uri.c_str(), NULL, NULL) < 0)
 	|| (fmtptr == nullptr)) {
 		LOGE("open input failed %s", strerror(errno));
 		goto failed;
 	}
 
-	if (avformat_find_stream_info(fmtptr, NULL) < 0) {
-		LOGE("find stream info failed");
-		goto failed;
+	cached = StreamInfoCache::instance().load(uri, fmtptr) == 0;
+	if (!cached) {
+		if (findStreamInfo(fmtptr) < 0) {
+			goto failed;
+		}
+		StreamInfoCache::instance().store(uri, fmtptr);
 	}
 
+	LOGD("Stream info %s in %lld us", cached ? "cached" : "probed",
+		 (long long)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+
 	// find video stream
 	for (int i = 0; i < fmtptr->nb_streams; i++) {
 		if (AVMEDIA_TYPE_VIDEO == fmtptr->streams[i]->codec->codec_type) {
 			LOGD("video stream %d", i);
 			mVideoStreamId = i;
-			mTracksPtr->setVideoStream(i);
+			mTracksPtr->setVideoStream(i, fmtptr->streams[i]->time_base);
 
 			mFormat->setInt32(kKeyWidth, fmtptr->streams[i]->codec->width);
 			mFormat->setInt32(kKeyHeight, fmtptr->streams[i]->codec->height);
 			if (fmtptr->streams[i]->codec->width == fmtptr->streams[i]->codec->height << 1) {
 				LOGD("I guess this is a panoramic video");
-				mFormat->setInt32(kKeyPanoramic, 1);
+				mFormat->setInt32(kKeyPanoramic, PANO_LAYOUT_EQUIRECT);
+			}
+
+			// cube layouts can not be guessed from the size, they have to be tagged
+			AVDictionaryEntry *tag = av_dict_get(fmtptr->streams[i]->metadata, "projection", NULL, 0);
+			if (!tag) {
+				tag = av_dict_get(fmtptr->metadata, "projection", NULL, 0);
+			}
+			if (tag) {
+				LOGD("Projection %s", tag->value);
+				if (!strcmp(tag->value, "equirectangular")) {
+					mFormat->setInt32(kKeyPanoramic, PANO_LAYOUT_EQUIRECT);
+				} else if (!strcmp(tag->value, "cubemap")) {
+					mFormat->setInt32(kKeyPanoramic, PANO_LAYOUT_CUBEMAP_3X2);
+				} else if (!strcmp(tag->value, "eac")) {
+					mFormat->setInt32(kKeyPanoramic, PANO_LAYOUT_EAC_3X2);
+				}
 			}
 			break;
 		}
@@ -59,17 +183,21 @@ int MediaSource::open(const string uri)
 		if (AVMEDIA_TYPE_AUDIO == fmtptr->streams[i]->codec->codec_type) {
 			LOGD("audio stream %d", i);
 			mAudioStreamId = i;
-			mTracksPtr->setAudioStream(i);
+			mTracksPtr->setAudioStream(i, fmtptr->streams[i]->time_base);
 			break;
 		}
 	}
 
+	// the io context has to stay until the format context is closed
 	mAVFmtCtxPtr = shared_ptr<AVFormatContext>(fmtptr,
-				   [](AVFormatContext *p){avformat_close_input(&p);});
+				   [io](AVFormatContext *p){avformat_close_input(&p);});
 
 	LOGD("Duration %lld", mAVFmtCtxPtr->duration);
 	mFormat->setInt64(kKeyDuration, mAVFmtCtxPtr->duration);
 
+	mUri = uri;
+	initKeyIndex();
+
 	initEvents();
 		
 	// start event queue
@@ -80,10 +208,59 @@ int MediaSource::open(const string uri)
 	return 0;
 
  failed:
+	avformat_close_input(&fmtptr);
+	closeReaders();
 
 	return -1;
 }
 
+/*
+ * Drop the readers open() set up, stopping the read ahead that would go on
+ * holding the file or the connection otherwise
+ */
+void MediaSource::closeReaders()
+{
+	// a fetch stalled on the network must not hold up the stop
+	if (mHttpPtr) {
+		mHttpPtr->interrupt();
+	}
+
+	if (mPrefetchPtr) {
+		mPrefetchPtr->stop();
+	}
+
+	mPrefetchPtr.reset();
+	mHttpPtr.reset();
+}
+
+int64_t MediaSource::getBufferedUs() const
+{
+	int64_t bufferedUs = INT64_MAX;
+
+	if (hasVideo() && !mVideoDiscard) {
+		bufferedUs = mTracksPtr->videoBufferedUs();
+	}
+
+	if (hasAudio()) {
+		bufferedUs = min(bufferedUs, mTracksPtr->audioBufferedUs());
+	}
+
+	return bufferedUs == INT64_MAX ? 0 : bufferedUs;
+}
+
+PrefetchReader::Stats MediaSource::getIOStats() const
+{
+	PrefetchReader::Stats stats;
+
+	if (mPrefetchPtr) {
+		return mPrefetchPtr->getStats();
+	}
+
+	memset(&stats, 0, sizeof(stats));
+
+	return stats;
+}
+
 int MediaSource::start()
 {
 	mWaiting = 0;
@@ -95,8 +272,88 @@ int MediaSource::start()
 
 int MediaSource::stop()
 {
+	// a fetch stalled on the network must not hold up the stop
+	if (mHttpPtr) {
+		mHttpPtr->interrupt();
+	}
+
 	mQueue.stop();
+	storeKeyIndex();
 	return 0;
+}
+
+/*
+ * Pick how the seek stream gets indexed. Formats that seek by scanning
+ * (no read_seek, e.g. MPEG-TS) get byte offsets collected here. Formats
+ * that seek on an index they build while demuxing, because the file has
+ * none (e.g. Matroska without cues), get that index back from the last
+ * time. Anything indexed by its header is left alone.
+ */
+void MediaSource::initKeyIndex()
+{
+	mIndexStream = hasVideo() ? mVideoStreamId : mAudioStreamId;
+	if (mIndexStream < 0) {
+		return;
+	}
+
+	AVFormatContext *ctx = mAVFmtCtxPtr.get();
+	AVStream *st = ctx->streams[mIndexStream];
+	int mode = KeyframeIndex::MODE_NONE;
+
+	if (!ctx->iformat->read_seek && !ctx->iformat->read_seek2) {
+		if (!(ctx->iformat->flags & AVFMT_NO_BYTE_SEEK)) {
+			mode = KeyframeIndex::MODE_BYTES;
+		}
+	} else if (st->nb_index_entries == 0) {
+		mode = KeyframeIndex::MODE_DEMUXER;
+	}
+
+	mKeyIndex.setMode(mode);
+	if (mode == KeyframeIndex::MODE_NONE) {
+		return;
+	}
+
+	KeyframeIndex cached;
+	if (StreamInfoCache::instance().loadIndex(mUri, cached) < 0 || cached.getMode() != mode) {
+		return;
+	}
+
+	mKeyIndex = cached;
+
+	if (mode == KeyframeIndex::MODE_DEMUXER) {
+		for (const KeyframeIndex::Entry &entry : mKeyIndex.getEntries()) {
+			av_add_index_entry(st, entry.pos, entry.ts, 0, 0, AVINDEX_KEYFRAME);
+		}
+	}
+
+	LOGD("Keyframe index with %d entries", (int)mKeyIndex.getEntries().size());
+}
+
+void MediaSource::storeKeyIndex()
+{
+	if (!mAVFmtCtxPtr || mIndexStream < 0) {
+		return;
+	}
+
+	if (mKeyIndex.getMode() == KeyframeIndex::MODE_DEMUXER) {
+		// the demuxer's own index, not public API but the only way to it here
+		AVStream *st = mAVFmtCtxPtr->streams[mIndexStream];
+
+		if (st->nb_index_entries > (int)mKeyIndex.getEntries().size()) {
+			vector<KeyframeIndex::Entry> entries;
+			for (int i = 0; i < st->nb_index_entries; i++) {
+				if (st->index_entries[i].flags & AVINDEX_KEYFRAME) {
+					entries.push_back(KeyframeIndex::Entry{st->index_entries[i].timestamp,
+														   st->index_entries[i].pos});
+				}
+			}
+			mKeyIndex.setEntries(entries);
+		}
+	}
+
+	if (mKeyIndex.isDirty()) {
+		StreamInfoCache::instance().storeIndex(mUri, mKeyIndex);
+	}
 }	
 
 int MediaSource::seekTo(int64_t msec)
@@ -111,14 +368,25 @@ int MediaSource::seekTo(int64_t msec)
 	return 0;
 }
 
+void MediaSource::setVideoDiscard(bool discard)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (!hasVideo() || discard == mVideoDiscard) {
+		return;
+	}
+
+	mVideoDiscard = discard;
+	mTracksPtr->setVideoDiscard(discard);
+}
+
 int MediaSource::seekTo_l(int64_t msec)
 {
-	int ret = 0;
 	int seekStream = -1;
 	
 	mTracksPtr->clear();
 
-	if (hasVideo()) {
+	if (hasVideo() && !mVideoDiscard) {
 		seekStream = mVideoStreamId;
 	} else {
 		seekStream = mAudioStreamId;
@@ -130,7 +398,32 @@ int MediaSource::seekTo_l(int64_t msec)
 
 	int64_t ts = 0;
 	ts = msec / av_q2d(getTimeScaleOfTrack(seekStream)) / 1000;
-	ret = av_seek_frame(mAVFmtCtxPtr.get(), seekStream, ts, AVSEEK_FLAG_BACKWARD);
+
+	mEof = false;
+	mTrickLastPts = AV_NOPTS_VALUE;
+	mTrickScale = 1;
+	mTrickEnd = false;
+
+	return seekKeyframe_l(seekStream, ts, AVSEEK_FLAG_BACKWARD);
+}
+
+int MediaSource::seekKeyframe_l(int stream, int64_t ts, int flags)
+{
+	// packets after the seek do not continue the indexed span
+	mKeyIndex.discontinuity();
+
+	// the index only knows the key frame at or before ts
+	KeyframeIndex::Entry entry;
+	if ((flags & AVSEEK_FLAG_BACKWARD)
+		&& stream == mIndexStream && mKeyIndex.getMode() == KeyframeIndex::MODE_BYTES
+		&& mKeyIndex.lookup(ts, entry)
+		&& av_seek_frame(mAVFmtCtxPtr.get(), -1, entry.pos, AVSEEK_FLAG_BYTE) >= 0) {
+		LOGD("Seek to keyframe %lld at byte %lld", (long long)entry.ts, (long long)entry.pos);
+		mIndexedSeeks++;
+		return 0;
+	}
+
+	int ret = av_seek_frame(mAVFmtCtxPtr.get(), stream, ts, flags);
 	if (ret < 0) {
 		LOGE("av_seek_frame failed (%d)", ret);
 		return -1;
@@ -139,6 +432,55 @@ int MediaSource::seekTo_l(int64_t msec)
 	return 0;
 }
 
+void MediaSource::setTrickRate(int rate)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (!hasVideo()) {
+		return;
+	}
+
+	mTrickRate = rate;
+}
+
+bool MediaSource::acceptTrickPacket(AVPacket &packet, int rate)
+{
+	// audio is muted, and not every demuxer honours AVDISCARD_NONKEY
+	if (packet.stream_index != mVideoStreamId || !(packet.flags & AV_PKT_FLAG_KEY)) {
+		return false;
+	}
+
+	int64_t pts = packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+	if (pts == AV_NOPTS_VALUE) {
+		return false;
+	}
+
+	// a seek that lands on a key frame already shown is retried further away
+	bool progress = mTrickLastPts == AV_NOPTS_VALUE
+		|| (rate > 0 ? pts > mTrickLastPts : pts < mTrickLastPts);
+	if (progress) {
+		mTrickLastPts = pts;
+		mTrickScale = 1;
+	} else {
+		mTrickScale *= 2;
+	}
+
+	AVStream *st = mAVFmtCtxPtr->streams[mVideoStreamId];
+	int64_t step = av_rescale_q((int64_t)abs(rate) * TRICK_FRAME_INTERVAL_US * mTrickScale,
+								AV_TIME_BASE_Q, st->time_base);
+	int64_t start = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+	int64_t target = rate > 0 ? mTrickLastPts + step : mTrickLastPts - step;
+
+	if (mTrickScale > MAX_TRICK_SCALE || target < start
+		|| seekKeyframe_l(mVideoStreamId, target, rate > 0 ? 0 : AVSEEK_FLAG_BACKWARD) < 0) {
+		LOGD("Trick play reached the %s", rate > 0 ? "end" : "start");
+		mTrickEnd = true;
+		mEof = true;
+	}
+
+	return progress;
+}
+
 int MediaSource::readPacket()
 {
 	int ret = 0;
@@ -152,6 +494,36 @@ int MediaSource::readPacket()
 		return ERR_AGAIN;
 	}	
 
+	int trickRate;
+
+	{
+		// the stream is only read here, on the source thread
+		unique_lock<mutex> autoLock(mLock);
+		trickRate = mTrickRate;
+
+		if (hasVideo()) {
+			mAVFmtCtxPtr->streams[mVideoStreamId]->discard = mVideoDiscard ? AVDISCARD_ALL
+				: trickRate ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+		}
+
+		if (hasAudio()) {
+			mAVFmtCtxPtr->streams[mAudioStreamId]->discard = trickRate ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+		}
+
+		// discarded packets are not seen, the span ends there
+		if (mIndexDiscard != mVideoDiscard) {
+			mIndexDiscard = mVideoDiscard;
+			mKeyIndex.discontinuity();
+		}
+	}
+
+	if (trickRate) {
+		// a few key frames ahead of the clock, a rate change drops them all
+		if (mTrickEnd || mTracksPtr->videoPackets() >= TRICK_QUEUED_PACKETS) {
+			return ERR_AGAIN;
+		}
+	}
+
 	AVPacket packet;
 	av_init_packet(&packet);
 
@@ -166,6 +538,16 @@ int MediaSource::readPacket()
 		return ERR_AGAIN;
 	}
 
+	if (packet.stream_index == mIndexStream && mKeyIndex.getMode() == KeyframeIndex::MODE_BYTES) {
+		mKeyIndex.addPacket(packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts, packet.pos,
+							packet.flags & AV_PKT_FLAG_KEY);
+	}
+
+	if (trickRate && !acceptTrickPacket(packet, trickRate)) {
+		av_packet_unref(&packet);
+		return 0;
+	}
+
 	PacketBuffer pktbuf(packet);
 	mTracksPtr->packetIn(pktbuf);
 	av_packet_unref(&packet); // 	
@@ -222,10 +604,10 @@ void MediaSource::onSeekEvent()
 
 	mQueue.cancelEvent(mEvents[EVENT_WORK]->eventID());
 	
+	// a failed seek completes too, demuxing goes on from where it was
 	ret = seekTo_l(mSeekTimeMs);
 	if (ret < 0) {
-		mQueue.postEvent(mEvents[EVENT_WORK]);
-		return;
+		LOGE("Seek to %lld ms failed", (long long)mSeekTimeMs);
 	}
 
 	mVideoReady = 0;
@@ -235,7 +617,7 @@ void MediaSource::onSeekEvent()
 	mQueue.postEvent(mEvents[EVENT_WORK]);
 
 	if (mListener) {
-		mListener->mediaNotify(SOURCE_SEEK_COMPLETE);
+		mListener->mediaNotify(SOURCE_SEEK_COMPLETE, ret < 0 ? -1 : 0);
 	}
 }
 
@@ -276,8 +658,9 @@ int MediaSource::onDecoderClear(int stream)
 		mAudioReady = 1;
 	}
 
-	if ((hasVideo() && mVideoReady)
-		&& (hasAudio() && mAudioReady)) {
+	// a stream the file does not have is never cleared
+	if ((!hasVideo() || mVideoReady)
+		&& (!hasAudio() || mAudioReady)) {
 		mQueue.postEvent(mEvents[EVENT_SEEK]);
 	}
 	
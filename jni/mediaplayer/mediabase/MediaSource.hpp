@@ -15,6 +15,10 @@
 #include "MediaTracks.hpp"
 #include "MediaThread.hpp"
 #include "MediaBase.hpp"
+#include "FileReader.hpp"
+#include "PrefetchReader.hpp"
+#include "HttpCacheReader.hpp"
+#include "KeyframeIndex.hpp"
 
 extern "C" {
 #include "libavformat/avformat.h"
@@ -33,6 +37,19 @@ public:
 				 , mSeekTimeMs(-1)
 				 , mVideoReady(0)
 				 , mAudioReady(0)
+				 , mVideoDiscard(false)
+				 , mProbeSize(DEFAULT_PROBE_SIZE)
+				 , mAnalyzeDurationUs(DEFAULT_ANALYZE_DURATION_US)
+				 , mLocalIO(FileReader::MODE_MMAP)
+				 , mReadAhead(FileReader::DEFAULT_READ_AHEAD)
+				 , mPrefetchSize(PrefetchReader::DEFAULT_CAPACITY)
+				 , mIndexStream(-1)
+				 , mIndexDiscard(false)
+				 , mIndexedSeeks(0)
+				 , mTrickRate(0)
+				 , mTrickLastPts(AV_NOPTS_VALUE)
+				 , mTrickScale(1)
+				 , mTrickEnd(false)
 	{
 
 	}
@@ -44,6 +61,64 @@ public:
 	 */
 	int open(const std::string uri);
 
+	/*
+	 * Limit what avformat_find_stream_info() may read before open() returns,
+	 * in bytes and in us of media, 0 for the FFmpeg defaults (5MB, 5s).
+	 * Streams still missing parameters at the limit are probed again with
+	 * the defaults. Must be called before open().
+	 */
+	void setProbeLimits(int64_t probeSize, int64_t analyzeDurationUs) {
+		mProbeSize = probeSize;
+		mAnalyzeDurationUs = analyzeDurationUs;
+	}
+
+	static const int64_t DEFAULT_PROBE_SIZE = 512 * 1024;
+	static const int64_t DEFAULT_ANALYZE_DURATION_US = 1000000;
+
+	/*
+	 * How local files are read: FileReader::MODE_MMAP (default),
+	 * FileReader::MODE_BUFFERED with readAhead bytes per read, or
+	 * LOCAL_IO_PROTOCOL for the FFmpeg file protocol. Must be called
+	 * before open().
+	 */
+	void setLocalIO(int mode, size_t readAhead = FileReader::DEFAULT_READ_AHEAD) {
+		mLocalIO = mode;
+		mReadAhead = readAhead;
+	}
+
+	static const int LOCAL_IO_PROTOCOL = -1;
+
+	/*
+	 * Bytes read ahead on the prefetch thread, the demuxer then only reads
+	 * cached bytes. 0 reads on the demux thread. Must be called before
+	 * open().
+	 */
+	void setPrefetchSize(size_t bytes) {
+		mPrefetchSize = bytes;
+	}
+
+	/*
+	 * Demux from reader instead of opening the uri, which still names the
+	 * stream for the caches. The prefetch stage goes on top of it as for a
+	 * local file. Must be called before open().
+	 */
+	void setByteReader(std::shared_ptr<ByteReader> reader) {
+		mReaderPtr = reader;
+	}
+
+	/*
+	 * Buffered bytes and read throughput of the prefetch stage, all 0
+	 * without one
+	 */
+	PrefetchReader::Stats getIOStats() const;
+
+	/*
+	 * Seeks that went straight to a byte offset from the keyframe index
+	 */
+	int getIndexedSeekCount() const {
+		return mIndexedSeeks;
+	}
+
 	int start();
 	int stop();
 
@@ -79,9 +154,38 @@ public:
 		return mEof;
 	}
 
+	/*
+	 * Play time demuxed ahead of the decoders in us, the least over the
+	 * streams that are read
+	 */
+	int64_t getBufferedUs() const;
+
+	// no packet fits in the queues any more
+	bool bufferFull() const {
+		return mTracksPtr->full();
+	}
+
 	int seekTo(int64_t msec);
 	int seekTo_l(int64_t msec);
 
+	/*
+	 * Stop demuxing the video stream (AVDISCARD_ALL), for audio only
+	 * playback. Video packets come back from the next key frame on.
+	 */
+	void setVideoDiscard(bool discard);
+
+	/*
+	 * Trick play at rate times normal speed, negative to rewind, 0 to
+	 * leave it. Only video key frames are demuxed: after each one the
+	 * source seeks to the key frame rate frame intervals away, so the
+	 * work follows the frames shown rather than the rate. Audio is not
+	 * read. Queued packets are kept, follow with a seek to drop them.
+	 */
+	void setTrickRate(int rate);
+
+	// media time per shown frame at 1x, rate times this is skipped per frame
+	static const int64_t TRICK_FRAME_INTERVAL_US = 100000;
+
 	AVRational getTimeScaleOfTrack(int idx) {
 		return mAVFmtCtxPtr->streams[idx]->time_base;
 	}
@@ -98,6 +202,12 @@ private:
 	int onDecoderClear(int stream);
 
 	int readPacket();
+	int seekKeyframe_l(int stream, int64_t ts, int flags);
+	bool acceptTrickPacket(AVPacket &packet, int rate);
+	int findStreamInfo(AVFormatContext *fmtptr);
+	void closeReaders();
+	void initKeyIndex();
+	void storeKeyIndex();
 
 	mutable std::mutex mLock;
 	
@@ -113,6 +223,30 @@ private:
 	int64_t mSeekTimeMs; // msec
 	int mVideoReady;
 	int mAudioReady;
+	bool mVideoDiscard;
+	int64_t mProbeSize;
+	int64_t mAnalyzeDurationUs;
+	int mLocalIO;
+	size_t mReadAhead;
+	size_t mPrefetchSize;
+	std::shared_ptr<ByteReader> mReaderPtr;
+	std::shared_ptr<PrefetchReader> mPrefetchPtr;
+	std::shared_ptr<HttpCacheReader> mHttpPtr;
+
+	// keyframes of the seek stream, kept across opens by StreamInfoCache
+	std::string mUri;
+	KeyframeIndex mKeyIndex;
+	int mIndexStream;
+	bool mIndexDiscard;
+	int mIndexedSeeks;
+
+	// trick play, the key frame positions are only touched on the source thread
+	static const int TRICK_QUEUED_PACKETS = 8;
+	static const int MAX_TRICK_SCALE = 64;
+	int mTrickRate;
+	int64_t mTrickLastPts;
+	int mTrickScale;
+	bool mTrickEnd;
 };
 	
 }
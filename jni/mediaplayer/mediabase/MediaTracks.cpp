@@ -6,6 +6,7 @@
  */
 
 
+#include <algorithm>
 #include "MediaTracks.hpp"
 #include "log.hpp"
 
@@ -14,23 +15,65 @@ using namespace std;
 namespace whitebean {
 
 MediaTracks::MediaTracks()
-: mSlots(new QueueSlots)
-, mVideoQueue(mSlots)
-, mAudioQueue(mSlots)
+: mVideoDiscard(false)
+, mVideoWaitKey(false)
 , mVideoStreamId(-1)
 , mAudioStreamId(-1)
+, mSlots(new QueueSlots)
+, mVideoQueue(mSlots)
+, mAudioQueue(mSlots)
+, mVideoTimeBase(AV_TIME_BASE_Q)
+, mAudioTimeBase(AV_TIME_BASE_Q)
+, mVideoQueuedTicks(0)
+, mAudioQueuedTicks(0)
+, mVideoLastPts(AV_NOPTS_VALUE)
+, mAudioLastPts(AV_NOPTS_VALUE)
 {
 
 }
 
+void MediaTracks::fillDuration(AVPacket *pkt, int64_t &lastPts)
+{
+	if (pkt->pts == AV_NOPTS_VALUE) {
+		return;
+	}
+
+	// the step from the packet before is as close as it gets
+	if (pkt->duration <= 0 && lastPts != AV_NOPTS_VALUE && pkt->pts > lastPts) {
+		pkt->duration = pkt->pts - lastPts;
+	}
+
+	lastPts = pkt->pts;
+}
+
 void MediaTracks::packetIn(PacketBuffer &pktbuf)
 {
+	unique_lock<mutex> autoLock(mLock);
+
 	if (pktbuf.getData().stream_index == mVideoStreamId) {
 		LOGD("Packet in video packet %lld", pktbuf.getData().pts);
-		mVideoQueue.push(pktbuf);
+
+		if (mVideoDiscard) {
+			return;
+		}
+
+		if (mVideoWaitKey) {
+			if (!(pktbuf.getData().flags & AV_PKT_FLAG_KEY)) {
+				return;
+			}
+			mVideoWaitKey = false;
+		}
+
+		fillDuration(pktbuf.getDataPtr(), mVideoLastPts);
+		if (mVideoQueue.push(pktbuf)) {
+			mVideoQueuedTicks += max<int64_t>(pktbuf.getData().duration, 0);
+		}
 	} else if (pktbuf.getData().stream_index == mAudioStreamId) {
 		LOGD("Packet in audio packet %lld", pktbuf.getData().pts);
-		mAudioQueue.push(pktbuf);
+		fillDuration(pktbuf.getDataPtr(), mAudioLastPts);
+		if (mAudioQueue.push(pktbuf)) {
+			mAudioQueuedTicks += max<int64_t>(pktbuf.getData().duration, 0);
+		}
 	} else {
 		return;
 	}
@@ -40,9 +83,12 @@ void MediaTracks::packetIn(PacketBuffer &pktbuf)
 
 bool MediaTracks::readVideo(PacketBuffer &pktbuf)
 {
+	unique_lock<mutex> autoLock(mLock);
+
 	if (!mVideoQueue.empty()) {
 		pktbuf = mVideoQueue.front();
 		mVideoQueue.pop();
+		mVideoQueuedTicks = max<int64_t>(mVideoQueuedTicks - max<int64_t>(pktbuf.getData().duration, 0), 0);
 		return true;
 	}
 	return false;
@@ -51,9 +97,12 @@ bool MediaTracks::readVideo(PacketBuffer &pktbuf)
 bool MediaTracks::readAudio(PacketBuffer &pktbuf)
 {
 	LOGD("Read audio packet");
+	unique_lock<mutex> autoLock(mLock);
+
 	if (!mAudioQueue.empty()) {
 		pktbuf = mAudioQueue.front();
 		mAudioQueue.pop();
+		mAudioQueuedTicks = max<int64_t>(mAudioQueuedTicks - max<int64_t>(pktbuf.getData().duration, 0), 0);
 		LOGD("Read audio pts %lld", pktbuf.getData().pts);
 		return true;
 	}
@@ -67,13 +116,54 @@ bool MediaTracks::full()
 }
 
 void MediaTracks::clear()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	clearVideo();
+
+	while (!mAudioQueue.empty()) {
+		mAudioQueue.pop();
+	}
+
+	mAudioQueuedTicks = 0;
+	mAudioLastPts = AV_NOPTS_VALUE;
+}
+
+void MediaTracks::clearVideo()
 {
 	while (!mVideoQueue.empty()) {
 		mVideoQueue.pop();
 	}
 
-	while (!mAudioQueue.empty()) {
-		mAudioQueue.pop();
+	mVideoQueuedTicks = 0;
+	mVideoLastPts = AV_NOPTS_VALUE;
+}
+
+int64_t MediaTracks::videoBufferedUs() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return av_rescale_q(mVideoQueuedTicks, mVideoTimeBase, AV_TIME_BASE_Q);
+}
+
+int64_t MediaTracks::audioBufferedUs() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return av_rescale_q(mAudioQueuedTicks, mAudioTimeBase, AV_TIME_BASE_Q);
+}
+
+void MediaTracks::setVideoDiscard(bool discard)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (discard == mVideoDiscard) {
+		return;
+	}
+
+	mVideoDiscard = discard;
+	mVideoWaitKey = !discard;
+
+	if (discard) {
+		clearVideo();
 	}
 }
 	
@@ -23,12 +23,16 @@ public:
 	MediaTracks();
 	~MediaTracks() {}
 
-	void setVideoStream(int id) {
+	void setVideoStream(int id, AVRational timeBase = AV_TIME_BASE_Q) {
+		std::unique_lock<std::mutex> autoLock(mLock);
 		mVideoStreamId = id;
+		mVideoTimeBase = timeBase;
 	}
 
-	void setAudioStream(int id) {
+	void setAudioStream(int id, AVRational timeBase = AV_TIME_BASE_Q) {
+		std::unique_lock<std::mutex> autoLock(mLock);
 		mAudioStreamId = id;
+		mAudioTimeBase = timeBase;
 	}
 
 	bool readVideo(PacketBuffer &pktbuf);
@@ -38,12 +42,44 @@ public:
 
 	bool full();
 	void clear();
+
+	int videoPackets() const {
+		std::unique_lock<std::mutex> autoLock(mLock);
+		return mVideoQueue.size();
+	}
+
+	/*
+	 * Play time queued for each stream in us, summed over the packet
+	 * durations, or the pts steps where a packet has none
+	 */
+	int64_t videoBufferedUs() const;
+	int64_t audioBufferedUs() const;
+
+	/*
+	 * Drop video packets, queued ones included. When video is taken back
+	 * the queue starts at the next key frame.
+	 */
+	void setVideoDiscard(bool discard);
 private:
+	void clearVideo();
+	static void fillDuration(AVPacket *pkt, int64_t &lastPts);
+
+	mutable std::mutex mLock;
+	bool mVideoDiscard;
+	bool mVideoWaitKey;
 	int mVideoStreamId;
 	int mAudioStreamId;
 	std::shared_ptr<QueueSlots> mSlots;
 	MediaBufferQueue<PacketBuffer> mVideoQueue;
 	MediaBufferQueue<PacketBuffer> mAudioQueue;
+
+	// queued play time in the stream time bases
+	AVRational mVideoTimeBase;
+	AVRational mAudioTimeBase;
+	int64_t mVideoQueuedTicks;
+	int64_t mAudioQueuedTicks;
+	int64_t mVideoLastPts;
+	int64_t mAudioLastPts;
 };
 	
 }
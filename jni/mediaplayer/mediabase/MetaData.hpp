@@ -25,7 +25,15 @@ enum {
     kKeyColorFormat       = 'colf',
 	kKeyTime              = 'time',  // int64_t (usecs)
 	kKeyDuration          = 'dura',  // int64_t (usecs)
-	kKeyPanoramic		  = 'pano',  // int32_t (0 / 1)
+	kKeyPanoramic		  = 'pano',  // int32_t (PANO_LAYOUT_*)
+};
+
+// kKeyPanoramic values
+enum {
+	PANO_LAYOUT_NONE		= 0,
+	PANO_LAYOUT_EQUIRECT	= 1,
+	PANO_LAYOUT_CUBEMAP_3X2	= 2,
+	PANO_LAYOUT_EAC_3X2		= 3,
 };
 
 class MetaData {
@@ -0,0 +1,228 @@
+/*
+ * PrefetchReader.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "log.hpp"
+#include "PrefetchReader.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+PrefetchReader::PrefetchReader(shared_ptr<ByteReader> upstream, size_t capacity, size_t chunk)
+: mUpstream(upstream)
+, mCapacity(capacity)
+, mChunk(min(chunk, capacity))
+, mKeepBehind(capacity / 4)
+, mSize(upstream->size())
+, mRing(new uint8_t[capacity])
+, mStart(upstream->tell())
+, mLength(0)
+, mPos(mStart)
+, mGeneration(0)
+, mEof(false)
+, mError(false)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+PrefetchReader::~PrefetchReader()
+{
+	stop();
+}
+
+int PrefetchReader::start()
+{
+	return MediaThread::start();
+}
+
+void PrefetchReader::stop()
+{
+	if (!isRunning()) {
+		return;
+	}
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+		mStopped = true;
+		mCondition.notify_all();
+	}
+
+	// mStopped is only touched under the lock, not through MediaThread::stop()
+	mThread.join();
+	mRunning = false;
+}
+
+bool PrefetchReader::canFetch_l() const
+{
+	return !mEof && !mError && mLength < (int64_t)mCapacity;
+}
+
+// drop what is too far behind the reader, making room for the worker
+void PrefetchReader::trim_l()
+{
+	int64_t behind = mPos - mStart;
+
+	if (behind > (int64_t)mKeepBehind) {
+		int64_t drop = behind - mKeepBehind;
+		mStart += drop;
+		mLength -= drop;
+		mCondition.notify_all();
+	}
+}
+
+void PrefetchReader::threadEntry()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	while (!mStopped) {
+		if (!canFetch_l()) {
+			mCondition.wait(autoLock);
+			continue;
+		}
+
+		int generation = mGeneration;
+		int64_t fetchPos = mStart + mLength;
+		size_t offset = fetchPos % mCapacity;
+
+		// one contiguous piece of the free space
+		size_t len = min<size_t>(mChunk, mCapacity - mLength);
+		len = min(len, mCapacity - offset);
+		if (mSize >= 0) {
+			len = min<int64_t>(len, mSize - fetchPos);
+		}
+
+		if (len == 0) {
+			mEof = true;
+			mCondition.notify_all();
+			continue;
+		}
+
+		// the ring beyond mLength is only written here, the reader never
+		// looks at it, so the upstream read can run unlocked
+		autoLock.unlock();
+
+		auto start = chrono::steady_clock::now();
+		int n = -1;
+		if (mUpstream->tell() == fetchPos || mUpstream->seek(fetchPos) == fetchPos) {
+			n = mUpstream->read(mRing.get() + offset, len);
+		}
+		int64_t us = elapsedUs(start);
+
+		autoLock.lock();
+
+		if (generation != mGeneration) {
+			// sought away meanwhile
+			continue;
+		}
+
+		if (n > 0) {
+			mLength += n;
+			mStats.fetchedBytes += n;
+			mStats.fetchUs += us;
+		} else if (n == 0) {
+			mEof = true;
+		} else {
+			LOGE("Prefetch read at %lld failed", (long long)fetchPos);
+			mError = true;
+		}
+
+		mCondition.notify_all();
+	}
+}
+
+int PrefetchReader::read(uint8_t *buf, int size)
+{
+	unique_lock<mutex> autoLock(mLock);
+	chrono::steady_clock::time_point stallStart;
+	bool stalled = false;
+
+	if (size < 0) {
+		return -1;
+	}
+
+	while (mPos >= mStart + mLength) {
+		if (mEof) {
+			return 0;
+		}
+
+		if (mError || mStopped || !isRunning()) {
+			return -1;
+		}
+
+		if (!stalled) {
+			stalled = true;
+			stallStart = chrono::steady_clock::now();
+			mStats.stalls++;
+		}
+
+		mCondition.wait(autoLock);
+	}
+
+	if (stalled) {
+		mStats.stallUs += elapsedUs(stallStart);
+	}
+
+	size_t len = min<int64_t>(size, mStart + mLength - mPos);
+	size_t offset = mPos % mCapacity;
+	size_t first = min(len, mCapacity - offset);
+
+	memcpy(buf, mRing.get() + offset, first);
+	memcpy(buf + first, mRing.get(), len - first);
+
+	mPos += len;
+	trim_l();
+
+	return len;
+}
+
+int64_t PrefetchReader::seek(int64_t pos)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (pos < 0) {
+		return -1;
+	}
+
+	mPos = pos;
+
+	if (pos >= mStart && pos <= mStart + mLength) {
+		trim_l();
+		return pos;
+	}
+
+	// outside the window, start over there
+	mStart = pos;
+	mLength = 0;
+	mEof = false;
+	mError = false;
+	mGeneration++;
+	mCondition.notify_all();
+
+	return pos;
+}
+
+int64_t PrefetchReader::tell() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mPos;
+}
+
+PrefetchReader::Stats PrefetchReader::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	Stats stats = mStats;
+
+	stats.bufferedBytes = max<int64_t>(mStart + mLength - mPos, 0);
+	stats.throughput = stats.fetchUs > 0 ? stats.fetchedBytes * 1000000 / stats.fetchUs : 0;
+
+	return stats;
+}
+
+}
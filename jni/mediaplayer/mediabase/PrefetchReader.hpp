@@ -0,0 +1,86 @@
+/*
+ * PrefetchReader.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_PREFETCHREADER_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_PREFETCHREADER_H_
+
+#include <stddef.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "ByteReader.hpp"
+#include "MediaThread.hpp"
+
+namespace whitebean {
+
+/*
+ * Reads ahead of the demuxer on its own thread. Bytes from the upstream
+ * reader go to a bounded ring, read() only ever copies out of it and
+ * waits while the worker is behind, so a slow or blocking upstream never
+ * runs on the demux thread. Seeks inside the cached window, including a
+ * part kept behind the read position, cost nothing; any other seek drops
+ * the window and the worker starts over at the new position.
+ */
+class PrefetchReader: public ByteReader, public MediaThread {
+public:
+	struct Stats {
+		int64_t bufferedBytes;	// cached ahead of the read position
+		int64_t fetchedBytes;	// read from upstream in total
+		int64_t fetchUs;		// time spent in upstream reads
+		int64_t throughput;		// fetchedBytes per second of fetchUs
+		int stalls;				// reads that had to wait for the worker
+		int64_t stallUs;
+	};
+
+	static const size_t DEFAULT_CAPACITY = 4 * 1024 * 1024;
+	static const size_t DEFAULT_CHUNK = 256 * 1024;
+
+	explicit PrefetchReader(std::shared_ptr<ByteReader> upstream,
+							size_t capacity = DEFAULT_CAPACITY,
+							size_t chunk = DEFAULT_CHUNK);
+	virtual ~PrefetchReader();
+
+	int start();
+	void stop();
+
+	virtual int read(uint8_t *buf, int size) override;
+	virtual int64_t seek(int64_t pos) override;
+	virtual int64_t tell() const override;
+	virtual int64_t size() const override {
+		return mSize;
+	}
+
+	Stats getStats() const;
+
+private:
+	virtual void threadEntry() override;
+	bool canFetch_l() const;
+	void trim_l();
+
+	std::shared_ptr<ByteReader> mUpstream;
+	size_t mCapacity;
+	size_t mChunk;
+	size_t mKeepBehind;		// bytes kept before the read position
+	int64_t mSize;
+
+	mutable std::mutex mLock;
+	std::condition_variable mCondition;
+
+	// the file bytes [mStart, mStart + mLength) are at mRing[offset % mCapacity]
+	std::unique_ptr<uint8_t[]> mRing;
+	int64_t mStart;
+	int64_t mLength;
+	int64_t mPos;
+	int mGeneration;		// bumped by every seek that drops the window
+	bool mEof;
+	bool mError;
+
+	Stats mStats;
+};
+
+}
+
+#endif
@@ -0,0 +1,460 @@
+/*
+ * StreamInfoCache.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "log.hpp"
+#include "StreamInfoCache.hpp"
+#include "CacheFile.hpp"
+#include "KeyframeIndex.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+static const uint32_t CACHE_MAGIC = 'WBSI';
+static const uint32_t CACHE_VERSION = 1;
+static const uint32_t INDEX_MAGIC = 'WBKI';
+static const uint32_t INDEX_VERSION = 1;
+static const uint32_t MAX_STREAMS = 64;
+static const uint32_t MAX_EXTRADATA = 1 << 20;
+
+struct CacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	int64_t size;
+	int64_t mtimeNs;
+	int64_t duration;
+	int64_t startTime;
+	int64_t bitRate;
+	uint32_t pathLength;
+	uint32_t streams;
+};
+
+struct IndexHeader {
+	uint32_t magic;
+	uint32_t version;
+	int64_t size;
+	int64_t mtimeNs;
+	uint32_t pathLength;
+};
+
+// fixed width copy of AVCodecParameters and the stream timing
+struct StreamRecord {
+	int32_t codecType;
+	int32_t codecId;
+	uint32_t codecTag;
+	int32_t format;
+	int64_t bitRate;
+	int32_t bitsPerCodedSample;
+	int32_t bitsPerRawSample;
+	int32_t profile;
+	int32_t level;
+	int32_t width;
+	int32_t height;
+	int32_t sarNum;
+	int32_t sarDen;
+	int32_t fieldOrder;
+	int32_t colorRange;
+	int32_t colorPrimaries;
+	int32_t colorTrc;
+	int32_t colorSpace;
+	int32_t chromaLocation;
+	int32_t videoDelay;
+	uint64_t channelLayout;
+	int32_t channels;
+	int32_t sampleRate;
+	int32_t blockAlign;
+	int32_t frameSize;
+	int32_t initialPadding;
+	int32_t trailingPadding;
+	int32_t seekPreroll;
+	int32_t avgFrameRateNum;
+	int32_t avgFrameRateDen;
+	int32_t rFrameRateNum;
+	int32_t rFrameRateDen;
+	int64_t startTime;
+	int64_t duration;
+	int64_t nbFrames;
+	uint32_t extradataSize;
+};
+
+static void recordFromStream(StreamRecord &rec, const AVStream *st)
+{
+	const AVCodecParameters *par = st->codecpar;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.codecType = par->codec_type;
+	rec.codecId = par->codec_id;
+	rec.codecTag = par->codec_tag;
+	rec.format = par->format;
+	rec.bitRate = par->bit_rate;
+	rec.bitsPerCodedSample = par->bits_per_coded_sample;
+	rec.bitsPerRawSample = par->bits_per_raw_sample;
+	rec.profile = par->profile;
+	rec.level = par->level;
+	rec.width = par->width;
+	rec.height = par->height;
+	rec.sarNum = par->sample_aspect_ratio.num;
+	rec.sarDen = par->sample_aspect_ratio.den;
+	rec.fieldOrder = par->field_order;
+	rec.colorRange = par->color_range;
+	rec.colorPrimaries = par->color_primaries;
+	rec.colorTrc = par->color_trc;
+	rec.colorSpace = par->color_space;
+	rec.chromaLocation = par->chroma_location;
+	rec.videoDelay = par->video_delay;
+	rec.channelLayout = par->channel_layout;
+	rec.channels = par->channels;
+	rec.sampleRate = par->sample_rate;
+	rec.blockAlign = par->block_align;
+	rec.frameSize = par->frame_size;
+	rec.initialPadding = par->initial_padding;
+	rec.trailingPadding = par->trailing_padding;
+	rec.seekPreroll = par->seek_preroll;
+	rec.avgFrameRateNum = st->avg_frame_rate.num;
+	rec.avgFrameRateDen = st->avg_frame_rate.den;
+	rec.rFrameRateNum = st->r_frame_rate.num;
+	rec.rFrameRateDen = st->r_frame_rate.den;
+	rec.startTime = st->start_time;
+	rec.duration = st->duration;
+	rec.nbFrames = st->nb_frames;
+	rec.extradataSize = par->extradata ? par->extradata_size : 0;
+}
+
+static int streamFromRecord(AVStream *st, const StreamRecord &rec, const uint8_t *extradata)
+{
+	AVCodecParameters *par = st->codecpar;
+
+	uint8_t *data = nullptr;
+	if (rec.extradataSize > 0) {
+		data = (uint8_t *)av_mallocz(rec.extradataSize + AV_INPUT_BUFFER_PADDING_SIZE);
+		if (!data) {
+			return -1;
+		}
+		memcpy(data, extradata, rec.extradataSize);
+	}
+
+	av_freep(&par->extradata);
+	par->extradata = data;
+	par->extradata_size = rec.extradataSize;
+
+	par->codec_type = (enum AVMediaType)rec.codecType;
+	par->codec_id = (enum AVCodecID)rec.codecId;
+	par->codec_tag = rec.codecTag;
+	par->format = rec.format;
+	par->bit_rate = rec.bitRate;
+	par->bits_per_coded_sample = rec.bitsPerCodedSample;
+	par->bits_per_raw_sample = rec.bitsPerRawSample;
+	par->profile = rec.profile;
+	par->level = rec.level;
+	par->width = rec.width;
+	par->height = rec.height;
+	par->sample_aspect_ratio = (AVRational){rec.sarNum, rec.sarDen};
+	par->field_order = (enum AVFieldOrder)rec.fieldOrder;
+	par->color_range = (enum AVColorRange)rec.colorRange;
+	par->color_primaries = (enum AVColorPrimaries)rec.colorPrimaries;
+	par->color_trc = (enum AVColorTransferCharacteristic)rec.colorTrc;
+	par->color_space = (enum AVColorSpace)rec.colorSpace;
+	par->chroma_location = (enum AVChromaLocation)rec.chromaLocation;
+	par->video_delay = rec.videoDelay;
+	par->channel_layout = rec.channelLayout;
+	par->channels = rec.channels;
+	par->sample_rate = rec.sampleRate;
+	par->block_align = rec.blockAlign;
+	par->frame_size = rec.frameSize;
+	par->initial_padding = rec.initialPadding;
+	par->trailing_padding = rec.trailingPadding;
+	par->seek_preroll = rec.seekPreroll;
+
+	st->avg_frame_rate = (AVRational){rec.avgFrameRateNum, rec.avgFrameRateDen};
+	st->r_frame_rate = (AVRational){rec.rFrameRateNum, rec.rFrameRateDen};
+	if (st->start_time == AV_NOPTS_VALUE) {
+		st->start_time = rec.startTime;
+	}
+	if (st->duration == AV_NOPTS_VALUE) {
+		st->duration = rec.duration;
+	}
+	if (st->nb_frames == 0) {
+		st->nb_frames = rec.nbFrames;
+	}
+
+	// the decoders and MediaSource still use the deprecated stream context,
+	// filled by avformat_find_stream_info() on a probe, so it is kept in sync
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+	return avcodec_parameters_to_context(st->codec, par) < 0 ? -1 : 0;
+#pragma GCC diagnostic pop
+}
+
+StreamInfoCache &StreamInfoCache::instance()
+{
+	static StreamInfoCache cache;
+	return cache;
+}
+
+StreamInfoCache::StreamInfoCache()
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+void StreamInfoCache::setDirectory(const string &dir)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mDirectory = dir;
+}
+
+string StreamInfoCache::getPath(const string &path, const char *prefix)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "/%s_%016llx.bin", prefix, (unsigned long long)CacheFile::hash(path));
+
+	return mDirectory + name;
+}
+
+int StreamInfoCache::load(const string &uri, AVFormatContext *ctx)
+{
+	unique_lock<mutex> autoLock(mLock);
+	int64_t size, mtimeNs;
+	string file;
+
+	if (mDirectory.empty() || !CacheFile::getFileKey(uri, file, size, mtimeNs)) {
+		return -1;
+	}
+
+	string path = getPath(file, "streaminfo");
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp) {
+		mStats.misses++;
+		return -1;
+	}
+
+	CacheHeader header;
+	vector<char> entryUri;
+	vector<StreamRecord> records;
+	vector<vector<uint8_t> > extradata;
+
+	bool valid = fread(&header, sizeof(header), 1, fp) == 1
+			  && header.magic == CACHE_MAGIC
+			  && header.version == CACHE_VERSION
+			  && header.streams <= MAX_STREAMS
+			  && header.pathLength == file.size();
+
+	if (valid) {
+		entryUri.resize(header.pathLength);
+		valid = fread(entryUri.data(), 1, entryUri.size(), fp) == entryUri.size();
+	}
+
+	records.resize(valid ? header.streams : 0);
+	extradata.resize(records.size());
+
+	for (size_t i = 0; valid && i < records.size(); ++i) {
+		valid = fread(&records[i], sizeof(StreamRecord), 1, fp) == 1
+			 && records[i].extradataSize <= MAX_EXTRADATA;
+		if (valid) {
+			extradata[i].resize(records[i].extradataSize);
+			valid = fread(extradata[i].data(), 1, extradata[i].size(), fp) == extradata[i].size();
+		}
+	}
+
+	fclose(fp);
+
+	if (!valid) {
+		LOGE("Invalid stream info cache %s", path.c_str());
+		::remove(path.c_str());
+		mStats.misses++;
+		return -1;
+	}
+
+	if (memcmp(entryUri.data(), file.data(), file.size()) || header.size != size
+		|| header.mtimeNs != mtimeNs) {
+		LOGD("Stream info cache stale for %s", uri.c_str());
+		mStats.misses++;
+		return -1;
+	}
+
+	// streams added while reading packets can only be found by probing
+	bool match = !(ctx->ctx_flags & AVFMTCTX_NOHEADER) && ctx->nb_streams == header.streams;
+
+	for (unsigned int i = 0; match && i < ctx->nb_streams; ++i) {
+		const AVCodecParameters *par = ctx->streams[i]->codecpar;
+
+		if ((par->codec_type != AVMEDIA_TYPE_UNKNOWN && par->codec_type != records[i].codecType)
+			|| (par->codec_id != AV_CODEC_ID_NONE && par->codec_id != records[i].codecId)) {
+			match = false;
+		}
+	}
+
+	if (!match) {
+		LOGD("Stream info cache does not match the header of %s", uri.c_str());
+		mStats.misses++;
+		return -1;
+	}
+
+	for (unsigned int i = 0; i < ctx->nb_streams; ++i) {
+		if (streamFromRecord(ctx->streams[i], records[i], extradata[i].data()) < 0) {
+			LOGE("Apply stream info failed");
+			mStats.misses++;
+			return -1;
+		}
+	}
+
+	if (ctx->duration == AV_NOPTS_VALUE) {
+		ctx->duration = header.duration;
+	}
+	if (ctx->start_time == AV_NOPTS_VALUE) {
+		ctx->start_time = header.startTime;
+	}
+	if (ctx->bit_rate == 0) {
+		ctx->bit_rate = header.bitRate;
+	}
+
+	mStats.hits++;
+
+	return 0;
+}
+
+int StreamInfoCache::store(const string &uri, AVFormatContext *ctx)
+{
+	unique_lock<mutex> autoLock(mLock);
+	CacheHeader header;
+	string file;
+
+	if (mDirectory.empty() || ctx->nb_streams > MAX_STREAMS
+		|| !CacheFile::getFileKey(uri, file, header.size, header.mtimeNs)) {
+		return -1;
+	}
+
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.duration = ctx->duration;
+	header.startTime = ctx->start_time;
+	header.bitRate = ctx->bit_rate;
+	header.pathLength = file.size();
+	header.streams = ctx->nb_streams;
+
+	int ret = CacheFile::writeAtomic(getPath(file, "streaminfo"), [&](FILE *fp) {
+		bool written = fwrite(&header, sizeof(header), 1, fp) == 1
+					&& fwrite(file.data(), 1, file.size(), fp) == file.size();
+
+		for (unsigned int i = 0; written && i < ctx->nb_streams; ++i) {
+			StreamRecord rec;
+			recordFromStream(rec, ctx->streams[i]);
+
+			written = rec.extradataSize <= MAX_EXTRADATA
+				   && fwrite(&rec, sizeof(rec), 1, fp) == 1
+				   && fwrite(ctx->streams[i]->codecpar->extradata, 1, rec.extradataSize, fp) == rec.extradataSize;
+		}
+
+		return written;
+	});
+
+	if (ret < 0) {
+		return -1;
+	}
+
+	mStats.stores++;
+
+	return 0;
+}
+
+int StreamInfoCache::loadIndex(const string &uri, KeyframeIndex &index)
+{
+	unique_lock<mutex> autoLock(mLock);
+	int64_t size, mtimeNs;
+	string file;
+
+	if (mDirectory.empty() || !CacheFile::getFileKey(uri, file, size, mtimeNs)) {
+		return -1;
+	}
+
+	string path = getPath(file, "keyindex");
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp) {
+		return -1;
+	}
+
+	IndexHeader header;
+	vector<char> entryUri;
+
+	bool valid = fread(&header, sizeof(header), 1, fp) == 1
+			  && header.magic == INDEX_MAGIC
+			  && header.version == INDEX_VERSION
+			  && header.pathLength == file.size();
+
+	if (valid) {
+		entryUri.resize(header.pathLength);
+		valid = fread(entryUri.data(), 1, entryUri.size(), fp) == entryUri.size()
+			 && !memcmp(entryUri.data(), file.data(), file.size())
+			 && header.size == size && header.mtimeNs == mtimeNs;
+	}
+
+	KeyframeIndex loaded;
+	valid = valid && loaded.read(fp) == 0;
+
+	fclose(fp);
+
+	if (!valid) {
+		LOGD("Drop keyframe index %s", path.c_str());
+		::remove(path.c_str());
+		return -1;
+	}
+
+	index = loaded;
+
+	return 0;
+}
+
+int StreamInfoCache::storeIndex(const string &uri, KeyframeIndex &index)
+{
+	unique_lock<mutex> autoLock(mLock);
+	IndexHeader header;
+	string file;
+
+	if (mDirectory.empty() || !CacheFile::getFileKey(uri, file, header.size, header.mtimeNs)) {
+		return -1;
+	}
+
+	header.magic = INDEX_MAGIC;
+	header.version = INDEX_VERSION;
+	header.pathLength = file.size();
+
+	int ret = CacheFile::writeAtomic(getPath(file, "keyindex"), [&](FILE *fp) {
+		return fwrite(&header, sizeof(header), 1, fp) == 1
+			&& fwrite(file.data(), 1, file.size(), fp) == file.size()
+			&& index.write(fp) == 0;
+	});
+
+	if (ret < 0) {
+		return -1;
+	}
+
+	index.clearDirty();
+
+	return 0;
+}
+
+void StreamInfoCache::remove(const string &uri)
+{
+	unique_lock<mutex> autoLock(mLock);
+	string file;
+
+	if (mDirectory.empty() || !CacheFile::localPath(uri, file)) {
+		return;
+	}
+
+	::remove(getPath(file, "streaminfo").c_str());
+	::remove(getPath(file, "keyindex").c_str());
+}
+
+StreamInfoCache::Stats StreamInfoCache::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mStats;
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ * StreamInfoCache.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_STREAMINFOCACHE_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_STREAMINFOCACHE_H_
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+namespace whitebean {
+
+class KeyframeIndex;
+
+/*
+ * What avformat_find_stream_info() found for a local file, kept on disk so
+ * that opening it again can skip probing. An entry is keyed by path, size
+ * and mtime, a file that changed is a miss; a file: uri is keyed on the
+ * path it names. It holds the codec parameters and extradata of every
+ * stream, and the durations. The keyframe index of
+ * the file is kept next to it under the same key. Without a directory or
+ * for anything that can not be stat()ed every lookup is a miss.
+ */
+class StreamInfoCache {
+public:
+	struct Stats {
+		int hits;
+		int misses;
+		int stores;
+	};
+
+	static StreamInfoCache &instance();
+
+	void setDirectory(const std::string &dir);
+
+	/*
+	 * Fill the streams of a context opened with avformat_open_input() from
+	 * the cache. Returns -1 on a miss or if the streams found in the header
+	 * do not match the entry, the context is then left untouched. When
+	 * applying the entry fails part way, which takes running out of memory,
+	 * -1 comes back with the first streams filled; probing the context in
+	 * full sets them all again.
+	 */
+	int load(const std::string &uri, AVFormatContext *ctx);
+
+	/*
+	 * Save the streams of a fully probed context
+	 */
+	int store(const std::string &uri, AVFormatContext *ctx);
+
+	int loadIndex(const std::string &uri, KeyframeIndex &index);
+	int storeIndex(const std::string &uri, KeyframeIndex &index);
+
+	/*
+	 * Drop the stream info and the keyframe index of uri
+	 */
+	void remove(const std::string &uri);
+
+	Stats getStats() const;
+
+private:
+	StreamInfoCache();
+	StreamInfoCache(const StreamInfoCache &) = delete;
+	StreamInfoCache &operator=(const StreamInfoCache &) = delete;
+
+	std::string getPath(const std::string &path, const char *prefix);
+
+	mutable std::mutex mLock;
+	std::string mDirectory;
+	Stats mStats;
+};
+
+}
+
+#endif
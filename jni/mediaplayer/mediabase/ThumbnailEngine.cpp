@@ -0,0 +1,545 @@
+/*
+ * ThumbnailEngine.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include "log.hpp"
+#include "ThumbnailEngine.hpp"
+#include "CacheFile.hpp"
+#include "MediaSource.hpp"
+#include "MediaCodec.hpp"
+#include "../MediaRuntime.hpp"
+
+using namespace std;
+
+namespace whitebean {
+
+static const uint32_t THUMB_MAGIC = 'WBTN';
+static const uint32_t THUMB_VERSION = 1;
+static const int MAX_THUMB_SIZE = 4096;
+
+// packets read after a seek while looking for the key frame
+static const int MAX_SKIPPED_PACKETS = 256;
+
+struct ThumbHeader {
+	uint32_t magic;
+	uint32_t version;
+	int64_t size;
+	int64_t mtimeNs;
+	int64_t timeUs;
+	int32_t requestWidth;
+	int32_t requestHeight;
+	int64_t ptsUs;
+	int32_t width;
+	int32_t height;
+	uint32_t dataSize;
+	uint32_t pathLength;
+};
+
+struct ThumbnailEngine::Worker {
+	Worker(): streamId(-1), srcWidth(0), srcHeight(0), srcFormat(-1), dstWidth(0), dstHeight(0) {
+		filterCtx.bufferSinkCtx = nullptr;
+		filterCtx.bufferSrcCtx = nullptr;
+	}
+
+	// the file kept open, empty if none
+	string uri;
+	shared_ptr<MediaSource> source;
+	shared_ptr<AVCodecContext> codec;
+	int streamId;
+
+	// the scale filter is rebuilt when any of these change
+	FilterContext filterCtx;
+	int srcWidth;
+	int srcHeight;
+	int srcFormat;
+	int dstWidth;
+	int dstHeight;
+};
+
+ThumbnailEngine::ThumbnailEngine(int threads)
+: mThreadCount(threads)
+, mStopped(false)
+{
+	if (mThreadCount <= 0) {
+		mThreadCount = max(1, (int)thread::hardware_concurrency());
+	}
+
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+ThumbnailEngine::~ThumbnailEngine()
+{
+	stop();
+}
+
+ThumbnailEngine &ThumbnailEngine::instance()
+{
+	static ThumbnailEngine engine;
+	return engine;
+}
+
+void ThumbnailEngine::setDirectory(const string &dir)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mDirectory = dir;
+}
+
+int ThumbnailEngine::request(const string &uri, int64_t timeUs, int width, int height, Callback callback)
+{
+	if (width <= 0 || height <= 0 || width > MAX_THUMB_SIZE || height > MAX_THUMB_SIZE) {
+		LOGE("Invalid thumbnail size %dx%d", width, height);
+		return -1;
+	}
+
+	unique_lock<mutex> autoLock(mLock);
+
+	mRoomCondition.wait(autoLock, [&] { return mStopped || mJobs.size() < MAX_PENDING; });
+	if (mStopped) {
+		return -1;
+	}
+
+	if (mThreads.empty()) {
+		startWorkers_l();
+	}
+
+	Job job = {uri, timeUs, width, height, callback};
+	mJobs.push_back(job);
+	mStats.requests++;
+	mJobCondition.notify_one();
+
+	return 0;
+}
+
+int ThumbnailEngine::extract(const string &uri, int64_t timeUs, int width, int height, Thumbnail &thumb)
+{
+	mutex doneLock;
+	condition_variable doneCondition;
+	bool done = false;
+	int result = -1;
+
+	// the callback always runs, from a worker or from stop()
+	int ret = request(uri, timeUs, width, height, [&](int status, const Thumbnail &decoded) {
+		unique_lock<mutex> autoLock(doneLock);
+		result = status;
+		if (status == 0) {
+			thumb = decoded;
+		}
+		done = true;
+		doneCondition.notify_all();
+	});
+
+	if (ret < 0) {
+		return -1;
+	}
+
+	unique_lock<mutex> autoLock(doneLock);
+	doneCondition.wait(autoLock, [&] { return done; });
+
+	return result;
+}
+
+void ThumbnailEngine::stop()
+{
+	deque<Job> dropped;
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+		mStopped = true;
+		dropped.swap(mJobs);
+		mJobCondition.notify_all();
+		mRoomCondition.notify_all();
+	}
+
+	for (auto &t : mThreads) {
+		t.join();
+	}
+	mThreads.clear();
+
+	Thumbnail empty = {-1, 0, 0, vector<uint8_t>()};
+	for (auto &job : dropped) {
+		job.callback(-1, empty);
+	}
+}
+
+ThumbnailEngine::Stats ThumbnailEngine::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mStats;
+}
+
+void ThumbnailEngine::startWorkers_l()
+{
+	LOGD("Thumbnail engine starts %d workers", mThreadCount);
+
+	// the workers open demuxers and codecs in parallel, which takes the
+	// FFmpeg lock manager
+	MediaRuntime::instance().initFFmpeg();
+
+	for (int i = 0; i < mThreadCount; ++i) {
+		mThreads.push_back(thread(&ThumbnailEngine::workerEntry, this));
+	}
+}
+
+bool ThumbnailEngine::takeJob(const string &openUri, Job &job)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	mJobCondition.wait(autoLock, [&] { return mStopped || !mJobs.empty(); });
+	if (mStopped) {
+		return false;
+	}
+
+	// the open file first, its demuxer and decoder are ready
+	auto it = find_if(mJobs.begin(), mJobs.end(), [&](const Job &j) { return j.uri == openUri; });
+	if (it == mJobs.end()) {
+		it = mJobs.begin();
+	}
+
+	job = *it;
+	mJobs.erase(it);
+	mRoomCondition.notify_one();
+
+	return true;
+}
+
+void ThumbnailEngine::workerEntry()
+{
+	Worker worker;
+	Job job;
+
+	while (takeJob(worker.uri, job)) {
+		Thumbnail thumb = {-1, 0, 0, vector<uint8_t>()};
+
+		if (loadCache(job, thumb) == 0) {
+			{
+				unique_lock<mutex> autoLock(mLock);
+				mStats.cacheHits++;
+			}
+			job.callback(0, thumb);
+			continue;
+		}
+
+		auto start = chrono::steady_clock::now();
+		int status = decode(worker, job, thumb);
+		int64_t decodeUs = chrono::duration_cast<chrono::microseconds>(
+			chrono::steady_clock::now() - start).count();
+
+		{
+			unique_lock<mutex> autoLock(mLock);
+			mStats.decodeUs += decodeUs;
+			if (status == 0) {
+				mStats.decoded++;
+			} else {
+				mStats.failed++;
+			}
+		}
+
+		if (status == 0) {
+			storeCache(job, thumb);
+		} else {
+			LOGE("Thumbnail of %s at %lld failed", job.uri.c_str(), (long long)job.timeUs);
+		}
+
+		job.callback(status, thumb);
+	}
+
+	if (worker.source) {
+		worker.source->stop();
+	}
+}
+
+int ThumbnailEngine::decode(Worker &worker, const Job &job, Thumbnail &thumb)
+{
+	if (worker.uri != job.uri) {
+		if (worker.source) {
+			worker.source->stop();
+		}
+		worker = Worker();
+
+		shared_ptr<MediaSource> source(new MediaSource);
+
+		// a few scattered key frames, read ahead would be wasted
+		source->setPrefetchSize(0);
+
+		if (source->open(job.uri) < 0 || source->getVideoStreamId() < 0) {
+			LOGE("No video in %s", job.uri.c_str());
+			return -1;
+		}
+
+		AVFormatContext *ctx = source->getFmtCtxPtr().get();
+		int streamId = source->getVideoStreamId();
+
+		shared_ptr<AVCodecContext> codec = openStreamCodec(ctx->streams[streamId]);
+		if (!codec) {
+			return -1;
+		}
+
+		// only key frames of the video are demuxed and decoded
+		for (unsigned int i = 0; i < ctx->nb_streams; ++i) {
+			ctx->streams[i]->discard = (int)i == streamId ? AVDISCARD_NONKEY : AVDISCARD_ALL;
+		}
+		codec->skip_frame = AVDISCARD_NONKEY;
+
+		worker.uri = job.uri;
+		worker.source = source;
+		worker.codec = codec;
+		worker.streamId = streamId;
+
+		unique_lock<mutex> autoLock(mLock);
+		mStats.opens++;
+	}
+
+	AVFormatContext *ctx = worker.source->getFmtCtxPtr().get();
+	AVStream *st = ctx->streams[worker.streamId];
+
+	int64_t timeUs = job.timeUs;
+	if (timeUs < 0) {
+		// past black intros and titles
+		timeUs = ctx->duration > 0 ? ctx->duration / 10 : 0;
+	}
+
+	// as the player seeks, without the start time
+	int64_t ts = av_rescale_q(timeUs, AV_TIME_BASE_Q, st->time_base);
+	if (av_seek_frame(ctx, worker.streamId, ts, AVSEEK_FLAG_BACKWARD) < 0
+		&& av_seek_frame(ctx, worker.streamId, ts, 0) < 0) {
+		LOGE("Thumbnail seek to %lld failed", (long long)ts);
+		return -1;
+	}
+
+	avcodec_flush_buffers(worker.codec.get());
+
+	AVPacket packet;
+	int skipped = 0;
+
+	// not every demuxer honours AVDISCARD_NONKEY
+	while (1) {
+		av_init_packet(&packet);
+		packet.data = NULL;
+		packet.size = 0;
+
+		if (av_read_frame(ctx, &packet) < 0) {
+			return -1;
+		}
+
+		if (packet.stream_index == worker.streamId && (packet.flags & AV_PKT_FLAG_KEY)) {
+			break;
+		}
+
+		av_packet_unref(&packet);
+		if (++skipped > MAX_SKIPPED_PACKETS) {
+			return -1;
+		}
+	}
+
+	FrameBuffer frmbuf;
+
+	int ret = avcodec_send_packet(worker.codec.get(), &packet);
+	av_packet_unref(&packet);
+
+	// a decoder with delay only gives the picture back once drained, the
+	// flush of the next job takes it out of draining
+	if (ret >= 0) {
+		ret = avcodec_receive_frame(worker.codec.get(), frmbuf.getDataPtr());
+		if (ret == AVERROR(EAGAIN) && avcodec_send_packet(worker.codec.get(), NULL) >= 0) {
+			ret = avcodec_receive_frame(worker.codec.get(), frmbuf.getDataPtr());
+		}
+	}
+
+	if (ret < 0) {
+		LOGE("No key frame decoded");
+		return -1;
+	}
+
+	// fit in the requested size, even dimensions for the chroma planes
+	int width = job.width;
+	int height = (int)((int64_t)frmbuf.getHeight() * job.width / frmbuf.getWidth());
+	if (height > job.height) {
+		height = job.height;
+		width = (int)((int64_t)frmbuf.getWidth() * job.height / frmbuf.getHeight());
+	}
+	width = max(2, width & ~1);
+	height = max(2, height & ~1);
+
+	if (!worker.filterCtx.filterGraph || worker.srcWidth != frmbuf.getWidth()
+		|| worker.srcHeight != frmbuf.getHeight() || worker.srcFormat != frmbuf.getFormat()
+		|| worker.dstWidth != width || worker.dstHeight != height) {
+		// the buffer source takes the picture size from the codec
+		worker.codec->width = frmbuf.getWidth();
+		worker.codec->height = frmbuf.getHeight();
+		worker.codec->pix_fmt = (enum AVPixelFormat)frmbuf.getFormat();
+
+		worker.filterCtx.filterGraph.reset();
+		if (initVideoFilters(worker.filterCtx, worker.codec.get(), width, height, AV_PIX_FMT_RGB565LE) < 0) {
+			LOGE("Init thumbnail filter failed");
+			worker.filterCtx.filterGraph.reset();
+			return -1;
+		}
+
+		worker.srcWidth = frmbuf.getWidth();
+		worker.srcHeight = frmbuf.getHeight();
+		worker.srcFormat = frmbuf.getFormat();
+		worker.dstWidth = width;
+		worker.dstHeight = height;
+	}
+
+	FrameBuffer scaled;
+	if (av_buffersrc_add_frame_flags(worker.filterCtx.bufferSrcCtx, frmbuf.getDataPtr(), 0) < 0
+		|| av_buffersink_get_frame(worker.filterCtx.bufferSinkCtx, scaled.getDataPtr()) < 0) {
+		LOGE("Scale thumbnail failed");
+		return -1;
+	}
+
+	thumb.width = scaled.getWidth();
+	thumb.height = scaled.getHeight();
+	thumb.pixels.resize(thumb.width * thumb.height * 2);
+
+	for (int y = 0; y < thumb.height; ++y) {
+		memcpy(&thumb.pixels[y * thumb.width * 2],
+			   scaled.getDataPlane(0) + y * scaled.getLineSize(0), thumb.width * 2);
+	}
+
+	int64_t pts = frmbuf.getPts();
+	thumb.ptsUs = pts == AV_NOPTS_VALUE ? -1
+		: pts * US_IN_SECOND * st->time_base.num / st->time_base.den;
+
+	return 0;
+}
+
+string ThumbnailEngine::getCachePath(const Job &job)
+{
+	// the path and the request, the entry holds them in full
+	int64_t fields[] = {job.timeUs, job.width, job.height};
+	uint64_t hash = CacheFile::hash(fields, sizeof(fields), CacheFile::hash(job.uri));
+
+	char name[64];
+	snprintf(name, sizeof(name), "/thumb_%016llx.bin", (unsigned long long)hash);
+
+	return mDirectory + name;
+}
+
+int ThumbnailEngine::loadCache(const Job &job, Thumbnail &thumb)
+{
+	int64_t size, mtimeNs;
+	string path, file;
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+		if (mDirectory.empty()) {
+			return -1;
+		}
+		path = getCachePath(job);
+	}
+
+	if (!CacheFile::getFileKey(job.uri, file, size, mtimeNs)) {
+		return -1;
+	}
+
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp) {
+		return -1;
+	}
+
+	ThumbHeader header;
+	vector<char> entryUri;
+	vector<uint8_t> data;
+
+	bool valid = fread(&header, sizeof(header), 1, fp) == 1
+			  && header.magic == THUMB_MAGIC
+			  && header.version == THUMB_VERSION
+			  && header.pathLength == job.uri.size()
+			  && header.width > 0 && header.width <= MAX_THUMB_SIZE
+			  && header.height > 0 && header.height <= MAX_THUMB_SIZE
+			  && header.dataSize <= compressBound(header.width * header.height * 2);
+
+	if (valid) {
+		entryUri.resize(header.pathLength);
+		data.resize(header.dataSize);
+		valid = fread(entryUri.data(), 1, entryUri.size(), fp) == entryUri.size()
+			 && fread(data.data(), 1, data.size(), fp) == data.size();
+	}
+
+	fclose(fp);
+
+	if (!valid) {
+		LOGE("Invalid thumbnail cache %s", path.c_str());
+		remove(path.c_str());
+		return -1;
+	}
+
+	// another request or a changed file with the same hash
+	if (memcmp(entryUri.data(), job.uri.data(), job.uri.size()) || header.size != size
+		|| header.mtimeNs != mtimeNs || header.timeUs != job.timeUs
+		|| header.requestWidth != job.width || header.requestHeight != job.height) {
+		return -1;
+	}
+
+	thumb.pixels.resize(header.width * header.height * 2);
+	uLongf length = thumb.pixels.size();
+
+	if (uncompress(thumb.pixels.data(), &length, data.data(), data.size()) != Z_OK
+		|| length != thumb.pixels.size()) {
+		LOGE("Corrupt thumbnail cache %s", path.c_str());
+		remove(path.c_str());
+		return -1;
+	}
+
+	thumb.ptsUs = header.ptsUs;
+	thumb.width = header.width;
+	thumb.height = header.height;
+
+	return 0;
+}
+
+void ThumbnailEngine::storeCache(const Job &job, const Thumbnail &thumb)
+{
+	ThumbHeader header;
+	string path, file;
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+		if (mDirectory.empty()) {
+			return;
+		}
+		path = getCachePath(job);
+	}
+
+	if (!CacheFile::getFileKey(job.uri, file, header.size, header.mtimeNs)) {
+		return;
+	}
+
+	vector<uint8_t> data(compressBound(thumb.pixels.size()));
+	uLongf length = data.size();
+
+	if (compress2(data.data(), &length, thumb.pixels.data(), thumb.pixels.size(), Z_BEST_SPEED) != Z_OK) {
+		LOGE("Compress thumbnail failed");
+		return;
+	}
+
+	header.magic = THUMB_MAGIC;
+	header.version = THUMB_VERSION;
+	header.timeUs = job.timeUs;
+	header.requestWidth = job.width;
+	header.requestHeight = job.height;
+	header.ptsUs = thumb.ptsUs;
+	header.width = thumb.width;
+	header.height = thumb.height;
+	header.dataSize = length;
+	header.pathLength = job.uri.size();
+
+	// two workers on the same request both write it, either one is kept
+	CacheFile::writeAtomic(path, [&](FILE *fp) {
+		return fwrite(&header, sizeof(header), 1, fp) == 1
+			&& fwrite(job.uri.data(), 1, job.uri.size(), fp) == job.uri.size()
+			&& fwrite(data.data(), 1, length, fp) == length;
+	});
+}
+
+}
@@ -0,0 +1,126 @@
+/*
+ * ThumbnailEngine.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIAPLAYER_MEDIABASE_THUMBNAILENGINE_H_
+#define JNI_MEDIAPLAYER_MEDIABASE_THUMBNAILENGINE_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace whitebean {
+
+/*
+ * Thumbnails of video files, for file lists and seek bar previews. Only the
+ * key frame at or before the requested time is demuxed and decoded, then
+ * scaled down to fit the requested size by the scale filter. A fixed pool
+ * of workers runs the requests, each keeping its last file open, and a
+ * worker picks the requests for its open file first, so that many times of
+ * one file are spread over the pool without reopening it for each. Results
+ * are kept zlib compressed on disk, keyed by path, size and mtime of the
+ * file as the stream info cache is.
+ */
+class ThumbnailEngine {
+public:
+	struct Thumbnail {
+		int64_t ptsUs;		// of the key frame shown
+		int width;
+		int height;
+		std::vector<uint8_t> pixels;	// RGB565, width * height * 2 bytes
+	};
+
+	struct Stats {
+		int requests;
+		int cacheHits;
+		int decoded;
+		int failed;
+		int opens;			// files opened by the workers
+		int64_t decodeUs;	// summed over the workers
+	};
+
+	typedef std::function<void(int status, const Thumbnail &thumb)> Callback;
+
+	static const int MAX_PENDING = 256;
+
+	/*
+	 * threads 0 is one worker per core. The workers start with the first
+	 * request.
+	 */
+	explicit ThumbnailEngine(int threads = 0);
+	~ThumbnailEngine();
+
+	// shared by the players of the process
+	static ThumbnailEngine &instance();
+
+	void setDirectory(const std::string &dir);
+
+	/*
+	 * Queue a thumbnail of uri at timeUs, or a tenth into the file for a
+	 * negative timeUs, that fits in width x height with its aspect ratio.
+	 * callback runs on a worker with status 0 or -1. Blocks while
+	 * MAX_PENDING requests are queued, returns -1 once stopped.
+	 */
+	int request(const std::string &uri, int64_t timeUs, int width, int height, Callback callback);
+
+	/*
+	 * request() and wait for it
+	 */
+	int extract(const std::string &uri, int64_t timeUs, int width, int height, Thumbnail &thumb);
+
+	/*
+	 * Drop what is queued and join the workers, their callbacks get -1
+	 */
+	void stop();
+
+	int getThreadCount() const {
+		return mThreadCount;
+	}
+
+	Stats getStats() const;
+
+private:
+	struct Job {
+		std::string uri;
+		int64_t timeUs;
+		int width;
+		int height;
+		Callback callback;
+	};
+
+	struct Worker;
+
+	ThumbnailEngine(const ThumbnailEngine &) = delete;
+	ThumbnailEngine &operator=(const ThumbnailEngine &) = delete;
+
+	void startWorkers_l();
+	void workerEntry();
+	bool takeJob(const std::string &openUri, Job &job);
+	int decode(Worker &worker, const Job &job, Thumbnail &thumb);
+
+	int loadCache(const Job &job, Thumbnail &thumb);
+	void storeCache(const Job &job, const Thumbnail &thumb);
+	std::string getCachePath(const Job &job);
+
+	int mThreadCount;
+	std::vector<std::thread> mThreads;
+
+	mutable std::mutex mLock;
+	std::condition_variable mJobCondition;
+	std::condition_variable mRoomCondition;
+	std::deque<Job> mJobs;
+	bool mStopped;
+	std::string mDirectory;
+	Stats mStats;
+};
+
+}
+
+#endif
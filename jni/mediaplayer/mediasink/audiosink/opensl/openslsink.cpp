@@ -8,12 +8,17 @@
 #include <stdlib.h>
 #include "openslsink.hpp"
 #include "log.hpp"
+#include "../../../MediaRuntime.hpp"
 
 namespace whitebean
 {
 
 OpenslSink::OpenslSink()
-	:mBuffer(nullptr)
+	:mEngine(NULL)
+	,mOutputMixObject(NULL)
+	,mPlayerObject(NULL)
+	,mPlayerPlay(NULL)
+	,mBuffer(nullptr)
 	,mCookie(nullptr)
 {
 
@@ -21,17 +26,10 @@ OpenslSink::OpenslSink()
 
 OpenslSink::~OpenslSink()
 {
-	//ͷŻ
-	if (mOutputMixObject != NULL) {
-		(*mOutputMixObject)->Destroy(mOutputMixObject);
-		mOutputMixObject = NULL;
-	}
-
-	//ͷƵ
-	if (mEngineObject != NULL) {
-		(*mEngineObject)->Destroy(mEngineObject);
-		mEngineObject = NULL;
-		mEngine = NULL;
+	// the engine and the output mix belong to MediaRuntime
+	if (mPlayerObject) {
+		(*mPlayerObject)->Destroy(mPlayerObject);
+		mPlayerObject = NULL;
 	}
 }
 
@@ -74,6 +72,10 @@ int OpenslSink::start()
 void OpenslSink::stop()
 {
 	SLresult result;
+
+	if (!mPlayerObject) {
+		return;
+	}
 	
 	result = (*mPlayerPlay)->SetPlayState(mPlayerPlay, SL_PLAYSTATE_STOPPED);
 	if(SL_RESULT_SUCCESS != result){
@@ -89,61 +91,13 @@ void OpenslSink::stop()
 
 int OpenslSink::CreateEngine()
 {
-	SLresult result;
-	const SLInterfaceID ids[1] = {SL_IID_VOLUME};
-	const SLboolean req[1] = {SL_BOOLEAN_FALSE};
-
-	// create engine
-	result = slCreateEngine(&mEngineObject, 0, NULL, 0, NULL, NULL);
-	if(SL_RESULT_SUCCESS != result){
-		LOGE("slCreateEngine failed");
-		mEngineObject = NULL;
+	// one engine per process, creating it per sink repeats costly work
+	if (MediaRuntime::instance().getOpensl(mEngine, mOutputMixObject) < 0) {
+		LOGE("OpenSL engine not available");
 		return -1;
 	}
 
-	// realize the engine
-    result = (*mEngineObject)->Realize(mEngineObject, SL_BOOLEAN_FALSE);
-    if(SL_RESULT_SUCCESS != result){
-    	LOGE("(*mEngineObject)->Realize failed");
-    	goto failed;
-    }
-
-	// get the engine interface, which is needed in order to create other objects
-    result = (*mEngineObject)->GetInterface(mEngineObject, SL_IID_ENGINE, &mEngine);
-    if(SL_RESULT_SUCCESS != result){
-       	LOGE("Get SL_IID_ENGINE failed");
-       	goto failed;
-    }
-
-	// realize the output mix
-	result = (*mEngine)->CreateOutputMix(mEngine, &mOutputMixObject, 1, ids, req);
-	if(SL_RESULT_SUCCESS != result){
-		LOGE("CreateOutputMix failed");
-		mOutputMixObject = NULL;
-		goto failed;
-	}
-
-	result = (*mOutputMixObject)->Realize(mOutputMixObject, SL_BOOLEAN_FALSE);
-	if(SL_RESULT_SUCCESS != result){
-		LOGE("(*mOutputMixObject)->Realize");
-		goto failed;
-	}
-	
 	return 0;
- failed:
-	if (mEngineObject) {
-    	(*mEngineObject)->Destroy(mEngineObject);
-    	mEngineObject = NULL;
-	}
-
-	if (mOutputMixObject) {
-		(*mOutputMixObject)->Destroy(mOutputMixObject);
-		mOutputMixObject = NULL;
-	}
-
-	mEngine = NULL;	
-	
-	return -1;
 }
 
 int OpenslSink::createBufferQueueAudioPlayer(uint32_t sampleRate,
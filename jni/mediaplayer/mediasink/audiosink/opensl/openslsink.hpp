@@ -11,7 +11,7 @@
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
 #include <memory>
-#include "audiosink.hpp"
+#include "AudioSink.hpp"
 
 namespace whitebean
 {
@@ -63,10 +63,6 @@ private:
 	 */
 	SLuint16 openslPcmFormat(pcm_format_t format);
 
-  	/**
-	  * @brief  Ƶ
-	*/
-	SLObjectItf mEngineObject;
 	/**
 	  * @brief  Ƶӿ
 	*/
@@ -16,6 +16,8 @@ namespace whitebean
 enum {
 	VIDEO_SINK_TYPE_NORMAL,
 	VIDEO_SINK_TYPE_PANORAMIC,
+	VIDEO_SINK_TYPE_CUBEMAP,
+	VIDEO_SINK_TYPE_EAC,
 };
 
 class VideoSink {
@@ -23,6 +25,8 @@ public:
 	virtual ~VideoSink() {}
 	virtual int init(int type = VIDEO_SINK_TYPE_NORMAL) = 0;
 	virtual int display(FrameBuffer &frm) = 0;
+	// show the last displayed frame again, for view changes
+	virtual int redraw() = 0;
 	virtual void onTouchMoveEvent(float dx, float dy) = 0;
 };	
 	
@@ -0,0 +1,211 @@
+/*
+ * EglContextManager.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <string.h>
+#include "log.hpp"
+#include "EglContextManager.hpp"
+#include "GLRendererFactory.hpp"
+
+using namespace std;
+
+namespace whitebean
+{
+
+static const EGLint sContextAttribs[] = {
+	EGL_CONTEXT_CLIENT_VERSION, 2,
+	EGL_NONE
+};
+
+EglContextManager &EglContextManager::instance()
+{
+	static EglContextManager manager;
+	return manager;
+}
+
+EglContextManager::EglContextManager()
+: mDisplay(EGL_NO_DISPLAY)
+, mConfig(nullptr)
+, mRootContext(EGL_NO_CONTEXT)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+int EglContextManager::init()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mRootContext != EGL_NO_CONTEXT) {
+		return 0;
+	}
+
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (EGL_NO_DISPLAY == display) {
+		LOGE("Egl get display error");
+		return -1;
+	}
+
+	EGLint majorVersion, minorVersion;
+	if (!eglInitialize(display, &majorVersion, &minorVersion)) {
+		LOGE("Egl initialize error");
+		return -1;
+	}
+
+	LOGD("EGL %d.%d", majorVersion, minorVersion);
+
+	// one config for every sink so that all contexts can share, window and
+	// pbuffer if possible, whatever the platform offers otherwise
+	EGLint surfaceTypes[] = {
+		EGL_WINDOW_BIT | EGL_PBUFFER_BIT,
+		EGL_WINDOW_BIT,
+		EGL_PBUFFER_BIT,
+	};
+
+	int num_configs = 0;
+	for (EGLint surfaceType : surfaceTypes) {
+		EGLint config_attribs[] = {
+			EGL_BLUE_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_RED_SIZE, 8,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+			EGL_SURFACE_TYPE, surfaceType,
+			EGL_NONE
+		};
+
+		if (eglChooseConfig(display, config_attribs, &mConfig, 1, &num_configs) && num_configs > 0) {
+			break;
+		}
+	}
+
+	if (num_configs <= 0) {
+		LOGE("EGL eglChooseConfig error");
+		return -1;
+	}
+
+	// never made current, it only keeps the shared objects alive
+	mRootContext = eglCreateContext(display, mConfig, EGL_NO_CONTEXT, sContextAttribs);
+	if (EGL_NO_CONTEXT == mRootContext) {
+		LOGE("EGL create root context error");
+		return -1;
+	}
+
+	mDisplay = display;
+
+	return 0;
+}
+
+EGLContext EglContextManager::acquireContext()
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mRootContext == EGL_NO_CONTEXT) {
+		return EGL_NO_CONTEXT;
+	}
+
+	if (!mIdleContexts.empty()) {
+		EGLContext context = mIdleContexts.back();
+		mIdleContexts.pop_back();
+		mStats.contextsReused++;
+		return context;
+	}
+
+	EGLContext context = eglCreateContext(mDisplay, mConfig, mRootContext, sContextAttribs);
+	if (EGL_NO_CONTEXT == context) {
+		LOGE("EGL eglCreateContext error");
+		return EGL_NO_CONTEXT;
+	}
+
+	mStats.contextsCreated++;
+
+	return context;
+}
+
+void EglContextManager::releaseContext(EGLContext context)
+{
+	if (context == EGL_NO_CONTEXT) {
+		return;
+	}
+
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mIdleContexts.size() < MAX_IDLE_CONTEXTS) {
+		mIdleContexts.push_back(context);
+		return;
+	}
+
+	eglDestroyContext(mDisplay, context);
+}
+
+shared_ptr<GLRenderer> EglContextManager::acquireRenderer(int type)
+{
+	shared_ptr<GLRenderer> renderer;
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+		vector<shared_ptr<GLRenderer> > &idle = mIdleRenderers[type];
+
+		if (!idle.empty()) {
+			renderer = idle.back();
+			idle.pop_back();
+			mStats.renderersReused++;
+		}
+	}
+
+	if (renderer) {
+		// objects are shared, but attribute and texture bindings are not
+		renderer->bind();
+		return renderer;
+	}
+
+	renderer = GLRendererFactory::create(type);
+	if (!renderer) {
+		return renderer;
+	}
+
+	if (renderer->prepare()) {
+		LOGE("Render prepare failed");
+		renderer->destroy();
+		renderer.reset();
+		return renderer;
+	}
+
+	unique_lock<mutex> autoLock(mLock);
+	mStats.renderersCreated++;
+
+	return renderer;
+}
+
+void EglContextManager::releaseRenderer(shared_ptr<GLRenderer> renderer)
+{
+	if (!renderer) {
+		return;
+	}
+
+	// the next user may be another context, make the uploads visible to it
+	glFlush();
+
+	// and another player, which starts with the default view
+	renderer->resetView();
+
+	{
+		unique_lock<mutex> autoLock(mLock);
+		vector<shared_ptr<GLRenderer> > &idle = mIdleRenderers[renderer->getType()];
+
+		if (idle.size() < MAX_IDLE_RENDERERS) {
+			idle.push_back(renderer);
+			return;
+		}
+	}
+
+	renderer->destroy();
+}
+
+EglContextManager::Stats EglContextManager::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mStats;
+}
+
+}
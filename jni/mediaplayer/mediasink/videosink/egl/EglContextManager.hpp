@@ -0,0 +1,89 @@
+/*
+ * EglContextManager.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIASINK_VIDEOSINK_EGL_EGLCONTEXTMANAGER_H_
+#define JNI_MEDIASINK_VIDEOSINK_EGL_EGLCONTEXTMANAGER_H_
+
+#include <EGL/egl.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace whitebean
+{
+class GLRenderer;
+
+/*
+ * Process-wide EGL state. The display is initialized once and never
+ * terminated. Every context handed out shares objects with a root
+ * context, so programs, buffers and textures survive a sink. Idle contexts
+ * and prepared renderers are pooled: a new sink only has to create its
+ * surface.
+ */
+class EglContextManager
+{
+public:
+	struct Stats {
+		int contextsCreated;
+		int contextsReused;
+		int renderersCreated;
+		int renderersReused;
+	};
+
+	static EglContextManager &instance();
+
+	/*
+	 * Initialize the display and the root context, once per process
+	 */
+	int init();
+
+	EGLDisplay getDisplay() const {
+		return mDisplay;
+	}
+
+	EGLConfig getConfig() const {
+		return mConfig;
+	}
+
+	/*
+	 * Context sharing objects with the root context, from the pool if one
+	 * is idle. Give it back with releaseContext() once it is not current
+	 * on any thread.
+	 */
+	EGLContext acquireContext();
+	void releaseContext(EGLContext context);
+
+	/*
+	 * Prepared renderer of a GL_RENDERER_* type. A pooled renderer gets its
+	 * per-context state bound again, its view was reset when released.
+	 * Both calls need a current context.
+	 */
+	std::shared_ptr<GLRenderer> acquireRenderer(int type);
+	void releaseRenderer(std::shared_ptr<GLRenderer> renderer);
+
+	Stats getStats() const;
+
+private:
+	EglContextManager();
+	EglContextManager(const EglContextManager &) = delete;
+	EglContextManager &operator=(const EglContextManager &) = delete;
+
+	static const int MAX_IDLE_CONTEXTS = 2;
+	static const int MAX_IDLE_RENDERERS = 2;	// per type
+
+	mutable std::mutex mLock;
+	EGLDisplay mDisplay;
+	EGLConfig mConfig;
+	EGLContext mRootContext;
+	std::vector<EGLContext> mIdleContexts;
+	std::map<int, std::vector<std::shared_ptr<GLRenderer> > > mIdleRenderers;
+	Stats mStats;
+};
+
+}
+
+#endif
@@ -8,85 +8,96 @@
 #include "log.hpp"
 #include "EglSink.hpp"
 #include "GLRendererFactory.hpp"
+#include "EglContextManager.hpp"
 
 using namespace std;
 
 namespace whitebean
 {
 
-EglSink::EglSink(ANativeWindow *nwindow)
-: mNativeWindow(nwindow)
+EglSink::EglSink(EGLNativeWindowType nwindow)
+: mOffscreen(false)
+, mNativeWindow(nwindow)
 , mEglDisplay(EGL_NO_DISPLAY)
 , mEglContext(EGL_NO_CONTEXT)
 , mEglSurface(EGL_NO_SURFACE)
 , mSurfaceWidth(0)
 , mSurfaceHeight(0)  
+, mSinkType(VIDEO_SINK_TYPE_NORMAL)
+, mRenderFormat(AV_PIX_FMT_NONE)
 {
 		
 }
 
+EglSink::EglSink(int width, int height)
+: mOffscreen(true)
+, mNativeWindow(0)
+, mEglDisplay(EGL_NO_DISPLAY)
+, mEglContext(EGL_NO_CONTEXT)
+, mEglSurface(EGL_NO_SURFACE)
+, mSurfaceWidth(width)
+, mSurfaceHeight(height)
+, mSinkType(VIDEO_SINK_TYPE_NORMAL)
+, mRenderFormat(AV_PIX_FMT_NONE)
+{
+
+}
+
 EglSink::~EglSink() {
-	if (mEglDisplay != EGL_NO_DISPLAY) {
-		eglMakeCurrent(mEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-		if (mEglContext != EGL_NO_CONTEXT) {
+	if (mEglDisplay == EGL_NO_DISPLAY) {
+		return;
+	}
+
+	EglContextManager &manager = EglContextManager::instance();
+
+	// the display is shared by all sinks and never terminated, the context
+	// and the renderer go back to the pool for the next sink
+	if (mEglContext != EGL_NO_CONTEXT) {
+		if (eglMakeCurrent(mEglDisplay, mEglSurface, mEglSurface, mEglContext)) {
+			manager.releaseRenderer(mRenderPtr);
+			mRenderPtr.reset();
+			eglMakeCurrent(mEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			manager.releaseContext(mEglContext);
+		} else {
+			LOGE("EGL eglMakeCurrent error, drop context");
+			mRenderPtr.reset();
 			eglDestroyContext(mEglDisplay, mEglContext);
 		}
-		if (mEglSurface != EGL_NO_SURFACE) {
-			eglDestroySurface(mEglDisplay, mEglSurface);
+	}
 
-		}
-		if (!eglTerminate(mEglDisplay)) {
-			LOGE( "Egl terminate error");
-		}		
+	if (mEglSurface != EGL_NO_SURFACE) {
+		eglDestroySurface(mEglDisplay, mEglSurface);
 	}
 }
 
 int EglSink::init(int type)
 {
-	GLint majorVersion;
-	GLint minorVersion;
-	
-	if (!mNativeWindow) {
+	if (!mOffscreen && !mNativeWindow) {
 		return -1;
 	}
 
-	mEglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-	if(EGL_NO_DISPLAY == mEglDisplay) {
-		LOGE("Egl get display error");
+	EglContextManager &manager = EglContextManager::instance();
+	if (manager.init() < 0) {
 		return -1;
 	}
 
-	if(!eglInitialize(mEglDisplay, &majorVersion, &minorVersion)) {
-		LOGE("Egl initialize error");
-		return -1;
-	}
+	mEglDisplay = manager.getDisplay();
+	EGLConfig eglConfig = manager.getConfig();
 
-	EGLint config_attribs[] = {
-		EGL_BLUE_SIZE, 8,
-		EGL_GREEN_SIZE, 8,
-		EGL_RED_SIZE, 8,
-		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
-		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-		EGL_NONE
-	};
-
-	int num_configs = 0;
-	EGLConfig 	eglConfig;
-	if(!eglChooseConfig(mEglDisplay, config_attribs, &eglConfig, 1, &num_configs))
-	{
-		LOGE("EGL eglChooseConfig error");
-		return -1;
-	}
+	if (mOffscreen) {
+		EGLint pbuffer_attribs[] = {
+			EGL_WIDTH, mSurfaceWidth,
+			EGL_HEIGHT, mSurfaceHeight,
+			EGL_NONE
+		};
 
-	EGLint surf_attribs[] =
-	{
-		EGL_COLORSPACE, EGL_COLORSPACE_sRGB,
-		EGL_NONE
-	};
+		mEglSurface = eglCreatePbufferSurface(mEglDisplay, eglConfig, pbuffer_attribs);
+	} else {
+		mEglSurface = eglCreateWindowSurface(mEglDisplay, eglConfig, mNativeWindow, NULL);
+	}
 
-	mEglSurface = eglCreateWindowSurface(mEglDisplay, eglConfig, mNativeWindow, NULL);
 	if(EGL_NO_SURFACE == mEglSurface) {
-		LOGE("EGL eglCreateWindowSurface error");
+		LOGE("EGL create surface error, offscreen %d", mOffscreen);
 		return -1;
 	}
 
@@ -101,14 +112,8 @@ int EglSink::init(int type)
 		return -1;
 	}
 
-	EGLint context_attrib[] = {
-		EGL_CONTEXT_CLIENT_VERSION, 2,
-		EGL_NONE
-	};
-
-	mEglContext = eglCreateContext(mEglDisplay, eglConfig, EGL_NO_CONTEXT, context_attrib);
+	mEglContext = manager.acquireContext();
 	if(EGL_NO_CONTEXT == mEglContext) {
-		LOGE("EGL eglCreateContext error");
 		return -1;
 	}
 
@@ -126,27 +131,36 @@ int EglSink::init(int type)
 
 	LOGD("EGL init success");
 
-	if (type == VIDEO_SINK_TYPE_PANORAMIC) {
-		mRenderPtr = GLRendererFactory::create(GL_RENDERER_PANORAMIC_YUV420P);
-	} else {
-		mRenderPtr = GLRendererFactory::create(GL_RENDERER_YUV420P);
-	}
+	mSinkType = type;
 
+	return initRenderer(AV_PIX_FMT_YUV420P);
+}
+
+int EglSink::initRenderer(int format)
+{
+	EglContextManager &manager = EglContextManager::instance();
+	int rtype = GLRendererFactory::typeForFormat(format, mSinkType);
+
+	manager.releaseRenderer(mRenderPtr);
+
+	mRenderPtr = manager.acquireRenderer(rtype);
 	if (!mRenderPtr) {
-		LOGE("EGL create render error");
+		LOGE("EGL create render error, format %d", format);
+		mRenderFormat = AV_PIX_FMT_NONE;
 		return -1;
 	}
 
-	if (mRenderPtr->prepare()) {
-		LOGE("Render prepare failed");
-		return -1;
-	}
+	mRenderFormat = format;
 	
 	return 0;
 }
 
 int EglSink::display(FrameBuffer &frm)
 {
+	if (frm.getFormat() != mRenderFormat && initRenderer(frm.getFormat()) < 0) {
+		return -1;
+	}
+
 	GLFrame glfrm(frm);
 	
 	mRenderPtr->render(&glfrm);
@@ -156,6 +170,37 @@ int EglSink::display(FrameBuffer &frm)
 	return 0;
 }
 
+int EglSink::redraw()
+{
+	if (!mRenderPtr || mRenderPtr->redraw() < 0) {
+		return -1;
+	}
+
+	eglSwapBuffers(mEglDisplay, mEglSurface);
+
+	return 0;
+}
+
+int EglSink::readPixels(uint8_t *rgba, int size)
+{
+	if (!rgba || size < mSurfaceWidth * mSurfaceHeight * 4) {
+		return -1;
+	}
+
+	glReadPixels(0, 0, mSurfaceWidth, mSurfaceHeight, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	if (glGetError() != GL_NO_ERROR) {
+		LOGE("Read pixels failed");
+		return -1;
+	}
+
+	return 0;
+}
+
+int64_t EglSink::getUploadTimeUs() const
+{
+	return mRenderPtr ? mRenderPtr->getUploadTimeUs() : 0;
+}
+
 void EglSink::onTouchMoveEvent(float dx, float dy)
 {
 	if (mRenderPtr) {
@@ -9,9 +9,9 @@
 #define JNI_MEDIASINK_VIDEOSINK_EGL_EGLSINK_H_
 
 #include <EGL/egl.h>
-#include <android/native_window_jni.h>
+#include <stdint.h>
 #include <memory>
-#include "../videosink.hpp"
+#include "../VideoSink.hpp"
 
 namespace whitebean
 {
@@ -21,19 +21,48 @@ class EglSink : public VideoSink
 {
 public:
 	EglSink() = delete;
-	EglSink(ANativeWindow *nwindow);
+	EglSink(EGLNativeWindowType nwindow);
+
+	/*
+	 * Offscreen sink rendering into a width x height pbuffer, for tests and
+	 * benchmarks. Works with software drivers such as Mesa.
+	 */
+	EglSink(int width, int height);
 	~EglSink();
 
 	int init(int type);
 	int display(FrameBuffer &frm);
+	int redraw();
 	void onTouchMoveEvent(float dx, float dy);
+
+	/*
+	 * Read back the last rendered picture as RGBA, bottom row first. Must be
+	 * called on the thread that called init().
+	 */
+	int readPixels(uint8_t *rgba, int size);
+
+	int getWidth() const {
+		return mSurfaceWidth;
+	}
+
+	int getHeight() const {
+		return mSurfaceHeight;
+	}
+
+	// texture upload time of the last displayed frame, in us
+	int64_t getUploadTimeUs() const;
 private:
-	ANativeWindow               *mNativeWindow;
+	int initRenderer(int format);
+
+	bool                         mOffscreen;
+	EGLNativeWindowType          mNativeWindow;
 	EGLNativeDisplayType	     mEglDisplay;
 	EGLSurface	                 mEglSurface;
 	EGLContext	                 mEglContext;
 	int                          mSurfaceWidth;
 	int                          mSurfaceHeight;
+	int                          mSinkType;
+	int                          mRenderFormat;
 	std::shared_ptr<GLRenderer>  mRenderPtr;
 };
 	
@@ -0,0 +1,212 @@
+/*
+ * GLProgramCache.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <EGL/egl.h>
+#include "log.hpp"
+#include "GLProgramCache.hpp"
+#include "../../../mediabase/CacheFile.hpp"
+
+using namespace std;
+
+namespace whitebean
+{
+
+static const uint32_t CACHE_MAGIC = 'WBPB';
+static const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t length;
+};
+
+static uint64_t hashString(uint64_t hash, const char *str)
+{
+	// with a separator, so that ("ab", "c") and ("a", "bc") differ
+	static const uint8_t separator = 0xff;
+
+	hash = CacheFile::hash(str ? str : "", str ? strlen(str) : 0, hash);
+
+	return CacheFile::hash(&separator, 1, hash);
+}
+
+GLProgramCache &GLProgramCache::instance()
+{
+	static GLProgramCache cache;
+	return cache;
+}
+
+GLProgramCache::GLProgramCache()
+: mExtensionChecked(false)
+, mGetProgramBinary(nullptr)
+, mProgramBinary(nullptr)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+void GLProgramCache::setDirectory(const string &dir)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mDirectory = dir;
+}
+
+bool GLProgramCache::initExtension()
+{
+	if (mExtensionChecked) {
+		return mGetProgramBinary && mProgramBinary;
+	}
+
+	mExtensionChecked = true;
+
+	const char *ext = (const char *)glGetString(GL_EXTENSIONS);
+	if (!ext || !strstr(ext, "GL_OES_get_program_binary")) {
+		LOGD("GL_OES_get_program_binary not supported");
+		return false;
+	}
+
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+	if (formats <= 0) {
+		LOGD("No program binary formats");
+		return false;
+	}
+
+	mGetProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+	mProgramBinary = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
+
+	return mGetProgramBinary && mProgramBinary;
+}
+
+string GLProgramCache::getPath(int type, const char *vshaderSrc, const char *fshaderSrc)
+{
+	uint64_t hash = CacheFile::HASH_SEED;
+
+	hash = hashString(hash, (const char *)glGetString(GL_VENDOR));
+	hash = hashString(hash, (const char *)glGetString(GL_RENDERER));
+	hash = hashString(hash, (const char *)glGetString(GL_VERSION));
+	hash = hashString(hash, vshaderSrc);
+	hash = hashString(hash, fshaderSrc);
+
+	char name[64];
+	snprintf(name, sizeof(name), "/glprogram_%d_%016llx.bin", type, (unsigned long long)hash);
+
+	return mDirectory + name;
+}
+
+GLuint GLProgramCache::load(int type, const char *vshaderSrc, const char *fshaderSrc)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mDirectory.empty() || !initExtension()) {
+		return 0;
+	}
+
+	string path = getPath(type, vshaderSrc, fshaderSrc);
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp) {
+		return 0;
+	}
+
+	CacheHeader header;
+	vector<uint8_t> binary;
+	bool valid = fread(&header, sizeof(header), 1, fp) == 1
+			  && header.magic == CACHE_MAGIC
+			  && header.version == CACHE_VERSION
+			  && header.length > 0;
+
+	if (valid) {
+		binary.resize(header.length);
+		valid = fread(binary.data(), 1, binary.size(), fp) == binary.size();
+	}
+
+	fclose(fp);
+
+	if (!valid) {
+		LOGE("Invalid program cache %s", path.c_str());
+		remove(path.c_str());
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	if (!program) {
+		return 0;
+	}
+
+	mProgramBinary(program, header.format, binary.data(), binary.size());
+
+	GLint linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		// the driver rejects binaries it does not like any more
+		LOGD("Cached program rejected, %s", path.c_str());
+		glDeleteProgram(program);
+		remove(path.c_str());
+		return 0;
+	}
+
+	return program;
+}
+
+int GLProgramCache::store(int type, const char *vshaderSrc, const char *fshaderSrc, GLuint program)
+{
+	unique_lock<mutex> autoLock(mLock);
+
+	if (mDirectory.empty() || !initExtension()) {
+		return -1;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+	if (length <= 0) {
+		return -1;
+	}
+
+	CacheHeader header;
+	vector<uint8_t> binary(length);
+	GLenum format = 0;
+
+	mGetProgramBinary(program, length, &length, &format, binary.data());
+	if (glGetError() != GL_NO_ERROR || length <= 0) {
+		LOGE("Get program binary failed");
+		return -1;
+	}
+
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.format = format;
+	header.length = length;
+
+	return CacheFile::writeAtomic(getPath(type, vshaderSrc, fshaderSrc), [&](FILE *fp) {
+		return fwrite(&header, sizeof(header), 1, fp) == 1
+			&& fwrite(binary.data(), 1, length, fp) == (size_t)length;
+	});
+}
+
+void GLProgramCache::recordLoad(int64_t us)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mStats.hits++;
+	mStats.loadTimeUs += us;
+}
+
+void GLProgramCache::recordCompile(int64_t us)
+{
+	unique_lock<mutex> autoLock(mLock);
+	mStats.misses++;
+	mStats.compileTimeUs += us;
+}
+
+GLProgramCache::Stats GLProgramCache::getStats() const
+{
+	unique_lock<mutex> autoLock(mLock);
+	return mStats;
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+ * GLProgramCache.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIASINK_VIDEOSINK_EGL_GLPROGRAMCACHE_H_
+#define JNI_MEDIASINK_VIDEOSINK_EGL_GLPROGRAMCACHE_H_
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <stdint.h>
+#include <mutex>
+#include <string>
+
+namespace whitebean
+{
+
+/*
+ * Linked program binaries kept on disk through GL_OES_get_program_binary.
+ * A program is keyed by renderer type, GL vendor/renderer/version strings
+ * and the shader sources, so a driver update or a shader change is a miss.
+ * Without a directory or without the extension every lookup is a miss.
+ */
+class GLProgramCache
+{
+public:
+	struct Stats {
+		int hits;
+		int misses;
+		int64_t loadTimeUs;		// total time spent loading cached binaries
+		int64_t compileTimeUs;	// total time spent compiling and linking
+	};
+
+	static GLProgramCache &instance();
+
+	void setDirectory(const std::string &dir);
+
+	/*
+	 * Program linked from the cached binary, 0 on a miss.
+	 * Must be called with a current context.
+	 */
+	GLuint load(int type, const char *vshaderSrc, const char *fshaderSrc);
+
+	/*
+	 * Save the binary of a freshly linked program
+	 */
+	int store(int type, const char *vshaderSrc, const char *fshaderSrc, GLuint program);
+
+	void recordLoad(int64_t us);
+	void recordCompile(int64_t us);
+	Stats getStats() const;
+
+private:
+	GLProgramCache();
+	GLProgramCache(const GLProgramCache &) = delete;
+	GLProgramCache &operator=(const GLProgramCache &) = delete;
+
+	bool initExtension();
+	std::string getPath(int type, const char *vshaderSrc, const char *fshaderSrc);
+
+	mutable std::mutex mLock;
+	std::string mDirectory;
+	bool mExtensionChecked;
+	PFNGLGETPROGRAMBINARYOESPROC mGetProgramBinary;
+	PFNGLPROGRAMBINARYOESPROC mProgramBinary;
+	Stats mStats;
+};
+
+}
+
+#endif
@@ -6,22 +6,38 @@
  */
 
 #include <stdlib.h>
+#include <chrono>
 #include "log.hpp"
 #include "GLRenderer.hpp"
+#include "GLProgramCache.hpp"
 
 namespace whitebean
 {
 	
 GLRenderer::GLRenderer()
-: mVertexSize(2)
+: mGlProgram(0)
+, mVertexSize(2)
 , mTexCoordSize(2)
+, mPositionAttrib(-1)
+, mVertexBuffer(0)
+, mIndicesBuffer(0)
+, mGlVShader(0)
+, mGlFShader(0)
 , mVerticesPtr(nullptr)
 , mTexCoordsPtr(nullptr)
 , mIndicesPtr(nullptr)
+, mIndicesType(GL_UNSIGNED_BYTE)
 , mVerticesNum(0)
 , mTexCoordsNum(0)
 , mIndicesNum(0)
+, mUploadTimeUs(0)
+, mType(-1)
+, mProgramTimeUs(0)
+, mProgramCached(false)
 {
+	for (int i = 0; i < GLES2_MAX_PLANE; ++i) {
+		mTexCoordBuffer[i] = 0;
+	}
 
 }
 
@@ -63,6 +79,37 @@ GLuint GLRenderer::loadShader(GLenum type, const char *shaderSrc)
 }
 
 GLuint GLRenderer::createProgram(const char *vshaderSrc, const char *fshaderSrc)
+{
+	GLProgramCache &cache = GLProgramCache::instance();
+	auto start = std::chrono::steady_clock::now();
+
+	GLuint programObject = cache.load(mType, vshaderSrc, fshaderSrc);
+	mProgramCached = programObject != 0;
+
+	if (!programObject) {
+		programObject = compileProgram(vshaderSrc, fshaderSrc);
+		if (!programObject) {
+			return 0;
+		}
+	}
+
+	mProgramTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+
+	if (mProgramCached) {
+		cache.recordLoad(mProgramTimeUs);
+	} else {
+		cache.recordCompile(mProgramTimeUs);
+		cache.store(mType, vshaderSrc, fshaderSrc, programObject);
+	}
+
+	LOGI("Renderer %d program ready in %lld us (%s)", mType, (long long)mProgramTimeUs,
+		 mProgramCached ? "cache" : "compile");
+
+	return programObject;
+}
+
+GLuint GLRenderer::compileProgram(const char *vshaderSrc, const char *fshaderSrc)
 {
 	GLuint programObject;
 	GLint  linked;	
@@ -122,20 +169,19 @@ void GLRenderer::initVertices()
 
 int GLRenderer::loadVertices()
 {
-    GLuint a_position;
-
     glGenBuffers(1, &mVertexBuffer);
-    a_position = glGetAttribLocation(mGlProgram, "a_position");
-    glEnableVertexAttribArray(a_position);
+    mPositionAttrib = glGetAttribLocation(mGlProgram, "a_position");
+    glEnableVertexAttribArray(mPositionAttrib);
     glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
     glBufferData(GL_ARRAY_BUFFER, mVerticesNum * mVertexSize * sizeof(GLfloat), mVerticesPtr, GL_STATIC_DRAW);
-    glVertexAttribPointer(a_position, mVertexSize, GL_FLOAT, GL_FALSE, 0, 0);
+    glVertexAttribPointer(mPositionAttrib, mVertexSize, GL_FLOAT, GL_FALSE, 0, 0);
 
     if (mIndicesPtr) {
     	glGenBuffers(1, &mIndicesBuffer);
     	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndicesBuffer);
-    	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndicesNum * sizeof(GLubyte), mIndicesPtr,
-    			GL_STATIC_DRAW);
+    	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+    			mIndicesNum * (mIndicesType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLubyte)),
+    			mIndicesPtr, GL_STATIC_DRAW);
     }
 
     return 0;
@@ -179,5 +225,54 @@ int GLRenderer::render(GLFrame *pic)
 {
 	return 0;
 }
+
+void GLRenderer::bind()
+{
+	glUseProgram(mGlProgram);
+
+	glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+	glEnableVertexAttribArray(mPositionAttrib);
+	glVertexAttribPointer(mPositionAttrib, mVertexSize, GL_FLOAT, GL_FALSE, 0, 0);
+
+	if (mIndicesBuffer) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndicesBuffer);
+	}
+}
+
+void GLRenderer::destroy()
+{
+	if (mGlProgram) {
+		glDeleteProgram(mGlProgram);
+		mGlProgram = 0;
+	}
+
+	// a program loaded from the binary cache has no shaders
+	if (mGlVShader) {
+		glDeleteShader(mGlVShader);
+		mGlVShader = 0;
+	}
+
+	if (mGlFShader) {
+		glDeleteShader(mGlFShader);
+		mGlFShader = 0;
+	}
+
+	if (mVertexBuffer) {
+		glDeleteBuffers(1, &mVertexBuffer);
+		mVertexBuffer = 0;
+	}
+
+	if (mIndicesBuffer) {
+		glDeleteBuffers(1, &mIndicesBuffer);
+		mIndicesBuffer = 0;
+	}
+
+	for (int i = 0; i < GLES2_MAX_PLANE; ++i) {
+		if (mTexCoordBuffer[i]) {
+			glDeleteBuffers(1, &mTexCoordBuffer[i]);
+			mTexCoordBuffer[i] = 0;
+		}
+	}
+}
 	
 }
@@ -83,18 +83,76 @@ public:
 	virtual int prepare();
 	virtual int render(GLFrame *pic);
 	virtual void onTouchMoveEvent(float dx, float dy) {}
+
+	/*
+	 * Draw the last uploaded frame again, e.g. after a view change.
+	 * Returns -1 if the renderer has nothing to redraw.
+	 */
+	virtual int redraw() {
+		return -1;
+	}
+
+	/*
+	 * Drop what the last player set up, e.g. the view angles, before the
+	 * renderer goes back to the pool
+	 */
+	virtual void resetView() {}
+
+	/*
+	 * CPU time spent in the last loadTexture() call, in us
+	 */
+	int64_t getUploadTimeUs() const {
+		return mUploadTimeUs;
+	}
+
+	/*
+	 * Renderer type, part of the program cache key
+	 */
+	void setType(int type) {
+		mType = type;
+	}
+
+	int getType() const {
+		return mType;
+	}
+
+	/*
+	 * Bind the program, buffers and textures of a prepared renderer again.
+	 * Objects are shared between contexts but vertex attribute and texture
+	 * unit bindings are not, call it after moving to another context.
+	 */
+	virtual void bind();
+
+	/*
+	 * Delete the GL objects, with a context sharing them current
+	 */
+	virtual void destroy();
+
+	/*
+	 * Time spent to get the linked program in prepare(), in us, and
+	 * whether it came from the program binary cache
+	 */
+	int64_t getProgramTimeUs() const {
+		return mProgramTimeUs;
+	}
+
+	bool isProgramCached() const {
+		return mProgramCached;
+	}
 	
 protected:
 	const char *mVertexScript;
 	const char *mFragmentScript;
 	GLuint loadShader(GLenum type, const char *shaderSrc);
 	GLuint createProgram(const char *vshaderSrc, const char *fshaderSrc);
+	GLuint compileProgram(const char *vshaderSrc, const char *fshaderSrc);
 
 	GLuint mGlProgram;
 	GLubyte *mIndices;
 	GLint  mVertexSize;
 	GLint  mTexCoordSize;
 	GLint  mIndicesSize;
+	GLint  mPositionAttrib;
 	GLuint mVertexBuffer;
 	GLuint mTexCoordBuffer[GLES2_MAX_PLANE];
 	GLuint mIndicesBuffer;
@@ -102,11 +160,16 @@ protected:
 	GLuint mGlFShader;
 	GLfloat *mVerticesPtr;
 	GLfloat *mTexCoordsPtr;
-	GLubyte *mIndicesPtr;
+	const GLvoid *mIndicesPtr;
+	GLenum mIndicesType;
 	uint32_t mVerticesNum;
 	uint32_t mTexCoordsNum;
 	uint32_t mIndicesNum;
 	int mBufferLineSize;
+	int64_t mUploadTimeUs;
+	int mType;
+	int64_t mProgramTimeUs;
+	bool mProgramCached;
 };
 	
 }
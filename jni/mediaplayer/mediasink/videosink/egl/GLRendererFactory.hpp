@@ -10,7 +10,10 @@
 
 #include <memory>
 #include "GLRendererYUV420p.hpp"
+#include "GLRendererYUV420p10.hpp"
+#include "GLRendererNV12.hpp"
 #include "GLRendererPanoYUV420p.hpp"
+#include "../VideoSink.hpp"
 
 namespace whitebean
 {
@@ -18,6 +21,12 @@ namespace whitebean
 enum {
 	GL_RENDERER_YUV420P,
 	GL_RENDERER_PANORAMIC_YUV420P,
+	GL_RENDERER_NV12,
+	GL_RENDERER_NV21,
+	GL_RENDERER_YUV420P10,
+	GL_RENDERER_CUBEMAP_YUV420P,
+	GL_RENDERER_EAC_YUV420P,
+	GL_RENDERER_NONE = -1,
 };
 
 class GLRendererFactory
@@ -32,15 +41,70 @@ public:
 			ret = std::shared_ptr<GLRenderer>(new GLRendererYUV420p);
 			break;
 		case GL_RENDERER_PANORAMIC_YUV420P:
-			ret = std::shared_ptr<GLRenderer>(new GLRendererPanoYUV420p);
+			ret = std::shared_ptr<GLRenderer>(new GLRendererPanoYUV420p(PANO_LAYOUT_EQUIRECT));
+			break;
+		case GL_RENDERER_CUBEMAP_YUV420P:
+			ret = std::shared_ptr<GLRenderer>(new GLRendererPanoYUV420p(PANO_LAYOUT_CUBEMAP_3X2));
+			break;
+		case GL_RENDERER_EAC_YUV420P:
+			ret = std::shared_ptr<GLRenderer>(new GLRendererPanoYUV420p(PANO_LAYOUT_EAC_3X2));
+			break;
+		case GL_RENDERER_NV12:
+			ret = std::shared_ptr<GLRenderer>(new GLRendererNV12(false));
+			break;
+		case GL_RENDERER_NV21:
+			ret = std::shared_ptr<GLRenderer>(new GLRendererNV12(true));
+			break;
+		case GL_RENDERER_YUV420P10:
+			ret = std::shared_ptr<GLRenderer>(new GLRendererYUV420p10);
 			break;
 		default:
 
 			break;
 		}
 
+		if (ret) {
+			ret->setType(type);
+		}
+
 		return ret;
 	}
+
+	/*
+	 * Renderer able to sample frames of the given AVPixelFormat directly on
+	 * a VIDEO_SINK_TYPE_* sink, GL_RENDERER_NONE if the format has to be
+	 * converted first
+	 */
+	static int typeForFormat(int format, int sinkType = VIDEO_SINK_TYPE_NORMAL)
+	{
+		if (sinkType != VIDEO_SINK_TYPE_NORMAL && format != AV_PIX_FMT_YUV420P) {
+			return GL_RENDERER_NONE;
+		}
+
+		switch (sinkType) {
+		case VIDEO_SINK_TYPE_PANORAMIC:
+			return GL_RENDERER_PANORAMIC_YUV420P;
+		case VIDEO_SINK_TYPE_CUBEMAP:
+			return GL_RENDERER_CUBEMAP_YUV420P;
+		case VIDEO_SINK_TYPE_EAC:
+			return GL_RENDERER_EAC_YUV420P;
+		default:
+			break;
+		}
+
+		switch (format) {
+		case AV_PIX_FMT_YUV420P:
+			return GL_RENDERER_YUV420P;
+		case AV_PIX_FMT_NV12:
+			return GL_RENDERER_NV12;
+		case AV_PIX_FMT_NV21:
+			return GL_RENDERER_NV21;
+		case AV_PIX_FMT_YUV420P10LE:
+			return GL_RENDERER_YUV420P10;
+		default:
+			return GL_RENDERER_NONE;
+		}
+	}
 };
 	
 }
@@ -0,0 +1,68 @@
+/*
+ * GLRendererNV12.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include "log.hpp"
+#include "GLRendererNV12.hpp"
+
+namespace whitebean
+{
+
+GLRendererNV12::GLRendererNV12(bool interleavedVU)
+{
+	mPlanes = 2;
+	mPlaneFormats[0] = GL_LUMINANCE;
+	mPlaneFormats[1] = GL_LUMINANCE_ALPHA;
+
+	if (interleavedVU) {
+		mFragmentScript = STRINGIZE(
+			precision highp float;
+			varying highp vec2 v_tex_coord_out_y;
+			varying highp vec2 v_tex_coord_out_u;
+			uniform sampler2D u_texture_y;
+			uniform sampler2D u_texture_u;
+			void main() {
+				mat3 yuv2rgb = mat3(1, 0, 1.5958, 1, -0.39173, -0.81290, 1, 2.017, 0);
+				vec4 vu = texture2D(u_texture_u, v_tex_coord_out_u);
+				vec3 yuv = vec3(1.1643 * (texture2D(u_texture_y, v_tex_coord_out_y).r - 0.0625),
+								vu.a - 0.5,
+								vu.r - 0.5);
+				vec3 rgb = yuv * yuv2rgb;
+				gl_FragColor = vec4(rgb, 1.0);
+			}
+		);
+	} else {
+		mFragmentScript = STRINGIZE(
+			precision highp float;
+			varying highp vec2 v_tex_coord_out_y;
+			varying highp vec2 v_tex_coord_out_u;
+			uniform sampler2D u_texture_y;
+			uniform sampler2D u_texture_u;
+			void main() {
+				mat3 yuv2rgb = mat3(1, 0, 1.5958, 1, -0.39173, -0.81290, 1, 2.017, 0);
+				vec4 uv = texture2D(u_texture_u, v_tex_coord_out_u);
+				vec3 yuv = vec3(1.1643 * (texture2D(u_texture_y, v_tex_coord_out_y).r - 0.0625),
+								uv.r - 0.5,
+								uv.a - 0.5);
+				vec3 rgb = yuv * yuv2rgb;
+				gl_FragColor = vec4(rgb, 1.0);
+			}
+		);
+	}
+}
+
+void GLRendererNV12::getPlaneSize(GLFrame *pic, int plane, GLsizei &width, GLsizei &height)
+{
+	if (plane == 0) {
+		width = pic->pitches[0];
+		height = pic->height;
+	} else {
+		// one texel per U/V pair
+		width = pic->pitches[1] / 2;
+		height = pic->height / 2;
+	}
+}
+	
+}
@@ -0,0 +1,30 @@
+/*
+ * GLRendererNV12.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIASINK_VIDEOSINK_EGL_GLRENDERERNV12_H_
+#define JNI_MEDIASINK_VIDEOSINK_EGL_GLRENDERERNV12_H_
+
+#include "GLRendererYUV420p.hpp"
+
+namespace whitebean
+{
+
+/*
+ * Semi-planar 4:2:0, the interleaved chroma plane is sampled as a
+ * luminance-alpha texture. NV21 is the same layout with V before U.
+ */
+class GLRendererNV12: public GLRendererYUV420p
+{
+public:
+	GLRendererNV12(bool interleavedVU = false);
+	virtual ~GLRendererNV12() {}
+
+	virtual void getPlaneSize(GLFrame *pic, int plane, GLsizei &width, GLsizei &height);
+};
+	
+}
+
+#endif
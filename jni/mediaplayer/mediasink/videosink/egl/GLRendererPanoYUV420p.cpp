@@ -16,13 +16,18 @@ namespace whitebean
 const float GLRendererPanoYUV420p::mR = 5.0f;
 const float GLRendererPanoYUV420p::TOUCH_SCALE_FACTOR = 180.0f / 320 / 3.8f;
 
-GLRendererPanoYUV420p::GLRendererPanoYUV420p()
-: left(0)
+GLRendererPanoYUV420p::GLRendererPanoYUV420p(int layout, int tessellation)
+: mLayout(layout)
+, mTessellation(tessellation)
+, left(0)
 , right(0)
 , bottom(0)
 , top(0)
 , angleX(0)
 , angleY(0)
+, mAspect(0)
+, mViewDirty(true)
+, mProjectionLoc(-1)
 {
 	mVertexSize = 3;
 	mTexCoordSize = 2;
@@ -55,40 +60,45 @@ GLRendererPanoYUV420p::GLRendererPanoYUV420p()
 	memset(mScrtch, 0, sizeof(mScrtch));
 }
 
-void GLRendererPanoYUV420p::initVertices()
+int GLRendererPanoYUV420p::buildMesh()
 {
-    double phiStep = 2 * PI / mPhiSteps;
-    double tettaStep = PI / mTettaSteps;
-
-    int spherePointCounter = 0;
-    int texturePointCounter = 0;
-
-    for (double tetta = 0; tetta <= (PI - tettaStep) + tettaStep / 2 ; tetta += tettaStep) {
-        for(double phi = 0; phi <= 2 * PI + phiStep / 2; phi += phiStep) {
-            mVertices[spherePointCounter++] = (float)(mR * sin(tetta) * cos(phi));
-            mVertices[spherePointCounter++] = (float)(mR * cos(tetta));
-            mVertices[spherePointCounter++] = (float)(mR * sin(tetta) * sin(phi));
+	switch (mLayout) {
+	case PANO_LAYOUT_EQUIRECT:
+		return buildSphereMesh(mMesh, mR, mTessellation * 2, mTessellation * 4);
+	case PANO_LAYOUT_CUBEMAP_3X2:
+		return buildCubeMesh(mMesh, mR, mTessellation, false);
+	case PANO_LAYOUT_EAC_3X2:
+		return buildCubeMesh(mMesh, mR, mTessellation, true);
+	default:
+		LOGE("Unknown panoramic layout %d", mLayout);
+		return -1;
+	}
+}
 
-            mTexCoords[texturePointCounter++] = (float) (phi / (2 * PI));
-            mTexCoords[texturePointCounter++] = 1.f - (float) (tetta / (PI));
+void GLRendererPanoYUV420p::initVertices()
+{
+	mVerticesPtr = mMesh.vertices.data();
+	mVerticesNum = mMesh.vertexCount();
 
-            mVertices[spherePointCounter++] = (float)(mR * sin(tetta + tettaStep) * cos(phi));
-            mVertices[spherePointCounter++] = (float)(mR * cos(tetta + tettaStep));
-            mVertices[spherePointCounter++] = (float)(mR * sin(tetta + tettaStep) * sin(phi));
+	mIndicesPtr = mMesh.indices.data();
+	mIndicesNum = mMesh.indices.size();
+	mIndicesType = GL_UNSIGNED_SHORT;
+}
 
-            mTexCoords[texturePointCounter++] = (float) (phi / (2 * PI));
-            mTexCoords[texturePointCounter++] = 1.f - (float) ((tetta + tettaStep) / (PI));
-        }
-    }
+void GLRendererPanoYUV420p::initTexCoords()
+{
+	mCroppedTexCoords = mMesh.texCoords;
 
-    mVerticesPtr = mVertices;
-    mVerticesNum = sizeof(mVertices) / sizeof(GLfloat) / mVertexSize;
+	mTexCoordsPtr = mCroppedTexCoords.data();
+	mTexCoordsNum = mCroppedTexCoords.size() / mTexCoordSize;
 }
 
-void GLRendererPanoYUV420p::initTexCoords()
+void GLRendererPanoYUV420p::cropTexCoords(GLfloat ratio)
 {
-	mTexCoordsPtr = mTexCoords;
-	mTexCoordsNum = sizeof(mTexCoords) / sizeof(GLfloat) / mTexCoordSize;
+	// only the horizontal coordinates are affected by the line padding
+	for (size_t i = 0; i < mCroppedTexCoords.size(); i += 2) {
+		mCroppedTexCoords[i] = mMesh.texCoords[i] * ratio;
+	}
 }
 
 void GLRendererPanoYUV420p::loadProjection(float aspect)
@@ -105,41 +115,98 @@ void GLRendererPanoYUV420p::loadProjection(float aspect)
 
     setLookAtM(mViewMatrix, 0, 0, 0, 0, 0, -1, 0, -1, 0);
     matrixMul4(mProjectionMatrix, mViewMatrix, mProjectionViewMatrix);
+}
+
+void GLRendererPanoYUV420p::loadView()
+{
     setRotateM(mRotationMatrixX, angleY, -1.0f, 0.0f, 0);
     setRotateM(mRotationMatrixY, angleX, 0.0f, -1.0f, 0);
     matrixMul4(mRotationMatrixX, mRotationMatrixY, mRotationMatrix);
-    matrixMul4(mProjectionViewMatrix, mRotationMatrix, mScrtch);
 }
 
-int GLRendererPanoYUV420p::render(GLFrame *pic)
+int GLRendererPanoYUV420p::prepare()
+{
+	if (mMesh.indices.empty() && buildMesh() < 0) {
+		LOGE("Build panoramic mesh failed, tessellation %d", mTessellation);
+		return -1;
+	}
+
+	LOGD("Panoramic mesh: %d vertices, %d indices", mMesh.vertexCount(), (int)mMesh.indices.size());
+
+	if (GLRendererYUV420p::prepare() < 0) {
+		return -1;
+	}
+
+	mProjectionLoc = glGetUniformLocation(mGlProgram, "m_projection");
+
+	return 0;
+}
+
+void GLRendererPanoYUV420p::draw()
 {
 	GLint rec[4];
 	glGetIntegerv(GL_VIEWPORT, rec);
-	int surWidth = rec[2];
-	int surHeight = rec[3];
+	float aspect = rec[3] ? rec[2] * 1.0f / rec[3] : 1.0f;
 
-	glClear(GL_COLOR_BUFFER_BIT);
+	bool reload = false;
 
-	if (!pic) {
-		return -1;
+	if (aspect != mAspect) {
+		loadProjection(aspect);
+		mAspect = aspect;
+		reload = true;
 	}
 
-	loadProjection(surWidth*1.0/surHeight);
+	if (mViewDirty) {
+		loadView();
+		mViewDirty = false;
+		reload = true;
+	}
+
+	if (reload) {
+		matrixMul4(mProjectionViewMatrix, mRotationMatrix, mScrtch);
+		glUniformMatrix4fv(mProjectionLoc, 1, 0, mScrtch);
+	}
 
-    GLuint matrix = glGetUniformLocation(mGlProgram, "m_projection");
-	glUniformMatrix4fv(matrix, 1, 0, mScrtch);
+	GLRendererYUV420p::draw();
+}
+
+int GLRendererPanoYUV420p::redraw()
+{
+	if (!hasTexture()) {
+		return -1;
+	}
 
-	updateTexture(pic);
+	glClear(GL_COLOR_BUFFER_BIT);
 
-	glDrawArrays(GL_TRIANGLE_STRIP , 0, mVerticesNum);
+	draw();
 
 	return 0;
 }
 
+void GLRendererPanoYUV420p::bind()
+{
+	GLRendererYUV420p::bind();
+
+	// the new surface may have another aspect, the view is kept
+	mAspect = 0;
+}
+
+void GLRendererPanoYUV420p::resetView()
+{
+	angleX = 0;
+	angleY = 0;
+	mViewDirty = true;
+}
+
 void GLRendererPanoYUV420p::onTouchMoveEvent(float dx, float dy)
 {
+	if (dx == 0 && dy == 0) {
+		return;
+	}
+
 	angleX -= dx * TOUCH_SCALE_FACTOR;
 	angleY -= dy * TOUCH_SCALE_FACTOR;
+	mViewDirty = true;
 }
 
 }
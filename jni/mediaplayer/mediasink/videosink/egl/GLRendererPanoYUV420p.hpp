@@ -9,31 +9,52 @@
 #define MEDIAPLAYER_MEDIASINK_VIDEOSINK_EGL_GLRENDERERPANOYUV420P_HPP_
 
 #include "GLRendererYUV420p.hpp"
+#include "utils/panomesh.hpp"
+#include "../../../mediabase/MetaData.hpp"
 
 namespace whitebean
 {
 
+/*
+ * Panoramic frames mapped on an indexed mesh: a sphere for equirectangular
+ * pictures, a cube for the 3x2 cubemap and EAC layouts. The mesh is built
+ * once per renderer and kept in buffer objects.
+ */
 class GLRendererPanoYUV420p : public GLRendererYUV420p {
 public:
-	GLRendererPanoYUV420p();
+	/*
+	 * @param layout PANO_LAYOUT_*
+	 * @param tessellation mesh segments per 90 degrees
+	 */
+	GLRendererPanoYUV420p(int layout = PANO_LAYOUT_EQUIRECT, int tessellation = DEFAULT_TESSELLATION);
 	virtual ~GLRendererPanoYUV420p() {}
 
 	virtual void initVertices();
 	virtual void initTexCoords();
-	virtual void cropTexCoords(GLfloat ratio) {}
-	int render(GLFrame *pic);
+	virtual void cropTexCoords(GLfloat ratio);
+	virtual int prepare();
+	virtual int redraw();
+	virtual void bind();
+	virtual void resetView();
 	virtual void onTouchMoveEvent(float dx, float dy);
 
+protected:
+	virtual void draw();
+
 private:
-	static const int mTettaSteps = 10;
-	static const int mPhiSteps = 18;
+	static const int DEFAULT_TESSELLATION = 32;
 	static const float mR;
 	static const float TOUCH_SCALE_FACTOR;
 
-	GLfloat mVertices[((mPhiSteps + 1) * (2 * (mTettaSteps + 1) - 2)) * 3];
-	GLfloat mTexCoords[((mPhiSteps + 1) * (2 * (mTettaSteps + 1) - 2)) * 2];
+	int buildMesh();
+
+	int mLayout;
+	int mTessellation;
+	PanoMesh mMesh;
+	std::vector<GLfloat> mCroppedTexCoords;
 
 	void loadProjection(float aspect);
+	void loadView();
 
 	float left;
 	float right;
@@ -41,6 +62,14 @@ private:
 	float top;
 	float angleX;
 	float angleY;
+
+	/*
+	 * The matrices only change with the surface aspect or the view angles,
+	 * the m_projection uniform is only reloaded when one of them changed.
+	 */
+	float mAspect;
+	bool mViewDirty;
+	GLint mProjectionLoc;
 	GLfloat __attribute__((aligned(16))) mProjectionMatrix[16];
 	GLfloat __attribute__((aligned(16))) mViewMatrix[16];
 	GLfloat __attribute__((aligned(16))) mProjectionViewMatrix[16];
@@ -5,6 +5,7 @@
  *     Author: loushuai
  */
 
+#include <chrono>
 #include "log.hpp"
 #include "GLRendererYUV420p.hpp"
 
@@ -12,10 +13,27 @@ namespace whitebean
 {
 
 GLRendererYUV420p::GLRendererYUV420p()
+: mPlanes(3)
+, mPlaneFilter(GL_LINEAR)
+, mTexSet(0)
 {
 	mVertexSize = 2;
 	mTexCoordSize = 2;
 
+	for (int i = 0; i < GLES2_MAX_PLANE; ++i) {
+		mPlaneFormats[i] = GL_LUMINANCE;
+		mTexCoordAttribs[i] = -1;
+		mCropRatios[i] = 0.0f;
+	}
+
+	for (int s = 0; s < TEXTURE_SETS; ++s) {
+		for (int i = 0; i < GLES2_MAX_PLANE; ++i) {
+			mTextures[s][i] = 0;
+			mTexWidths[s][i] = 0;
+			mTexHeights[s][i] = 0;
+		}
+	}
+
     mVertexScript = STRINGIZE(
         attribute vec4 a_position;
         attribute vec2 a_tex_coord_in_y;
@@ -113,31 +131,43 @@ int GLRendererYUV420p::initTexture()
 	mSamplers[2] = glGetUniformLocation(mGlProgram, "u_texture_v");	
 	
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glEnable(GL_TEXTURE_2D);
 
 	glUseProgram(mGlProgram);
 
-	glGenTextures(3, mTextures);
+	for (int s = 0; s < TEXTURE_SETS; ++s) {
+		glGenTextures(mPlanes, mTextures[s]);
 
-	for (int i = 0; i < 3; ++i) {
-        glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, mTextures[i]);
+		for (int i = 0; i < mPlanes; ++i) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, mTextures[s][i]);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mPlaneFilter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mPlaneFilter);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+	}
 
+	for (int i = 0; i < mPlanes; ++i) {
         glUniform1i(mSamplers[i], i);
-	}	
+	}
+
+	mTexSet = 0;
+	bindTextureSet(mTexSet);
 	
 	return 0;
 }
 
+void GLRendererYUV420p::bindTextureSet(int set)
+{
+	for (int i = 0; i < mPlanes; ++i) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, mTextures[set][i]);
+	}
+}
+
 int GLRendererYUV420p::loadTexCoords(int id)
 {
-	GLfloat coords[8];
-    GLuint a_tex_coord_in;
 	const char *p = NULL;
 
 	switch (id) {
@@ -154,40 +184,79 @@ int GLRendererYUV420p::loadTexCoords(int id)
 		return -1;
 	}
 
+	// buffer and attribute already set up, only refresh the coordinates
+	if (mTexCoordBuffer[id]) {
+		glBindBuffer(GL_ARRAY_BUFFER, mTexCoordBuffer[id]);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, mTexCoordsNum * mTexCoordSize * sizeof(GLfloat), mTexCoordsPtr);
+		return 0;
+	}
+
     glGenBuffers(1, &mTexCoordBuffer[id]);	
-    a_tex_coord_in = glGetAttribLocation(mGlProgram, p);
-    glEnableVertexAttribArray(a_tex_coord_in);
+    mTexCoordAttribs[id] = glGetAttribLocation(mGlProgram, p);
+    glEnableVertexAttribArray(mTexCoordAttribs[id]);
     glBindBuffer(GL_ARRAY_BUFFER, mTexCoordBuffer[id]);
-    glBufferData(GL_ARRAY_BUFFER, mTexCoordsNum * mTexCoordSize * sizeof(GLfloat), mTexCoordsPtr, GL_STATIC_DRAW);
-    glVertexAttribPointer(a_tex_coord_in, mTexCoordSize, GL_FLOAT, GL_TRUE, 0, 0);
+    glBufferData(GL_ARRAY_BUFFER, mTexCoordsNum * mTexCoordSize * sizeof(GLfloat), mTexCoordsPtr, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(mTexCoordAttribs[id], mTexCoordSize, GL_FLOAT, GL_TRUE, 0, 0);
 	
 	return 0;
 }	
 
-int GLRendererYUV420p::loadTexture(GLFrame *pic)
+void GLRendererYUV420p::getPlaneSize(GLFrame *pic, int plane, GLsizei &width, GLsizei &height)
 {
-    const GLsizei widths[3]  = {pic->pitches[0], pic->pitches[1], pic->pitches[2]};
-	const GLsizei heights[3] = {pic->height, pic->height/2, pic->height/2};
-	const GLubyte *pixels[3] = {pic->pixels[0], pic->pixels[1], pic->pixels[2]};
+	width = pic->pitches[plane];
+	height = plane ? pic->height / 2 : pic->height;
+}
 
-	if (!pixels[0] || !pixels[1] || !pixels[2]) {
-		LOGE("Invalid data");
-		return -1;
+int GLRendererYUV420p::loadTexture(GLFrame *pic)
+{
+	GLsizei widths[GLES2_MAX_PLANE];
+	GLsizei heights[GLES2_MAX_PLANE];
+
+	for (int i = 0; i < mPlanes; ++i) {
+		if (!pic->pixels[i]) {
+			LOGE("Invalid data");
+			return -1;
+		}
+		getPlaneSize(pic, i, widths[i], heights[i]);
 	}
-		
-	for (int i = 0; i < 3; ++i) {
-		glBindTexture(GL_TEXTURE_2D, mTextures[i]);
-
-        glTexImage2D(GL_TEXTURE_2D,
-                     0,
-                     GL_LUMINANCE,
-                     widths[i],
-                     heights[i],
-                     0,
-                     GL_LUMINANCE,
-                     GL_UNSIGNED_BYTE,
-                     pixels[i]);		
+
+	auto start = std::chrono::steady_clock::now();
+
+	// upload into the set that was not drawn last
+	mTexSet = (mTexSet + 1) % TEXTURE_SETS;
+
+	for (int i = 0; i < mPlanes; ++i) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, mTextures[mTexSet][i]);
+
+		if (mTexWidths[mTexSet][i] != widths[i] || mTexHeights[mTexSet][i] != heights[i]) {
+			// (re)allocate storage only when the plane size changes
+			glTexImage2D(GL_TEXTURE_2D,
+						 0,
+						 mPlaneFormats[i],
+						 widths[i],
+						 heights[i],
+						 0,
+						 mPlaneFormats[i],
+						 GL_UNSIGNED_BYTE,
+						 NULL);
+			mTexWidths[mTexSet][i] = widths[i];
+			mTexHeights[mTexSet][i] = heights[i];
+		}
+
+		glTexSubImage2D(GL_TEXTURE_2D,
+						0,
+						0,
+						0,
+						widths[i],
+						heights[i],
+						mPlaneFormats[i],
+						GL_UNSIGNED_BYTE,
+						pic->pixels[i]);
 	}
+
+	mUploadTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
 	
 	return 0;
 }
@@ -203,7 +272,7 @@ int GLRendererYUV420p::prepare()
 	initVertices();
 	loadVertices();
 
-	for (int i = 0; i < GLES2_MAX_PLANE; ++i) {
+	for (int i = 0; i < mPlanes; ++i) {
 		initTexCoords();
 		loadTexCoords(i);
 	}
@@ -223,19 +292,22 @@ int GLRendererYUV420p::getLineSize(GLFrame *pic)
 }
 
 void GLRendererYUV420p::updateTexture(GLFrame *pic) {
-	loadTexture(pic);
-
-	GLfloat ratio = (GLfloat)pic->width / pic->getLineSize(0);
-	cropTexCoords(ratio);
-	loadTexCoords(0);
-
-	ratio = (GLfloat)pic->width / 2 / pic->getLineSize(1);
-	cropTexCoords(ratio);
-	loadTexCoords(1);
+	if (loadTexture(pic) < 0) {
+		return;
+	}
 
-	ratio = (GLfloat)pic->width / 2 / pic->getLineSize(2);
-	cropTexCoords(ratio);
-	loadTexCoords(2);
+	// the crop only changes with the line size or the width
+	for (int i = 0; i < mPlanes; ++i) {
+		GLsizei width, height;
+		getPlaneSize(pic, i, width, height);
+
+		GLfloat ratio = (GLfloat)(i ? pic->width / 2 : pic->width) / width;
+		if (ratio != mCropRatios[i]) {
+			cropTexCoords(ratio);
+			loadTexCoords(i);
+			mCropRatios[i] = ratio;
+		}
+	}
 }
 
 int GLRendererYUV420p::render(GLFrame *pic)
@@ -248,9 +320,46 @@ int GLRendererYUV420p::render(GLFrame *pic)
 
 	updateTexture(pic);
 
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
+	draw();
 
 	return 0;
-}	
+}
+
+void GLRendererYUV420p::bind()
+{
+	GLRenderer::bind();
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (int i = 0; i < mPlanes; ++i) {
+		glBindBuffer(GL_ARRAY_BUFFER, mTexCoordBuffer[i]);
+		glEnableVertexAttribArray(mTexCoordAttribs[i]);
+		glVertexAttribPointer(mTexCoordAttribs[i], mTexCoordSize, GL_FLOAT, GL_TRUE, 0, 0);
+	}
+
+	bindTextureSet(mTexSet);
+}
+
+void GLRendererYUV420p::destroy()
+{
+	for (int s = 0; s < TEXTURE_SETS; ++s) {
+		if (mTextures[s][0]) {
+			glDeleteTextures(mPlanes, mTextures[s]);
+		}
+
+		for (int i = 0; i < GLES2_MAX_PLANE; ++i) {
+			mTextures[s][i] = 0;
+			mTexWidths[s][i] = 0;
+			mTexHeights[s][i] = 0;
+		}
+	}
+
+	GLRenderer::destroy();
+}
+
+void GLRendererYUV420p::draw()
+{
+	glDrawElements(GL_TRIANGLES, mIndicesNum, mIndicesType, 0);
+}
 	
 }
@@ -29,13 +29,46 @@ public:
 	virtual int prepare();
 	virtual int getLineSize(GLFrame *pic);
 	virtual int render(GLFrame *pic);
+	virtual void bind();
+	virtual void destroy();
+
+	/*
+	 * Texture size of a plane, in texels
+	 */
+	virtual void getPlaneSize(GLFrame *pic, int plane, GLsizei &width, GLsizei &height);
 
 protected:
 	GLfloat mVertices[8];
 	GLfloat mTexCoords[8];
 	GLubyte mIndices[6];
-	GLuint mTextures[GLES2_MAX_PLANE];
+	int mPlanes;
+	GLenum mPlaneFormats[GLES2_MAX_PLANE];
+	GLint mPlaneFilter;
 	GLuint mSamplers[GLES2_MAX_PLANE];
+	GLint mTexCoordAttribs[GLES2_MAX_PLANE];
+	GLfloat mCropRatios[GLES2_MAX_PLANE];
+
+	/*
+	 * Textures are allocated once per plane size and refilled with
+	 * glTexSubImage2D. Uploads alternate between two texture sets so that
+	 * filling frame N+1 does not wait for the draw of frame N.
+	 */
+	static const int TEXTURE_SETS = 2;
+	GLuint mTextures[TEXTURE_SETS][GLES2_MAX_PLANE];
+	GLsizei mTexWidths[TEXTURE_SETS][GLES2_MAX_PLANE];
+	GLsizei mTexHeights[TEXTURE_SETS][GLES2_MAX_PLANE];
+	int mTexSet;
+
+	void bindTextureSet(int set);
+
+	bool hasTexture() const {
+		return mTexWidths[mTexSet][0] > 0;
+	}
+
+	/*
+	 * Issue the draw call with the textures currently bound
+	 */
+	virtual void draw();
 };
 	
 }
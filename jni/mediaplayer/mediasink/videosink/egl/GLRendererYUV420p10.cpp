@@ -0,0 +1,52 @@
+/*
+ * GLRendererYUV420p10.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include "log.hpp"
+#include "GLRendererYUV420p10.hpp"
+
+namespace whitebean
+{
+
+GLRendererYUV420p10::GLRendererYUV420p10()
+{
+	mPlanes = 3;
+	for (int i = 0; i < mPlanes; ++i) {
+		mPlaneFormats[i] = GL_LUMINANCE_ALPHA;
+	}
+	// filtering the two bytes separately breaks the high byte carry
+	mPlaneFilter = GL_NEAREST;
+
+    mFragmentScript = STRINGIZE(
+        precision highp float;
+        varying highp vec2 v_tex_coord_out_y;
+		varying highp vec2 v_tex_coord_out_u;
+		varying highp vec2 v_tex_coord_out_v;
+		uniform sampler2D u_texture_y;
+		uniform sampler2D u_texture_u;
+		uniform sampler2D u_texture_v;
+		float sample10(sampler2D tex, vec2 coord) {
+			vec4 texel = texture2D(tex, coord);
+			return (texel.r * 255.0 + texel.a * 65280.0) / 1023.0;
+		}
+        void main() {
+			mat3 yuv2rgb = mat3(1, 0, 1.5958, 1, -0.39173, -0.81290, 1, 2.017, 0);
+			vec3 yuv = vec3(1.1643 * (sample10(u_texture_y, v_tex_coord_out_y) - 0.0625),
+							sample10(u_texture_u, v_tex_coord_out_u) - 0.5,
+							sample10(u_texture_v, v_tex_coord_out_v) - 0.5);
+			vec3 rgb = yuv * yuv2rgb;
+			gl_FragColor = vec4(rgb, 1.0);
+        }
+    );
+}
+
+void GLRendererYUV420p10::getPlaneSize(GLFrame *pic, int plane, GLsizei &width, GLsizei &height)
+{
+	// two bytes per sample
+	width = pic->pitches[plane] / 2;
+	height = plane ? pic->height / 2 : pic->height;
+}
+	
+}
@@ -0,0 +1,32 @@
+/*
+ * GLRendererYUV420p10.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef JNI_MEDIASINK_VIDEOSINK_EGL_GLRENDERERYUV420P10_H_
+#define JNI_MEDIASINK_VIDEOSINK_EGL_GLRENDERERYUV420P10_H_
+
+#include "GLRendererYUV420p.hpp"
+
+namespace whitebean
+{
+
+/*
+ * Planar 4:2:0 with 16 bit little endian samples holding 10 bit values.
+ * GLES2 has no 16 bit texture format, so every sample is uploaded as a
+ * luminance-alpha texel (low byte, high byte) and recombined in the shader.
+ * The planes are sampled with GL_NEAREST, see the constructor.
+ */
+class GLRendererYUV420p10: public GLRendererYUV420p
+{
+public:
+	GLRendererYUV420p10();
+	virtual ~GLRendererYUV420p10() {}
+
+	virtual void getPlaneSize(GLFrame *pic, int plane, GLsizei &width, GLsizei &height);
+};
+	
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * panomesh.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <math.h>
+#include "panomesh.hpp"
+#include "math3d.hpp"
+
+namespace whitebean
+{
+
+static const int MAX_INDEXED_VERTICES = 65536;
+
+/*
+ * Grid of (columns + 1) x (rows + 1) vertices, two triangles per cell
+ */
+static void addGridIndices(PanoMesh &mesh, int base, int columns, int rows)
+{
+	for (int r = 0; r < rows; ++r) {
+		for (int c = 0; c < columns; ++c) {
+			GLushort a = base + r * (columns + 1) + c;
+			GLushort b = a + columns + 1;
+
+			mesh.indices.push_back(a);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(b + 1);
+		}
+	}
+}
+
+int buildSphereMesh(PanoMesh &mesh, float radius, int rings, int sectors)
+{
+	if (rings < 2 || sectors < 3 || (rings + 1) * (sectors + 1) > MAX_INDEXED_VERTICES) {
+		return -1;
+	}
+
+	mesh.vertices.clear();
+	mesh.texCoords.clear();
+	mesh.indices.clear();
+	mesh.vertices.reserve((rings + 1) * (sectors + 1) * 3);
+	mesh.texCoords.reserve((rings + 1) * (sectors + 1) * 2);
+	mesh.indices.reserve(rings * sectors * 6);
+
+	// one sin/cos per sector, reused by every ring
+	std::vector<float> sinPhi(sectors + 1), cosPhi(sectors + 1);
+	for (int s = 0; s <= sectors; ++s) {
+		float phi = 2.0f * (float)PI * s / sectors;
+		sinPhi[s] = sinf(phi);
+		cosPhi[s] = cosf(phi);
+	}
+
+	for (int r = 0; r <= rings; ++r) {
+		float tetta = (float)PI * r / rings;
+		float sinTetta = sinf(tetta);
+		float cosTetta = cosf(tetta);
+
+		for (int s = 0; s <= sectors; ++s) {
+			mesh.vertices.push_back(radius * sinTetta * cosPhi[s]);
+			mesh.vertices.push_back(radius * cosTetta);
+			mesh.vertices.push_back(radius * sinTetta * sinPhi[s]);
+
+			mesh.texCoords.push_back((float)s / sectors);
+			mesh.texCoords.push_back(1.0f - (float)r / rings);
+		}
+	}
+
+	addGridIndices(mesh, 0, sectors, rings);
+
+	return 0;
+}
+
+/*
+ * A cube face as seen from the center: the direction to its center and
+ * the directions of its image right and down edges, plus its tile in the
+ * 3x2 picture. Rotated tiles are stored turned 90 degrees clockwise.
+ */
+struct CubeFace {
+	float center[3];
+	float right[3];
+	float down[3];
+	int column;
+	int row;
+	bool rotated;
+};
+
+/*
+ * Directions match the equirectangular sphere: the picture center is -x,
+ * image right is -z and image down is +y.
+ */
+#define FACE_FRONT  {-1, 0, 0}
+#define FACE_BACK   { 1, 0, 0}
+#define FACE_RIGHT  { 0, 0,-1}
+#define FACE_LEFT   { 0, 0, 1}
+#define FACE_DOWN   { 0, 1, 0}
+#define FACE_UP     { 0,-1, 0}
+
+// right left top / bottom front back, top and bottom seen from the front
+static const CubeFace CUBEMAP_FACES[6] = {
+	{FACE_RIGHT, FACE_BACK,  FACE_DOWN,  0, 0, false},
+	{FACE_LEFT,  FACE_FRONT, FACE_DOWN,  1, 0, false},
+	{FACE_UP,    FACE_RIGHT, FACE_FRONT, 2, 0, false},
+	{FACE_DOWN,  FACE_RIGHT, FACE_BACK,  0, 1, false},
+	{FACE_FRONT, FACE_RIGHT, FACE_DOWN,  1, 1, false},
+	{FACE_BACK,  FACE_LEFT,  FACE_DOWN,  2, 1, false},
+};
+
+// left front right / bottom back top, the bottom row seen from the back
+static const CubeFace EAC_FACES[6] = {
+	{FACE_LEFT,  FACE_FRONT, FACE_DOWN,  0, 0, false},
+	{FACE_FRONT, FACE_RIGHT, FACE_DOWN,  1, 0, false},
+	{FACE_RIGHT, FACE_BACK,  FACE_DOWN,  2, 0, false},
+	{FACE_DOWN,  FACE_LEFT,  FACE_FRONT, 0, 1, true},
+	{FACE_BACK,  FACE_LEFT,  FACE_DOWN,  1, 1, true},
+	{FACE_UP,    FACE_LEFT,  FACE_BACK,  2, 1, true},
+};
+
+int buildCubeMesh(PanoMesh &mesh, float radius, int segments, bool equiAngular)
+{
+	const CubeFace *faces = equiAngular ? EAC_FACES : CUBEMAP_FACES;
+	int faceVertices = (segments + 1) * (segments + 1);
+
+	if (segments < 1 || faceVertices * 6 > MAX_INDEXED_VERTICES) {
+		return -1;
+	}
+
+	mesh.vertices.clear();
+	mesh.texCoords.clear();
+	mesh.indices.clear();
+	mesh.vertices.reserve(faceVertices * 6 * 3);
+	mesh.texCoords.reserve(faceVertices * 6 * 2);
+	mesh.indices.reserve(segments * segments * 6 * 6);
+
+	for (int f = 0; f < 6; ++f) {
+		const CubeFace &face = faces[f];
+		int base = mesh.vertexCount();
+
+		for (int j = 0; j <= segments; ++j) {
+			float b = -1.0f + 2.0f * j / segments;
+
+			for (int i = 0; i <= segments; ++i) {
+				float a = -1.0f + 2.0f * i / segments;
+				float p[3];
+
+				for (int k = 0; k < 3; ++k) {
+					p[k] = face.center[k] + a * face.right[k] + b * face.down[k];
+				}
+
+				float scale = radius / sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+				mesh.vertices.push_back(p[0] * scale);
+				mesh.vertices.push_back(p[1] * scale);
+				mesh.vertices.push_back(p[2] * scale);
+
+				// EAC samples the face evenly in angle, not in tangent
+				float fa = equiAngular ? atanf(a) * 4.0f / (float)PI : a;
+				float fb = equiAngular ? atanf(b) * 4.0f / (float)PI : b;
+				float s = (fa + 1.0f) * 0.5f;
+				float t = (fb + 1.0f) * 0.5f;
+
+				if (face.rotated) {
+					float tmp = s;
+					s = 1.0f - t;
+					t = tmp;
+				}
+
+				mesh.texCoords.push_back((face.column + s) / 3.0f);
+				mesh.texCoords.push_back((face.row + t) / 2.0f);
+			}
+		}
+
+		addGridIndices(mesh, base, segments, segments);
+	}
+
+	return 0;
+}
+
+}
@@ -0,0 +1,48 @@
+/*
+ * panomesh.hpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#ifndef MEDIAPLAYER_MEDIASINK_VIDEOSINK_EGL_UTILS_PANOMESH_HPP_
+#define MEDIAPLAYER_MEDIASINK_VIDEOSINK_EGL_UTILS_PANOMESH_HPP_
+
+#include <vector>
+#include <GLES2/gl2.h>
+
+namespace whitebean
+{
+
+/*
+ * Indexed triangle mesh, 3 floats per vertex, 2 per texture coordinate
+ */
+struct PanoMesh {
+	std::vector<GLfloat> vertices;
+	std::vector<GLfloat> texCoords;
+	std::vector<GLushort> indices;
+
+	int vertexCount() const {
+		return vertices.size() / 3;
+	}
+};
+
+/*
+ * Sphere for equirectangular sources
+ * @param radius sphere radius
+ * @param rings segments from pole to pole
+ * @param sectors segments around the equator
+ * @return 0 ok, -1 if the mesh needs more than 16 bit indices
+ */
+int buildSphereMesh(PanoMesh &mesh, float radius, int rings, int sectors);
+
+/*
+ * Cube for 3x2 cubemap sources, each face is split in segments x segments
+ * quads. With equiAngular the face coordinates are mapped as in the
+ * equi-angular cubemap (EAC) layout, otherwise as in a plain cubemap.
+ * @return 0 ok, -1 if the mesh needs more than 16 bit indices
+ */
+int buildCubeMesh(PanoMesh &mesh, float radius, int segments, bool equiAngular);
+
+}
+
+#endif /* MEDIAPLAYER_MEDIASINK_VIDEOSINK_EGL_UTILS_PANOMESH_HPP_ */
@@ -0,0 +1,99 @@
+/*
+ * abloopbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Loops a range of the file a few times and prints, for each wrap, where
+ * the audio left the loop end and entered the loop start, against the
+ * range set, and how long the sink waited across it. The audio is cut and
+ * joined at the sample, so both ends must be off by less than a sample or
+ * two of rounding.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "WhiteBeanPlayer.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const int64_t LOOP_START_MS = 1000;
+static const int64_t LOOP_END_MS = 3000;
+static const int WRAPS = 5;
+static const int64_t MAX_OFFSET_US = 100;
+
+class LoopListener: public MediaPlayerListener {
+public:
+	LoopListener(): mWraps(0) {}
+
+	virtual void notify(int msg, int ext1, int ext2) {
+		if (msg == WhiteBeanPlayer::MEDIA_INFO && ext1 == WhiteBeanPlayer::MEDIA_INFO_STARTED_AS_NEXT) {
+			unique_lock<mutex> autoLock(mLock);
+			mWraps++;
+			mCond.notify_all();
+		}
+	}
+
+	bool waitFor(int wraps) {
+		unique_lock<mutex> autoLock(mLock);
+		return mCond.wait_for(autoLock, chrono::milliseconds(LOOP_END_MS - LOOP_START_MS + 5000),
+							  [&] { return mWraps >= wraps; });
+	}
+
+private:
+	mutex mLock;
+	condition_variable mCond;
+	int mWraps;
+};
+
+TEST_CASE("ABLoopBench")
+{
+	shared_ptr<MediaPlayerListener> listener(new LoopListener);
+	LoopListener *loopListener = static_cast<LoopListener *>(listener.get());
+
+	unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+	player->setListener(listener);
+	REQUIRE(player->setDataSource(MEDIA_PATH) == 0);
+	REQUIRE(player->prepare() == 0);
+	REQUIRE(player->getDuration() > LOOP_END_MS);
+
+	CHECK(player->setLoopRange(LOOP_END_MS, LOOP_START_MS) < 0);
+	REQUIRE(player->setLoopRange(LOOP_START_MS, LOOP_END_MS) == 0);
+	REQUIRE(player->play() == 0);
+
+	printf("wrap | out - B us | in - A us | audio gap ms | video out ms | video in ms\n");
+
+	for (int i = 1; i <= WRAPS; ++i) {
+		REQUIRE(loopListener->waitFor(i));
+
+		WhiteBeanPlayer::PlaylistStats stats = player->getPlaylistStats();
+		int64_t outUs = stats.lastAudioOutUs - LOOP_END_MS * 1000;
+		int64_t inUs = stats.lastAudioInUs - LOOP_START_MS * 1000;
+
+		CHECK(llabs(outUs) <= MAX_OFFSET_US);
+		CHECK(llabs(inUs) <= MAX_OFFSET_US);
+
+		printf("%4d | %10lld | %9lld | %12.1f | %12.1f | %.1f\n", i, (long long)outUs, (long long)inUs,
+			   stats.lastAudioGapUs / 1000.0, stats.lastVideoOutUs / 1000.0,
+			   stats.lastVideoInUs / 1000.0);
+
+		// never outside the range
+		int64_t positionMs = player->getCurrentPosition();
+		CHECK(positionMs >= LOOP_START_MS - 100);
+		CHECK(positionMs <= LOOP_END_MS + 100);
+	}
+
+	WhiteBeanPlayer::PlaylistStats stats = player->getPlaylistStats();
+	printf("max audio gap %.1f ms over %d wraps\n", stats.maxAudioGapUs / 1000.0, stats.transitions);
+
+	// plays on past the end once the loop is cleared
+	REQUIRE(player->setLoopRange(0, -1) == 0);
+
+	player->stop();
+}
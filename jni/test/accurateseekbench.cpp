@@ -0,0 +1,170 @@
+/*
+ * accurateseekbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Seeks the decoders to the same positions once landing on the key frame
+ * and once accurately, and prints the time from the seek to the first
+ * video frame against how far the target lies behind its key frame.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "MediaSource.hpp"
+#include "MediaCodec.hpp"
+#include "MediaRuntime.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const int SEEKS = 20;
+
+struct SeekResult {
+	int64_t latencyUs;
+	int64_t videoPts;
+	int64_t audioPts;
+	int discarded;
+};
+
+class SeekWaiter: public IMediaListener {
+public:
+	SeekWaiter(): mDone(false) {}
+
+	virtual int mediaNotify(int msg, int arg1, int arg2) override {
+		if (msg == SOURCE_SEEK_COMPLETE) {
+			unique_lock<mutex> autoLock(mLock);
+			mDone = true;
+			mCond.notify_all();
+		}
+		return 0;
+	}
+
+	bool wait() {
+		unique_lock<mutex> autoLock(mLock);
+		bool done = mCond.wait_for(autoLock, chrono::seconds(5), [&] { return mDone; });
+		mDone = false;
+		return done;
+	}
+
+private:
+	mutex mLock;
+	condition_variable mCond;
+	bool mDone;
+};
+
+// the handshake WhiteBeanPlayer runs for a seek
+static SeekResult seek(shared_ptr<MediaSource> &source, SeekWaiter &waiter,
+					   MediaDecoder &audioDecoder, MediaDecoder &videoDecoder,
+					   int64_t msec, bool accurate)
+{
+	SeekResult result = {0, -1, -1, 0};
+	int discarded = audioDecoder.getDiscardedFrames() + videoDecoder.getDiscardedFrames();
+
+	auto start = chrono::steady_clock::now();
+
+	source->seekTo(msec);
+	videoDecoder.seekTo(msec, accurate);
+	audioDecoder.seekTo(msec, accurate);
+
+	REQUIRE(waiter.wait());
+
+	audioDecoder.resume();
+	videoDecoder.resume();
+
+	auto deadline = start + chrono::seconds(10);
+	FrameBuffer frmbuf;
+
+	while (result.videoPts < 0 && chrono::steady_clock::now() < deadline) {
+		bool idle = true;
+
+		// keep audio flowing, the source stops demuxing on a full queue
+		while (audioDecoder.read(frmbuf)) {
+			if (result.audioPts < 0) {
+				result.audioPts = frmbuf.getPts();
+			}
+			idle = false;
+		}
+
+		if (videoDecoder.read(frmbuf)) {
+			result.videoPts = frmbuf.getPts();
+			idle = false;
+		}
+
+		if (idle) {
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+
+	result.latencyUs = chrono::duration_cast<chrono::microseconds>(
+		chrono::steady_clock::now() - start).count();
+	result.discarded = audioDecoder.getDiscardedFrames() + videoDecoder.getDiscardedFrames() - discarded;
+
+	return result;
+}
+
+TEST_CASE("AccurateSeekBench")
+{
+	MediaRuntime::instance().initFFmpeg();
+
+	shared_ptr<MediaSource> source(new MediaSource);
+	REQUIRE(source->open(MEDIA_PATH) == 0);
+	REQUIRE(source->hasAudio());
+	REQUIRE(source->hasVideo());
+
+	SeekWaiter waiter;
+	source->setListener(&waiter);
+
+	MediaDecoder audioDecoder, videoDecoder;
+	REQUIRE(audioDecoder.open(source, source->getAudioStreamId()) == 0);
+	REQUIRE(videoDecoder.open(source, source->getVideoStreamId()) == 0);
+	audioDecoder.setListener(source.get());
+	videoDecoder.setListener(source.get());
+
+	source->start();
+	audioDecoder.start();
+	videoDecoder.start();
+
+	int64_t durationMs = source->getFmtCtxPtr()->duration / 1000;
+	REQUIRE(durationMs > 0);
+
+	int64_t keyframeTotalUs = 0, accurateTotalUs = 0;
+
+	printf("behind key frame | key frame seek | accurate seek | frames dropped\n");
+
+	for (int i = 0; i < SEEKS; ++i) {
+		// not in order, and off the key frames
+		int64_t msec = durationMs * ((i * 7) % SEEKS) / SEEKS + 333;
+		int64_t targetUs = msec * 1000;
+
+		SeekResult keyframe = seek(source, waiter, audioDecoder, videoDecoder, msec, false);
+		SeekResult accurate = seek(source, waiter, audioDecoder, videoDecoder, msec, true);
+
+		REQUIRE(keyframe.videoPts >= 0);
+		REQUIRE(accurate.videoPts >= 0);
+
+		// at most a frame before the target, never the key frame before it
+		CHECK(accurate.videoPts >= keyframe.videoPts);
+		CHECK(targetUs - accurate.videoPts < 100000);
+		CHECK(accurate.audioPts >= targetUs);
+
+		printf("%13lld ms | %11lld us | %10lld us | %d\n",
+			   (long long)((targetUs - keyframe.videoPts) / 1000),
+			   (long long)keyframe.latencyUs, (long long)accurate.latencyUs, accurate.discarded);
+
+		keyframeTotalUs += keyframe.latencyUs;
+		accurateTotalUs += accurate.latencyUs;
+	}
+
+	printf("average: key frame %lld us, accurate %lld us\n",
+		   (long long)(keyframeTotalUs / SEEKS), (long long)(accurateTotalUs / SEEKS));
+
+	source->stop();
+	audioDecoder.stop();
+	videoDecoder.stop();
+}
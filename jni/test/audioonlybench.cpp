@@ -0,0 +1,142 @@
+/*
+ * audioonlybench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Decodes the same seconds of media with and without the video stream and
+ * prints the CPU time per media second and the resident memory of each run.
+ * Frames are consumed as soon as they are decoded, so the CPU figures are
+ * the decode cost without any clock waits.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "MediaSource.hpp"
+#include "MediaCodec.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const int64_t MEDIA_US = 10 * US_IN_SECOND;
+
+struct BenchResult {
+	int64_t cpuUs;
+	int64_t mediaUs;
+	long rssKb;
+	int videoFrames;
+};
+
+static int64_t cpuTimeUs()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * US_IN_SECOND
+		 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static long residentKb()
+{
+	long pages = 0, resident = 0;
+	FILE *fp = fopen("/proc/self/statm", "r");
+	if (fp) {
+		if (fscanf(fp, "%ld %ld", &pages, &resident) != 2) {
+			resident = 0;
+		}
+		fclose(fp);
+	}
+
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static BenchResult run(bool audioOnly)
+{
+	BenchResult result = {0, 0, 0, 0};
+
+	shared_ptr<MediaSource> source(new MediaSource);
+	REQUIRE(source->open(MEDIA_PATH) == 0);
+	REQUIRE(source->hasAudio());
+	REQUIRE(source->hasVideo());
+
+	MediaDecoder audioDecoder, videoDecoder;
+	REQUIRE(audioDecoder.open(source, source->getAudioStreamId()) == 0);
+	REQUIRE(videoDecoder.open(source, source->getVideoStreamId()) == 0);
+
+	// as WhiteBeanPlayer::setAudioOnly() does
+	if (audioOnly) {
+		source->setVideoDiscard(true);
+		videoDecoder.suspend();
+	}
+
+	int64_t startCpuUs = cpuTimeUs();
+	int64_t firstPts = -1, lastPts = -1;
+
+	source->start();
+	audioDecoder.start();
+	videoDecoder.start();
+
+	auto deadline = chrono::steady_clock::now() + chrono::seconds(60);
+
+	while (lastPts - firstPts < MEDIA_US && chrono::steady_clock::now() < deadline) {
+		bool idle = true;
+		FrameBuffer frmbuf;
+
+		if (audioDecoder.read(frmbuf)) {
+			if (firstPts < 0) {
+				firstPts = frmbuf.getPts();
+			}
+			lastPts = frmbuf.getPts();
+			idle = false;
+		}
+
+		while (videoDecoder.read(frmbuf)) {
+			result.videoFrames++;
+			idle = false;
+		}
+
+		if (idle) {
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+
+	result.cpuUs = cpuTimeUs() - startCpuUs;
+	result.mediaUs = lastPts - firstPts;
+	result.rssKb = residentKb();
+
+	source->stop();
+	audioDecoder.stop();
+	videoDecoder.stop();
+
+	return result;
+}
+
+TEST_CASE("AudioOnlyBench")
+{
+	av_register_all();
+	avcodec_register_all();
+	avfilter_register_all();
+
+	// audio only first, so that it is not charged for the heap grown by
+	// the full run
+	BenchResult audio = run(true);
+	BenchResult full = run(false);
+
+	REQUIRE(audio.mediaUs > 0);
+	REQUIRE(full.mediaUs > 0);
+	CHECK(audio.videoFrames == 0);
+	CHECK(full.videoFrames > 0);
+
+	double audioCpu = audio.cpuUs / 1000.0 / (audio.mediaUs / (double)US_IN_SECOND);
+	double fullCpu = full.cpuUs / 1000.0 / (full.mediaUs / (double)US_IN_SECOND);
+
+	printf("audio+video: %.1f ms cpu per media second, rss %ld kB, %d video frames\n",
+		   fullCpu, full.rssKb, full.videoFrames);
+	printf("audio only:  %.1f ms cpu per media second, rss %ld kB\n", audioCpu, audio.rssKb);
+	printf("saved:       %.1f%% cpu, %ld kB rss\n", 100.0 * (fullCpu - audioCpu) / fullCpu,
+		   full.rssKb - audio.rssKb);
+
+	CHECK(audioCpu < fullCpu);
+}
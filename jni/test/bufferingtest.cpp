@@ -0,0 +1,189 @@
+/*
+ * bufferingtest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Demuxes the file through a reader throttled below its bitrate, standing
+ * in for a slow network, while a consumer takes packets at real time as
+ * the decoders would. The clock has to stop under the low watermark and
+ * only go on again at the high one.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "BufferingMonitor.hpp"
+#include "FileReader.hpp"
+#include "MediaSource.hpp"
+#include "MediaRuntime.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const int64_t LOW_US = 300000;
+static const int64_t HIGH_US = 1500000;
+static const int RUN_MS = 15000;
+static const int TICK_MS = 20;
+
+// reads no faster than bytesPerSecond on average
+class ThrottledReader: public ByteReader {
+public:
+	ThrottledReader(shared_ptr<ByteReader> upstream, int64_t bytesPerSecond)
+		: mUpstream(upstream)
+		, mRate(bytesPerSecond)
+		, mBytes(0)
+		, mStart(chrono::steady_clock::now()) {}
+
+	virtual int read(uint8_t *buf, int size) override {
+		int n = mUpstream->read(buf, min(size, 16 * 1024));
+		if (n > 0) {
+			mBytes += n;
+			this_thread::sleep_until(mStart + chrono::microseconds(mBytes * 1000000 / mRate));
+		}
+		return n;
+	}
+
+	virtual int64_t seek(int64_t pos) override {
+		return mUpstream->seek(pos);
+	}
+
+	virtual int64_t tell() const override {
+		return mUpstream->tell();
+	}
+
+	virtual int64_t size() const override {
+		return mUpstream->size();
+	}
+
+private:
+	shared_ptr<ByteReader> mUpstream;
+	int64_t mRate;
+	int64_t mBytes;
+	chrono::steady_clock::time_point mStart;
+};
+
+// takes the packets of one stream up to the clock
+static void consume(MediaSource &source, int stream, int64_t clockUs, int64_t &consumedUs)
+{
+	if (stream < 0) {
+		return;
+	}
+
+	shared_ptr<MediaTracks> tracks = source.getTracksPtr();
+	AVRational timeBase = source.getTimeScaleOfTrack(stream);
+	PacketBuffer pkt;
+
+	while (consumedUs < clockUs) {
+		bool got = stream == source.getVideoStreamId() ? tracks->readVideo(pkt) : tracks->readAudio(pkt);
+		if (!got) {
+			break;
+		}
+		consumedUs += av_rescale_q(max<int64_t>(pkt.getData().duration, 0), timeBase, AV_TIME_BASE_Q);
+	}
+}
+
+static BufferingMonitor::Stats playThrough(double speed)
+{
+	shared_ptr<FileReader> file(new FileReader);
+	REQUIRE(file->open(MEDIA_PATH) == 0);
+
+	int64_t durationUs;
+	{
+		MediaSource probe;
+		REQUIRE(probe.open(MEDIA_PATH) == 0);
+		durationUs = probe.getFmtCtxPtr()->duration;
+	}
+	REQUIRE(durationUs > 0);
+
+	int64_t rate = max<int64_t>(file->size() * speed * 1000000 / durationUs, 1);
+	shared_ptr<ThrottledReader> reader(new ThrottledReader(file, rate));
+
+	MediaSource source;
+	source.setByteReader(reader);
+	source.setPrefetchSize(0);
+	REQUIRE(source.open(MEDIA_PATH) == 0);
+	source.start();
+
+	BufferingMonitor monitor(LOW_US, HIGH_US);
+	int64_t clockUs = 0;
+	int64_t videoUs = 0;
+	int64_t audioUs = 0;
+	auto last = chrono::steady_clock::now();
+	auto deadline = last + chrono::milliseconds(RUN_MS);
+
+	while (chrono::steady_clock::now() < deadline && !source.eof()) {
+		this_thread::sleep_for(chrono::milliseconds(TICK_MS));
+
+		auto now = chrono::steady_clock::now();
+		if (!monitor.buffering()) {
+			clockUs += chrono::duration_cast<chrono::microseconds>(now - last).count();
+		}
+		last = now;
+
+		consume(source, source.getVideoStreamId(), clockUs, videoUs);
+		consume(source, source.getAudioStreamId(), clockUs, audioUs);
+
+		int64_t bufferedUs = source.getBufferedUs();
+		bool complete = source.eof() || source.bufferFull();
+
+		switch (monitor.update(bufferedUs, complete)) {
+		case BufferingMonitor::BUFFERING_START:
+			CHECK(bufferedUs < LOW_US);
+			break;
+		case BufferingMonitor::BUFFERING_END:
+			CHECK((complete || bufferedUs >= HIGH_US));
+			break;
+		default:
+			break;
+		}
+	}
+
+	source.stop();
+
+	BufferingMonitor::Stats stats = monitor.getStats();
+	printf("%.2fx bitrate: played %lld ms, %d underruns, %lld ms buffering\n", speed,
+		   (long long)clockUs / 1000, stats.underruns, (long long)stats.bufferingUs / 1000);
+
+	return stats;
+}
+
+TEST_CASE("Buffering")
+{
+	MediaRuntime::instance().initFFmpeg();
+
+	SECTION("Watermarks") {
+		BufferingMonitor monitor(LOW_US, HIGH_US);
+
+		CHECK(monitor.update(HIGH_US, false) == BufferingMonitor::NONE);
+		CHECK(monitor.update(LOW_US - 1, false) == BufferingMonitor::BUFFERING_START);
+		CHECK(monitor.buffering());
+		// over low is not enough to go on
+		CHECK(monitor.update(LOW_US * 2, false) == BufferingMonitor::NONE);
+		CHECK(monitor.update(HIGH_US, false) == BufferingMonitor::BUFFERING_END);
+
+		// the end of the stream goes on with what is left
+		CHECK(monitor.update(0, false) == BufferingMonitor::BUFFERING_START);
+		CHECK(monitor.update(0, true) == BufferingMonitor::BUFFERING_END);
+		CHECK(monitor.update(0, true) == BufferingMonitor::NONE);
+
+		CHECK(monitor.getStats().underruns == 2);
+		CHECK(monitor.setWatermarks(-1, 0) < 0);
+	}
+
+	SECTION("Slow source") {
+		// starts buffering, then again whenever the queue runs dry
+		BufferingMonitor::Stats stats = playThrough(0.7);
+		CHECK(stats.underruns > 1);
+		CHECK(stats.bufferingUs > 0);
+	}
+
+	SECTION("Fast source") {
+		// only the initial fill
+		BufferingMonitor::Stats stats = playThrough(4.0);
+		CHECK(stats.underruns <= 1);
+	}
+}
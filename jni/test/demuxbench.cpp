@@ -0,0 +1,86 @@
+/*
+ * demuxbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Demuxes a whole file through the FFmpeg file protocol, the mapped reader
+ * and the buffered reader, and prints the throughput and the read syscalls
+ * (syscr of /proc/self/io) of each. Use a large high bitrate file.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "MediaSource.hpp"
+#include "MediaRuntime.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+
+static int64_t readSyscalls()
+{
+	char line[128];
+	long long value = 0;
+	FILE *fp = fopen("/proc/self/io", "r");
+
+	if (!fp) {
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "syscr: %lld", &value) == 1) {
+			break;
+		}
+	}
+	fclose(fp);
+
+	return value;
+}
+
+static void demux(const char *name, int mode, size_t readAhead = FileReader::DEFAULT_READ_AHEAD)
+{
+	MediaSource source;
+	source.setLocalIO(mode, readAhead);
+	REQUIRE(source.open(MEDIA_PATH) == 0);
+
+	AVFormatContext *ctx = source.getFmtCtxPtr().get();
+	AVPacket pkt;
+	int64_t bytes = 0, packets = 0;
+
+	av_init_packet(&pkt);
+
+	int64_t syscalls = readSyscalls();
+	auto start = chrono::steady_clock::now();
+
+	while (av_read_frame(ctx, &pkt) >= 0) {
+		bytes += pkt.size;
+		packets++;
+		av_packet_unref(&pkt);
+	}
+
+	int64_t us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+	syscalls = readSyscalls() - syscalls;
+
+	printf("%-10s %lld packets, %.1f MB/s, %lld read syscalls\n", name, (long long)packets,
+		   bytes / (double)us, (long long)syscalls);
+
+	CHECK(packets > 0);
+
+	source.stop();
+}
+
+TEST_CASE("DemuxBench")
+{
+	MediaRuntime::instance().initFFmpeg();
+
+	// once to get the file into the page cache, every run then reads it warm
+	demux("warmup", MediaSource::LOCAL_IO_PROTOCOL);
+
+	demux("protocol", MediaSource::LOCAL_IO_PROTOCOL);
+	demux("mmap", FileReader::MODE_MMAP);
+	demux("buffered", FileReader::MODE_BUFFERED);
+	demux("buf 256k", FileReader::MODE_BUFFERED, 256 * 1024);
+}
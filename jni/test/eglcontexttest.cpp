@@ -0,0 +1,85 @@
+/*
+ * eglcontexttest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Creates offscreen sinks one after the other, as a player does on surface
+ * changes: the second sink should get the pooled context and renderer and
+ * still render the same picture.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "mediasink/videosink/egl/EglSink.hpp"
+#include "mediasink/videosink/egl/EglContextManager.hpp"
+#include "mediabase/Clock.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const int WIDTH = 160;
+static const int HEIGHT = 120;
+
+static vector<uint8_t> renderOnNewSink(vector<uint8_t> &y, vector<uint8_t> &u, vector<uint8_t> &v,
+									   int64_t &initUs)
+{
+	AVFrame frame;
+	memset(&frame, 0, sizeof(frame));
+	frame.format = AV_PIX_FMT_YUV420P;
+	frame.width = WIDTH;
+	frame.height = HEIGHT;
+	frame.data[0] = y.data();
+	frame.data[1] = u.data();
+	frame.data[2] = v.data();
+	frame.linesize[0] = WIDTH;
+	frame.linesize[1] = WIDTH / 2;
+	frame.linesize[2] = WIDTH / 2;
+
+	vector<uint8_t> pixels(WIDTH * HEIGHT * 4);
+
+	EglSink sink(WIDTH, HEIGHT);
+
+	int64_t start = nowUs();
+	REQUIRE(sink.init(VIDEO_SINK_TYPE_NORMAL) == 0);
+	initUs = nowUs() - start;
+
+	FrameBuffer frm(frame);
+	REQUIRE(sink.display(frm) == 0);
+	REQUIRE(sink.readPixels(pixels.data(), pixels.size()) == 0);
+
+	return pixels;
+}
+
+TEST_CASE("EglContextReuse")
+{
+	vector<uint8_t> y(WIDTH * HEIGHT), u(WIDTH * HEIGHT / 4), v(WIDTH * HEIGHT / 4);
+
+	for (size_t i = 0; i < y.size(); ++i) {
+		y[i] = 16 + i % 200;
+	}
+	for (size_t i = 0; i < u.size(); ++i) {
+		u[i] = 64 + i % 128;
+		v[i] = 192 - i % 128;
+	}
+
+	EglContextManager &manager = EglContextManager::instance();
+
+	int64_t firstUs, secondUs;
+	vector<uint8_t> first = renderOnNewSink(y, u, v, firstUs);
+	EglContextManager::Stats before = manager.getStats();
+
+	vector<uint8_t> second = renderOnNewSink(y, u, v, secondUs);
+	EglContextManager::Stats after = manager.getStats();
+
+	CHECK(after.contextsCreated == before.contextsCreated);
+	CHECK(after.contextsReused == before.contextsReused + 1);
+	CHECK(after.renderersCreated == before.renderersCreated);
+	CHECK(after.renderersReused == before.renderersReused + 1);
+
+	CHECK(first == second);
+
+	printf("sink init: first %lld us, reused %lld us\n", (long long)firstUs, (long long)secondUs);
+}
@@ -0,0 +1,112 @@
+/*
+ * filereadertest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Reads a generated file through both FileReader modes, in order and at
+ * random positions, and compares every byte with the file contents.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "mediabase/FileReader.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *PATH = "/data/local/tmp/filereadertest.bin";
+static const size_t SIZE = 3 * 1024 * 1024 + 123;
+
+static vector<uint8_t> writeFile()
+{
+	vector<uint8_t> data(SIZE);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = (uint8_t)(i * 31 + (i >> 11));
+	}
+
+	FILE *fp = fopen(PATH, "wb");
+	REQUIRE(fp != nullptr);
+	REQUIRE(fwrite(data.data(), 1, data.size(), fp) == data.size());
+	fclose(fp);
+
+	return data;
+}
+
+static void readAll(FileReader &reader, const vector<uint8_t> &data, int chunk)
+{
+	vector<uint8_t> out;
+	vector<uint8_t> buf(chunk);
+	int n;
+
+	REQUIRE(reader.seek(0) == 0);
+	while ((n = reader.read(buf.data(), chunk)) > 0) {
+		out.insert(out.end(), buf.begin(), buf.begin() + n);
+	}
+
+	CHECK(n == 0);
+	CHECK(out == data);
+}
+
+static void readRandom(FileReader &reader, const vector<uint8_t> &data)
+{
+	srand(1);
+
+	for (int i = 0; i < 500; ++i) {
+		int64_t pos = rand() % (SIZE + 100);
+		int size = 1 + rand() % (256 * 1024);
+		vector<uint8_t> buf(size);
+
+		REQUIRE(reader.seek(pos) == pos);
+		int n = reader.read(buf.data(), size);
+
+		if (pos >= (int64_t)SIZE) {
+			CHECK(n == 0);
+			continue;
+		}
+
+		REQUIRE(n > 0);
+		CHECK(reader.tell() == pos + n);
+		CHECK(equal(buf.begin(), buf.begin() + n, data.begin() + pos));
+	}
+}
+
+TEST_CASE("FileReader")
+{
+	vector<uint8_t> data = writeFile();
+
+	SECTION("Mapped") {
+		FileReader reader(FileReader::MODE_MMAP);
+		REQUIRE(reader.open(PATH) == 0);
+		REQUIRE(reader.getMode() == FileReader::MODE_MMAP);
+		REQUIRE(reader.size() == (int64_t)SIZE);
+
+		readAll(reader, data, 32 * 1024);
+		readRandom(reader, data);
+	}
+
+	SECTION("Buffered") {
+		FileReader reader(FileReader::MODE_BUFFERED, 256 * 1024);
+		REQUIRE(reader.open(PATH) == 0);
+		REQUIRE(reader.getMode() == FileReader::MODE_BUFFERED);
+		REQUIRE(reader.size() == (int64_t)SIZE);
+
+		readAll(reader, data, 32 * 1024);
+
+		// one pread per read-ahead block
+		FileReader::Stats stats = reader.getStats();
+		CHECK(stats.syscalls <= (int64_t)(SIZE / (256 * 1024) + 2));
+
+		readAll(reader, data, 1024 * 1024);
+		readRandom(reader, data);
+	}
+
+	SECTION("Missing") {
+		FileReader reader;
+		CHECK(reader.open("/data/local/tmp/no/such/file") < 0);
+		CHECK(reader.read(nullptr, 1) < 0);
+	}
+
+	remove(PATH);
+}
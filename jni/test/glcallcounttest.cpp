@@ -0,0 +1,192 @@
+/*
+ * glcallcounttest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Renderer micro-benchmark: the GL entry points used by the renderers are
+ * replaced with counting stubs, so no context is needed. Build this file
+ * with testrunner.cpp only, the stubs must not be mixed with tests that
+ * need a real GL context.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "mediasink/videosink/egl/GLRendererFactory.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static map<string, int> sGlCalls;
+static GLuint sGlNames = 1;
+
+#define GL_STUB(name, args) \
+	extern "C" void name args { sGlCalls[#name]++; }
+#define GL_STUB_RET(ret, name, args, val) \
+	extern "C" ret name args { sGlCalls[#name]++; return val; }
+
+GL_STUB_RET(GLuint, glCreateShader, (GLenum type), sGlNames++)
+GL_STUB(glShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length))
+GL_STUB(glCompileShader, (GLuint shader))
+GL_STUB(glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog))
+GL_STUB(glDeleteShader, (GLuint shader))
+GL_STUB_RET(GLuint, glCreateProgram, (void), sGlNames++)
+GL_STUB(glAttachShader, (GLuint program, GLuint shader))
+GL_STUB(glLinkProgram, (GLuint program))
+GL_STUB(glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog))
+GL_STUB(glDeleteProgram, (GLuint program))
+GL_STUB(glUseProgram, (GLuint program))
+GL_STUB_RET(const GLubyte *, glGetString, (GLenum name), (const GLubyte *)"stub")
+GL_STUB_RET(GLenum, glGetError, (void), GL_NO_ERROR)
+GL_STUB_RET(GLint, glGetAttribLocation, (GLuint program, const GLchar *name), 1)
+GL_STUB_RET(GLint, glGetUniformLocation, (GLuint program, const GLchar *name), 1)
+GL_STUB(glEnableVertexAttribArray, (GLuint index))
+GL_STUB(glBindBuffer, (GLenum target, GLuint buffer))
+GL_STUB(glBufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage))
+GL_STUB(glDeleteBuffers, (GLsizei n, const GLuint *buffers))
+GL_STUB(glDeleteTextures, (GLsizei n, const GLuint *textures))
+GL_STUB(glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data))
+GL_STUB(glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized,
+								GLsizei stride, const void *pointer))
+GL_STUB(glPixelStorei, (GLenum pname, GLint param))
+GL_STUB(glEnable, (GLenum cap))
+GL_STUB(glActiveTexture, (GLenum texture))
+GL_STUB(glBindTexture, (GLenum target, GLuint texture))
+GL_STUB(glTexParameteri, (GLenum target, GLenum pname, GLint param))
+GL_STUB(glTexParameterf, (GLenum target, GLenum pname, GLfloat param))
+GL_STUB(glUniform1i, (GLint location, GLint v0))
+GL_STUB(glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value))
+GL_STUB(glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+					   GLint border, GLenum format, GLenum type, const void *pixels))
+GL_STUB(glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+						  GLsizei height, GLenum format, GLenum type, const void *pixels))
+GL_STUB(glClear, (GLbitfield mask))
+GL_STUB(glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices))
+GL_STUB(glDrawArrays, (GLenum mode, GLint first, GLsizei count))
+
+extern "C" void glGenBuffers(GLsizei n, GLuint *buffers)
+{
+	sGlCalls["glGenBuffers"]++;
+	for (int i = 0; i < n; ++i) {
+		buffers[i] = sGlNames++;
+	}
+}
+
+extern "C" void glGenTextures(GLsizei n, GLuint *textures)
+{
+	sGlCalls["glGenTextures"]++;
+	for (int i = 0; i < n; ++i) {
+		textures[i] = sGlNames++;
+	}
+}
+
+extern "C" void glGetShaderiv(GLuint shader, GLenum pname, GLint *params)
+{
+	sGlCalls["glGetShaderiv"]++;
+	*params = GL_TRUE;
+}
+
+extern "C" void glGetProgramiv(GLuint program, GLenum pname, GLint *params)
+{
+	sGlCalls["glGetProgramiv"]++;
+	*params = GL_TRUE;
+}
+
+extern "C" void glGetIntegerv(GLenum pname, GLint *data)
+{
+	sGlCalls["glGetIntegerv"]++;
+	if (pname == GL_VIEWPORT) {
+		data[0] = 0;
+		data[1] = 0;
+		data[2] = 1280;
+		data[3] = 720;
+	}
+}
+
+static int countCalls()
+{
+	int n = 0;
+	for (auto &it : sGlCalls) {
+		n += it.second;
+	}
+	return n;
+}
+
+static void renderFrames(GLRenderer &renderer, int frames, int width, int height)
+{
+	int lineSize = (width + 31) & ~31;
+	vector<GLubyte> y(lineSize * height), u(lineSize / 2 * height / 2), v(lineSize / 2 * height / 2);
+	GLFrame pic;
+
+	pic.pixels[0] = y.data();
+	pic.pixels[1] = u.data();
+	pic.pixels[2] = v.data();
+	pic.pitches[0] = lineSize;
+	pic.pitches[1] = lineSize / 2;
+	pic.pitches[2] = lineSize / 2;
+	pic.width = width;
+	pic.height = height;
+
+	for (int i = 0; i < frames; ++i) {
+		renderer.render(&pic);
+	}
+}
+
+TEST_CASE("GLCallCount")
+{
+	const int FRAMES = 100;
+	int types[] = {GL_RENDERER_YUV420P, GL_RENDERER_PANORAMIC_YUV420P, GL_RENDERER_EAC_YUV420P};
+
+	for (int type : types) {
+		shared_ptr<GLRenderer> renderer = GLRendererFactory::create(type);
+		REQUIRE(renderer);
+
+		sGlCalls.clear();
+		REQUIRE(renderer->prepare() == 0);
+		printf("renderer %d: %d GL calls to prepare\n", type, countCalls());
+
+		// the first frames allocate texture storage for both texture sets
+		renderFrames(*renderer, 2, 1920, 1080);
+
+		sGlCalls.clear();
+		renderFrames(*renderer, FRAMES, 1920, 1080);
+
+		printf("renderer %d: %.1f GL calls per frame\n", type, (double)countCalls() / FRAMES);
+		for (auto &it : sGlCalls) {
+			printf("    %-28s %.1f\n", it.first.c_str(), (double)it.second / FRAMES);
+		}
+
+		CHECK(sGlCalls["glGenBuffers"] == 0);
+		CHECK(sGlCalls["glBufferData"] == 0);
+		CHECK(sGlCalls["glGetAttribLocation"] == 0);
+		CHECK(sGlCalls["glTexImage2D"] == 0);
+		CHECK(sGlCalls["glGetUniformLocation"] == 0);
+	}
+}
+
+TEST_CASE("GLPanoRedraw")
+{
+	shared_ptr<GLRenderer> renderer = GLRendererFactory::create(GL_RENDERER_PANORAMIC_YUV420P);
+	REQUIRE(renderer);
+	REQUIRE(renderer->prepare() == 0);
+
+	// nothing uploaded yet
+	CHECK(renderer->redraw() < 0);
+
+	renderFrames(*renderer, 1, 1920, 1080);
+
+	sGlCalls.clear();
+	renderer->onTouchMoveEvent(10.0f, 5.0f);
+	REQUIRE(renderer->redraw() == 0);
+
+	// view change only: new matrix, no upload
+	CHECK(sGlCalls["glUniformMatrix4fv"] == 1);
+	CHECK(sGlCalls["glDrawElements"] == 1);
+	CHECK(sGlCalls["glTexSubImage2D"] == 0);
+
+	sGlCalls.clear();
+	REQUIRE(renderer->redraw() == 0);
+	CHECK(sGlCalls["glUniformMatrix4fv"] == 0);
+}
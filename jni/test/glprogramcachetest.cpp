@@ -0,0 +1,69 @@
+/*
+ * glprogramcachetest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Prepares each renderer twice on an offscreen EglSink: the first prepare
+ * compiles and stores the program, the second one should load it.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <EGL/egl.h>
+#include "mediasink/videosink/egl/EglSink.hpp"
+#include "mediasink/videosink/egl/GLRendererFactory.hpp"
+#include "mediasink/videosink/egl/GLProgramCache.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+TEST_CASE("GLProgramCache")
+{
+#ifdef __ANDROID__
+	char dir[] = "/data/local/tmp/glprogramcacheXXXXXX";
+#else
+	char dir[] = "/tmp/glprogramcacheXXXXXX";
+#endif
+	REQUIRE(mkdtemp(dir));
+
+	EglSink sink(64, 64);
+	REQUIRE(sink.init(VIDEO_SINK_TYPE_NORMAL) == 0);
+
+	// after the sink init, its own renderer must not fill the cache
+	GLProgramCache &cache = GLProgramCache::instance();
+	cache.setDirectory(dir);
+
+	const char *ext = (const char *)glGetString(GL_EXTENSIONS);
+	bool supported = ext && strstr(ext, "GL_OES_get_program_binary");
+
+	int types[] = {GL_RENDERER_YUV420P, GL_RENDERER_NV12, GL_RENDERER_PANORAMIC_YUV420P};
+
+	for (int type : types) {
+		shared_ptr<GLRenderer> first = GLRendererFactory::create(type);
+		REQUIRE(first->prepare() == 0);
+		CHECK(!first->isProgramCached());
+
+		shared_ptr<GLRenderer> second = GLRendererFactory::create(type);
+		REQUIRE(second->prepare() == 0);
+		if (supported) {
+			CHECK(second->isProgramCached());
+		}
+
+		printf("renderer %d: compile %lld us, %s %lld us\n", type,
+			   (long long)first->getProgramTimeUs(), second->isProgramCached() ? "cache load" : "compile",
+			   (long long)second->getProgramTimeUs());
+	}
+
+	GLProgramCache::Stats stats = cache.getStats();
+	printf("program cache: %d hits, %d misses\n", stats.hits, stats.misses);
+
+	if (!supported) {
+		WARN("GL_OES_get_program_binary not supported, every prepare compiles");
+	}
+
+	cache.setDirectory("");
+	string cmd = string("rm -rf ") + dir;
+	system(cmd.c_str());
+}
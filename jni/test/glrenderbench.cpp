@@ -0,0 +1,94 @@
+/*
+ * glrenderbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Upload and draw time per frame of the yuv420p and panoramic renderers,
+ * measured on an offscreen EglSink. On a host, run with a Mesa driver,
+ * e.g. EGL_PLATFORM=surfaceless.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <GLES2/gl2.h>
+#include "mediasink/videosink/egl/EglSink.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+struct BenchFrame {
+	vector<uint8_t> y, u, v;
+	AVFrame frame;
+
+	BenchFrame(int width, int height) {
+		int lineSize = (width + 31) & ~31;
+
+		y.resize(lineSize * height);
+		u.resize(lineSize / 2 * height / 2);
+		v.resize(lineSize / 2 * height / 2);
+
+		for (size_t i = 0; i < y.size(); ++i) {
+			y[i] = i * 7;
+		}
+		for (size_t i = 0; i < u.size(); ++i) {
+			u[i] = i * 3;
+			v[i] = i * 5;
+		}
+
+		memset(&frame, 0, sizeof(frame));
+		frame.format = AV_PIX_FMT_YUV420P;
+		frame.width = width;
+		frame.height = height;
+		frame.data[0] = y.data();
+		frame.data[1] = u.data();
+		frame.data[2] = v.data();
+		frame.linesize[0] = lineSize;
+		frame.linesize[1] = lineSize / 2;
+		frame.linesize[2] = lineSize / 2;
+	}
+};
+
+static void bench(const char *name, int sinkType, int width, int height)
+{
+	const int WARMUP = 5;
+	const int FRAMES = 100;
+
+	EglSink sink(1280, 720);
+	REQUIRE(sink.init(sinkType) == 0);
+
+	BenchFrame bf(width, height);
+	int64_t uploadUs = 0;
+	int64_t totalUs = 0;
+
+	for (int i = 0; i < WARMUP + FRAMES; ++i) {
+		// touch the picture so that every upload carries new data
+		bf.y[i] = i;
+		FrameBuffer frm(bf.frame);
+
+		auto start = chrono::steady_clock::now();
+		REQUIRE(sink.display(frm) == 0);
+		glFinish();
+		auto end = chrono::steady_clock::now();
+
+		if (i >= WARMUP) {
+			uploadUs += sink.getUploadTimeUs();
+			totalUs += chrono::duration_cast<chrono::microseconds>(end - start).count();
+		}
+	}
+
+	vector<uint8_t> pixels(sink.getWidth() * sink.getHeight() * 4);
+	CHECK(sink.readPixels(pixels.data(), pixels.size()) == 0);
+
+	printf("%-12s %4dx%-4d upload %6lld us, upload+draw %6lld us per frame\n",
+		   name, width, height, (long long)(uploadUs / FRAMES), (long long)(totalUs / FRAMES));
+}
+
+TEST_CASE("GLRenderBench")
+{
+	bench("yuv420p", VIDEO_SINK_TYPE_NORMAL, 1280, 720);
+	bench("yuv420p", VIDEO_SINK_TYPE_NORMAL, 1920, 1080);
+	bench("panoramic", VIDEO_SINK_TYPE_PANORAMIC, 2048, 1024);
+	bench("panoramic", VIDEO_SINK_TYPE_PANORAMIC, 3840, 1920);
+}
@@ -0,0 +1,131 @@
+/*
+ * glrenderformattest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Renders the same picture through the NV12, NV21 and 10 bit renderers and
+ * compares the read back pixels with the yuv420p path. Uses an offscreen
+ * EglSink, so any EGL with pbuffer support works (device, or Mesa on a host).
+ */
+
+#include <catch.hpp>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "mediasink/videosink/egl/EglSink.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const int WIDTH = 320;
+static const int HEIGHT = 240;
+
+/*
+ * 8 bit source planes, the other layouts are derived from them
+ */
+struct TestPicture {
+	vector<uint8_t> y, u, v;
+
+	TestPicture() : y(WIDTH * HEIGHT), u(WIDTH * HEIGHT / 4), v(WIDTH * HEIGHT / 4) {
+		for (int j = 0; j < HEIGHT; ++j) {
+			for (int i = 0; i < WIDTH; ++i) {
+				y[j * WIDTH + i] = 16 + (i + j) * 219 / (WIDTH + HEIGHT);
+			}
+		}
+		for (int j = 0; j < HEIGHT / 2; ++j) {
+			for (int i = 0; i < WIDTH / 2; ++i) {
+				u[j * WIDTH / 2 + i] = 16 + i * 224 / (WIDTH / 2);
+				v[j * WIDTH / 2 + i] = 16 + j * 224 / (HEIGHT / 2);
+			}
+		}
+	}
+};
+
+static vector<uint8_t> renderAndRead(EglSink &sink, AVFrame &frame)
+{
+	vector<uint8_t> pixels(WIDTH * HEIGHT * 4);
+	FrameBuffer frm(frame);
+
+	REQUIRE(sink.display(frm) == 0);
+	REQUIRE(sink.readPixels(pixels.data(), pixels.size()) == 0);
+
+	return pixels;
+}
+
+static int maxDiff(const vector<uint8_t> &a, const vector<uint8_t> &b)
+{
+	int diff = 0;
+	for (size_t i = 0; i < a.size(); ++i) {
+		diff = max(diff, abs((int)a[i] - (int)b[i]));
+	}
+	return diff;
+}
+
+static void setPlanes(AVFrame &frame, int format, uint8_t *p0, int l0, uint8_t *p1, int l1,
+					  uint8_t *p2, int l2)
+{
+	memset(&frame, 0, sizeof(frame));
+	frame.format = format;
+	frame.width = WIDTH;
+	frame.height = HEIGHT;
+	frame.data[0] = p0;
+	frame.data[1] = p1;
+	frame.data[2] = p2;
+	frame.linesize[0] = l0;
+	frame.linesize[1] = l1;
+	frame.linesize[2] = l2;
+}
+
+TEST_CASE("GLRenderFormats")
+{
+	EglSink sink(WIDTH, HEIGHT);
+	REQUIRE(sink.init(VIDEO_SINK_TYPE_NORMAL) == 0);
+
+	TestPicture src;
+	AVFrame pic;
+
+	setPlanes(pic, AV_PIX_FMT_YUV420P, src.y.data(), WIDTH, src.u.data(), WIDTH / 2,
+			  src.v.data(), WIDTH / 2);
+	vector<uint8_t> reference = renderAndRead(sink, pic);
+
+	SECTION("NV12")
+	{
+		vector<uint8_t> uv(WIDTH * HEIGHT / 2);
+		for (size_t i = 0; i < src.u.size(); ++i) {
+			uv[2 * i] = src.u[i];
+			uv[2 * i + 1] = src.v[i];
+		}
+
+		setPlanes(pic, AV_PIX_FMT_NV12, src.y.data(), WIDTH, uv.data(), WIDTH, nullptr, 0);
+		CHECK(maxDiff(renderAndRead(sink, pic), reference) <= 2);
+	}
+
+	SECTION("NV21")
+	{
+		vector<uint8_t> vu(WIDTH * HEIGHT / 2);
+		for (size_t i = 0; i < src.u.size(); ++i) {
+			vu[2 * i] = src.v[i];
+			vu[2 * i + 1] = src.u[i];
+		}
+
+		setPlanes(pic, AV_PIX_FMT_NV21, src.y.data(), WIDTH, vu.data(), WIDTH, nullptr, 0);
+		CHECK(maxDiff(renderAndRead(sink, pic), reference) <= 2);
+	}
+
+	SECTION("YUV420P10")
+	{
+		vector<uint16_t> y(src.y.size()), u(src.u.size()), v(src.v.size());
+		for (size_t i = 0; i < y.size(); ++i) {
+			y[i] = src.y[i] << 2;
+		}
+		for (size_t i = 0; i < u.size(); ++i) {
+			u[i] = src.u[i] << 2;
+			v[i] = src.v[i] << 2;
+		}
+
+		setPlanes(pic, AV_PIX_FMT_YUV420P10LE, (uint8_t *)y.data(), WIDTH * 2,
+				  (uint8_t *)u.data(), WIDTH, (uint8_t *)v.data(), WIDTH);
+		// sampled with GL_NEAREST, chroma is not interpolated like the reference
+		CHECK(maxDiff(renderAndRead(sink, pic), reference) <= 4);
+	}
+}
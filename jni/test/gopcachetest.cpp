@@ -0,0 +1,96 @@
+/*
+ * gopcachetest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Steps forward through the first frames of the file, then back over them
+ * again, across several GOP boundaries. Every frame stepped back to must
+ * be the one seen going forward, with the same picture, and the cache must
+ * stay in its budget throughout.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <vector>
+#include "GopCache.hpp"
+#include "MediaRuntime.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const int FRAMES = 300;
+static const int TIMEOUT_MS = 5000;
+
+struct Frame {
+	int64_t pts;
+	uint32_t hash;
+};
+
+static uint32_t hashLuma(const FrameBuffer &frmbuf)
+{
+	// FNV-1a over the visible part of the Y plane
+	uint32_t hash = 2166136261u;
+
+	for (int y = 0; y < frmbuf.getHeight(); ++y) {
+		const uint8_t *row = frmbuf.getDataPlane(0) + y * frmbuf.getLineSize(0);
+		for (int x = 0; x < frmbuf.getWidth(); ++x) {
+			hash = (hash ^ row[x]) * 16777619u;
+		}
+	}
+
+	return hash;
+}
+
+static void stepThrough(size_t budget)
+{
+	GopCache cache(budget);
+	REQUIRE(cache.open(MEDIA_PATH, AV_PIX_FMT_YUV420P) == 0);
+	REQUIRE(cache.start() == 0);
+
+	vector<Frame> frames;
+	FrameBuffer frmbuf;
+	int64_t pts = -1;
+
+	while ((int)frames.size() < FRAMES && cache.getFrame(pts, 1, frmbuf, TIMEOUT_MS) == 0) {
+		REQUIRE(frmbuf.getPts() > pts);
+		pts = frmbuf.getPts();
+		frames.push_back({pts, hashLuma(frmbuf)});
+		CHECK(cache.getStats().cachedBytes <= (int64_t)budget);
+	}
+
+	REQUIRE(frames.size() > 1);
+
+	// every frame comes back, none skipped
+	for (int i = frames.size() - 2; i >= 0; --i) {
+		REQUIRE(cache.getFrame(pts, -1, frmbuf, TIMEOUT_MS) == 0);
+		REQUIRE(frmbuf.getPts() == frames[i].pts);
+		CHECK(hashLuma(frmbuf) == frames[i].hash);
+		pts = frmbuf.getPts();
+		CHECK(cache.getStats().cachedBytes <= (int64_t)budget);
+	}
+
+	CHECK(cache.getFrame(pts, -1, frmbuf, TIMEOUT_MS) < 0);
+
+	GopCache::Stats stats = cache.getStats();
+	printf("budget %zu: %d frames, %d hits, %d misses, %d runs in %lld us, %d evicted\n",
+		   budget, (int)frames.size(), stats.hits, stats.misses, stats.runs,
+		   (long long)stats.decodeUs, stats.evictedFrames);
+	CHECK(stats.failedRuns == 0);
+
+	cache.stop();
+}
+
+TEST_CASE("GopCache")
+{
+	MediaRuntime::instance().initFFmpeg();
+
+	SECTION("Default budget") {
+		stepThrough(GopCache::DEFAULT_BUDGET);
+	}
+
+	SECTION("Small budget") {
+		// a few frames at 720p, runs are cut short and evicted all the time
+		stepThrough(8 * 1024 * 1024);
+	}
+}
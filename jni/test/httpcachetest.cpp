@@ -0,0 +1,373 @@
+/*
+ * httpcachetest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Serves the file over HTTP from a loopback server throttled to a few
+ * MB/s, with range requests, and reads it through HttpCacheReader. What
+ * was fetched once, read again or sought back to, must come from the disk
+ * cache without asking the server, and the cache has to stay within its
+ * capacity. Then the whole file is demuxed over http twice.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "HttpCacheReader.hpp"
+#include "FileReader.hpp"
+#include "MediaSource.hpp"
+#include "MediaRuntime.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const char *CACHE_DIR = "/data/local/tmp/httpcache";
+static const int64_t RATE = 4 * 1024 * 1024;
+static const int PREFIX_BLOCKS = 16;
+
+/*
+ * One connection at a time, which is all a reader keeps open. Answers
+ * GET with 200 or, for a range, 206, and sends at most RATE bytes/s.
+ */
+class ThrottledServer {
+public:
+	explicit ThrottledServer(const vector<uint8_t> &data)
+		: mData(data), mFd(-1), mPort(0), mRequests(0), mSentBytes(0) {}
+
+	~ThrottledServer() {
+		stop();
+	}
+
+	int start() {
+		mFd = socket(AF_INET, SOCK_STREAM, 0);
+		if (mFd < 0) {
+			return -1;
+		}
+
+		struct sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if (bind(mFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(mFd, 4) != 0
+			|| getsockname(mFd, (struct sockaddr *)&addr, &len) != 0) {
+			return -1;
+		}
+
+		mPort = ntohs(addr.sin_port);
+		mThread = thread(&ThrottledServer::serve, this);
+
+		return 0;
+	}
+
+	void stop() {
+		if (mFd >= 0) {
+			shutdown(mFd, SHUT_RDWR);
+			close(mFd);
+			mFd = -1;
+		}
+		if (mThread.joinable()) {
+			mThread.join();
+		}
+	}
+
+	string url() const {
+		return "http://127.0.0.1:" + to_string(mPort) + "/video.mp4";
+	}
+
+	int requests() const {
+		return mRequests;
+	}
+
+	int64_t sentBytes() const {
+		return mSentBytes;
+	}
+
+private:
+	void serve() {
+		int fd;
+
+		while ((fd = accept(mFd, nullptr, nullptr)) >= 0) {
+			handle(fd);
+			close(fd);
+		}
+	}
+
+	void handle(int fd) {
+		string request;
+		char buf[1024];
+
+		while (request.find("\r\n\r\n") == string::npos) {
+			int n = recv(fd, buf, sizeof(buf), 0);
+			if (n <= 0) {
+				return;
+			}
+			request.append(buf, n);
+		}
+
+		mRequests++;
+
+		int64_t size = mData.size();
+		int64_t start = 0;
+		int64_t end = size - 1;
+		bool range = false;
+
+		size_t at = request.find("Range: bytes=");
+		if (at != string::npos) {
+			long long first = 0, last = -1;
+			if (sscanf(request.c_str() + at, "Range: bytes=%lld-%lld", &first, &last) >= 1) {
+				range = true;
+				start = first;
+				if (last >= first && last < size) {
+					end = last;
+				}
+			}
+		}
+
+		char header[256];
+		if (start >= size) {
+			snprintf(header, sizeof(header),
+					 "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%lld\r\n"
+					 "Content-Length: 0\r\nConnection: close\r\n\r\n", (long long)size);
+			send(fd, header, strlen(header), MSG_NOSIGNAL);
+			return;
+		}
+
+		if (range) {
+			snprintf(header, sizeof(header),
+					 "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %lld-%lld/%lld\r\n"
+					 "Content-Length: %lld\r\nAccept-Ranges: bytes\r\nConnection: close\r\n\r\n",
+					 (long long)start, (long long)end, (long long)size, (long long)(end - start + 1));
+		} else {
+			snprintf(header, sizeof(header),
+					 "HTTP/1.1 200 OK\r\nContent-Length: %lld\r\nAccept-Ranges: bytes\r\n"
+					 "Connection: close\r\n\r\n", (long long)size);
+		}
+
+		if (send(fd, header, strlen(header), MSG_NOSIGNAL) < 0) {
+			return;
+		}
+
+		int64_t sent = 0;
+		int64_t begin = nowUs();
+
+		while (start + sent <= end) {
+			int len = min<int64_t>(16 * 1024, end + 1 - start - sent);
+			int n = send(fd, mData.data() + start + sent, len, MSG_NOSIGNAL);
+			if (n <= 0) {
+				// the reader went on to another range
+				return;
+			}
+
+			sent += n;
+			mSentBytes += n;
+			this_thread::sleep_until(chrono::steady_clock::time_point(
+				chrono::microseconds(begin + sent * 1000000 / RATE)));
+		}
+	}
+
+	const vector<uint8_t> &mData;
+	int mFd;
+	int mPort;
+	thread mThread;
+	atomic<int> mRequests;
+	atomic<int64_t> mSentBytes;
+};
+
+static int readFully(ByteReader &reader, uint8_t *buf, int size)
+{
+	int total = 0;
+
+	while (total < size) {
+		int n = reader.read(buf + total, size - total);
+		if (n <= 0) {
+			break;
+		}
+		total += n;
+	}
+
+	return total;
+}
+
+// the blocks [first, first + count) read back unchanged
+static void readBlocks(HttpCacheReader &reader, const vector<uint8_t> &data, int64_t first, int count)
+{
+	vector<uint8_t> buf(HttpCache::BLOCK_SIZE);
+
+	for (int64_t i = first; i < first + count; ++i) {
+		int64_t pos = i * HttpCache::BLOCK_SIZE;
+		int expected = min<int64_t>(HttpCache::BLOCK_SIZE, data.size() - pos);
+
+		REQUIRE(reader.seek(pos) == pos);
+		REQUIRE(readFully(reader, buf.data(), HttpCache::BLOCK_SIZE) == expected);
+		REQUIRE(memcmp(buf.data(), data.data() + pos, expected) == 0);
+	}
+}
+
+TEST_CASE("HttpCache")
+{
+	MediaRuntime::instance().initFFmpeg();
+
+	vector<uint8_t> data;
+	{
+		FileReader file;
+		REQUIRE(file.open(MEDIA_PATH) == 0);
+		data.resize(file.size());
+		REQUIRE(readFully(file, data.data(), data.size()) == (int)data.size());
+	}
+	REQUIRE(data.size() > (size_t)PREFIX_BLOCKS * HttpCache::BLOCK_SIZE);
+
+	ThrottledServer server(data);
+	REQUIRE(server.start() == 0);
+
+	system((string("rm -rf ") + CACHE_DIR + " && mkdir -p " + CACHE_DIR).c_str());
+
+	SECTION("Repeat reads and seeks back") {
+		HttpCache cache;
+		REQUIRE(cache.setDirectory(CACHE_DIR) == 0);
+
+		HttpCacheReader reader(cache);
+		REQUIRE(reader.open(server.url()) == 0);
+		CHECK(reader.size() == (int64_t)data.size());
+
+		int64_t start = nowUs();
+		readBlocks(reader, data, 0, PREFIX_BLOCKS);
+		int64_t coldUs = nowUs() - start;
+
+		// one connection for the whole sequential run
+		CHECK(reader.getStats().connects == 1);
+		int requests = server.requests();
+
+		start = nowUs();
+		readBlocks(reader, data, 0, PREFIX_BLOCKS);
+		int64_t backUs = nowUs() - start;
+		CHECK(server.requests() == requests);
+
+		// a replay with a new reader does not even connect
+		HttpCacheReader replay(cache);
+		REQUIRE(replay.open(server.url()) == 0);
+		start = nowUs();
+		readBlocks(replay, data, 0, PREFIX_BLOCKS);
+		int64_t warmUs = nowUs() - start;
+
+		CHECK(replay.getStats().connects == 0);
+		CHECK(replay.getStats().cachedBlocks == PREFIX_BLOCKS);
+		CHECK(replay.getStats().fetchedBytes == 0);
+		CHECK(server.requests() == requests);
+
+		// the cache survives the process, through the mtimes
+		HttpCache reopened;
+		REQUIRE(reopened.setDirectory(CACHE_DIR) == 0);
+		CHECK(reopened.getStats().blocks == PREFIX_BLOCKS);
+
+		printf("%d blocks: %lld ms from the server, %lld ms seeking back, %lld ms replayed\n",
+			   PREFIX_BLOCKS, (long long)coldUs / 1000, (long long)backUs / 1000,
+			   (long long)warmUs / 1000);
+	}
+
+	SECTION("Jumps") {
+		HttpCache cache;
+		REQUIRE(cache.setDirectory(CACHE_DIR) == 0);
+
+		HttpCacheReader reader(cache);
+		REQUIRE(reader.open(server.url()) == 0);
+
+		// open connects at 0, then a range request per jump; the last
+		// block is short
+		int64_t last = (data.size() - 1) / HttpCache::BLOCK_SIZE;
+		readBlocks(reader, data, last, 1);
+		readBlocks(reader, data, 4, 2);
+		readBlocks(reader, data, 0, 1);
+		CHECK(reader.getStats().connects == 4);
+
+		int requests = server.requests();
+		readBlocks(reader, data, last, 1);
+		readBlocks(reader, data, 4, 2);
+		CHECK(server.requests() == requests);
+	}
+
+	SECTION("Eviction") {
+		// room for a quarter of the blocks read
+		HttpCache cache(PREFIX_BLOCKS / 4 * (HttpCache::BLOCK_SIZE + 1024));
+		REQUIRE(cache.setDirectory(CACHE_DIR) == 0);
+
+		HttpCacheReader reader(cache);
+		REQUIRE(reader.open(server.url()) == 0);
+		readBlocks(reader, data, 0, PREFIX_BLOCKS);
+
+		HttpCache::Stats stats = cache.getStats();
+		CHECK(stats.cachedBytes <= PREFIX_BLOCKS / 4 * (HttpCache::BLOCK_SIZE + 1024));
+		CHECK(stats.evictions >= PREFIX_BLOCKS - PREFIX_BLOCKS / 4);
+
+		// the most recent are kept, the first are gone
+		int fetched = reader.getStats().fetchedBlocks;
+		readBlocks(reader, data, PREFIX_BLOCKS - 2, 2);
+		CHECK(reader.getStats().fetchedBlocks == fetched);
+		readBlocks(reader, data, 0, 1);
+		CHECK(reader.getStats().fetchedBlocks == fetched + 1);
+	}
+
+	SECTION("Playback") {
+		HttpCache &cache = HttpCache::instance();
+		REQUIRE(cache.setDirectory(CACHE_DIR) == 0);
+		cache.setCapacity(HttpCache::DEFAULT_CAPACITY);
+
+		for (int pass = 0; pass < 2; ++pass) {
+			int64_t sent = server.sentBytes();
+			int requests = server.requests();
+			int64_t start = nowUs();
+
+			MediaSource source;
+			REQUIRE(source.open(server.url()) == 0);
+			source.start();
+
+			shared_ptr<MediaTracks> tracks = source.getTracksPtr();
+			PacketBuffer pkt;
+			int packets = 0;
+			auto deadline = chrono::steady_clock::now() + chrono::minutes(5);
+
+			while (chrono::steady_clock::now() < deadline) {
+				bool got = tracks->readVideo(pkt);
+				got = tracks->readAudio(pkt) || got;
+
+				if (got) {
+					packets++;
+				} else if (source.eof()) {
+					break;
+				} else {
+					this_thread::sleep_for(chrono::milliseconds(1));
+				}
+			}
+
+			source.stop();
+
+			CHECK(source.eof());
+			CHECK(packets > 0);
+			// the replay is served from the cache alone
+			if (pass == 1) {
+				CHECK(server.requests() == requests);
+			}
+
+			printf("pass %d: %d packets in %lld ms, %d requests, %lld bytes from the server\n",
+				   pass, packets, (long long)(nowUs() - start) / 1000, server.requests() - requests,
+				   (long long)(server.sentBytes() - sent));
+		}
+
+		cache.clear();
+	}
+
+	server.stop();
+}
@@ -0,0 +1,91 @@
+/*
+ * keyframeindextest.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include "mediabase/KeyframeIndex.hpp"
+
+using namespace whitebean;
+
+// one key every 10 packets, pts 100 apart, pos 1000 apart
+static void demux(KeyframeIndex &index, int from, int to)
+{
+	for (int i = from; i < to; ++i) {
+		index.addPacket(i * 100, i * 1000, i % 10 == 0);
+	}
+}
+
+TEST_CASE("KeyframeIndex")
+{
+	KeyframeIndex index;
+	KeyframeIndex::Entry entry;
+
+	index.setMode(KeyframeIndex::MODE_BYTES);
+
+	SECTION("Lookup") {
+		demux(index, 0, 35);
+
+		REQUIRE(index.lookup(2550, entry));
+		CHECK(entry.ts == 2000);
+		CHECK(entry.pos == 20000);
+
+		REQUIRE(index.lookup(3000, entry));
+		CHECK(entry.ts == 3000);
+
+		// not demuxed yet, a key may come before it
+		CHECK_FALSE(index.lookup(3500, entry));
+	}
+
+	SECTION("Spans") {
+		// the jump skips the keys at 1000 and 2000
+		demux(index, 0, 5);
+		index.discontinuity();
+		demux(index, 25, 45);
+		index.discontinuity();
+
+		CHECK(index.lookup(400, entry));
+		CHECK_FALSE(index.lookup(1500, entry));
+		CHECK_FALSE(index.lookup(2600, entry));	// before the first key of the span
+		REQUIRE(index.lookup(3200, entry));
+		CHECK(entry.ts == 3000);
+
+		// filling the gap joins the spans
+		demux(index, 0, 30);
+		index.discontinuity();
+
+		REQUIRE(index.lookup(2600, entry));
+		CHECK(entry.ts == 2000);
+		REQUIRE(index.lookup(1500, entry));
+		CHECK(entry.ts == 1000);
+	}
+
+	SECTION("Persist") {
+		const char *path = "/data/local/tmp/keyframeindextest.bin";
+
+		demux(index, 0, 50);
+		CHECK(index.isDirty());
+
+		FILE *fp = fopen(path, "wb");
+		REQUIRE(fp != nullptr);
+		REQUIRE(index.write(fp) == 0);
+		fclose(fp);
+
+		KeyframeIndex loaded;
+		fp = fopen(path, "rb");
+		REQUIRE(fp != nullptr);
+		REQUIRE(loaded.read(fp) == 0);
+		fclose(fp);
+		remove(path);
+
+		CHECK(loaded.getMode() == KeyframeIndex::MODE_BYTES);
+		CHECK(loaded.getEntries().size() == 5);
+		CHECK_FALSE(loaded.isDirty());
+
+		REQUIRE(loaded.lookup(4321, entry));
+		CHECK(entry.ts == 4000);
+		CHECK(entry.pos == 40000);
+	}
+}
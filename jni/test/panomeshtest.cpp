@@ -0,0 +1,76 @@
+/*
+ * panomeshtest.cpp
+ *
+ *  Created on: 2026年10月18日
+ */
+
+#include <catch.hpp>
+#include <math.h>
+#include "mediasink/videosink/egl/utils/panomesh.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static void checkMesh(const PanoMesh &mesh, float radius)
+{
+	REQUIRE(mesh.vertices.size() % 3 == 0);
+	REQUIRE(mesh.texCoords.size() == mesh.vertices.size() / 3 * 2);
+	REQUIRE(mesh.indices.size() % 3 == 0);
+
+	for (size_t i = 0; i < mesh.vertices.size(); i += 3) {
+		float x = mesh.vertices[i], y = mesh.vertices[i + 1], z = mesh.vertices[i + 2];
+		CHECK(sqrtf(x * x + y * y + z * z) == Approx(radius).epsilon(0.001));
+	}
+
+	for (float t : mesh.texCoords) {
+		CHECK(t >= 0.0f);
+		CHECK(t <= 1.0f);
+	}
+
+	for (GLushort idx : mesh.indices) {
+		CHECK(idx < mesh.vertexCount());
+	}
+}
+
+TEST_CASE("PanoMeshSphere")
+{
+	PanoMesh mesh;
+
+	REQUIRE(buildSphereMesh(mesh, 5.0f, 64, 128) == 0);
+	CHECK(mesh.vertexCount() == 65 * 129);
+	CHECK(mesh.indices.size() == 64 * 128 * 6);
+	checkMesh(mesh, 5.0f);
+
+	// too many vertices for 16 bit indices
+	CHECK(buildSphereMesh(mesh, 5.0f, 256, 512) < 0);
+}
+
+TEST_CASE("PanoMeshCube")
+{
+	PanoMesh mesh;
+
+	SECTION("cubemap")
+	{
+		REQUIRE(buildCubeMesh(mesh, 5.0f, 16, false) == 0);
+		CHECK(mesh.vertexCount() == 6 * 17 * 17);
+		checkMesh(mesh, 5.0f);
+	}
+
+	SECTION("eac")
+	{
+		REQUIRE(buildCubeMesh(mesh, 5.0f, 16, true) == 0);
+		checkMesh(mesh, 5.0f);
+
+		// front face center is the picture center
+		int center = 1 * 17 * 17 + 8 * 17 + 8;
+		CHECK(mesh.vertices[center * 3] == Approx(-5.0f));
+		CHECK(mesh.texCoords[center * 2] == Approx(0.5f));
+		CHECK(mesh.texCoords[center * 2 + 1] == Approx(0.25f));
+
+		// equal angles on the face map to equal texture steps
+		int quarter = 1 * 17 * 17 + 8 * 17 + 12;
+		float angle = atan2f(-mesh.vertices[quarter * 3 + 2], -mesh.vertices[quarter * 3]);
+		CHECK(angle == Approx(atanf(0.5f)));
+		CHECK(mesh.texCoords[quarter * 2] == Approx((1.0f + 0.5f + atanf(0.5f) * 2.0f / (float)M_PI) / 3.0f));
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * playercreatebench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Creates, prepares and tears down 100 players, as a feed scrolling
+ * through items does, and opens 100 audio sinks on the shared OpenSL
+ * engine. For comparison it also times an engine created per sink, which
+ * is what every OpenslSink used to do.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include "WhiteBeanPlayer.hpp"
+#include "MediaRuntime.hpp"
+#include "openslsink.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const int ITERATIONS = 100;
+
+static size_t silence(unique_ptr<uint8_t[]> &buffer, void *cookie)
+{
+	buffer.reset(new uint8_t[1024]());
+	return 1024;
+}
+
+TEST_CASE("PlayerCreateBench")
+{
+	int64_t start = nowUs();
+
+	for (int i = 0; i < ITERATIONS; ++i) {
+		unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+		REQUIRE(player->setDataSource("/data/local/tmp/video.mp4") == 0);
+		REQUIRE(player->prepare() == 0);
+		player->stop();
+	}
+
+	int64_t playersUs = nowUs() - start;
+
+	start = nowUs();
+
+	for (int i = 0; i < ITERATIONS; ++i) {
+		OpenslSink sink;
+		REQUIRE(sink.open(44100, 2, PCM_FORMAT_FIXED_16, silence, nullptr) == 0);
+		sink.stop();
+	}
+
+	int64_t sinksUs = nowUs() - start;
+
+	start = nowUs();
+
+	for (int i = 0; i < ITERATIONS; ++i) {
+		SLObjectItf engine = NULL;
+		REQUIRE(slCreateEngine(&engine, 0, NULL, 0, NULL, NULL) == SL_RESULT_SUCCESS);
+		REQUIRE((*engine)->Realize(engine, SL_BOOLEAN_FALSE) == SL_RESULT_SUCCESS);
+		(*engine)->Destroy(engine);
+	}
+
+	int64_t enginesUs = nowUs() - start;
+
+	MediaRuntime::Stats stats = MediaRuntime::instance().getStats();
+
+	printf("runtime init: ffmpeg %lld us, opensl %lld us (once per process)\n",
+		   (long long)stats.ffmpegInitUs, (long long)stats.openslInitUs);
+	printf("player create/prepare/teardown: %lld us each\n", (long long)(playersUs / ITERATIONS));
+	printf("audio sink open/stop, shared engine: %lld us each\n", (long long)(sinksUs / ITERATIONS));
+	printf("engine create/destroy, per sink before: %lld us each\n", (long long)(enginesUs / ITERATIONS));
+}
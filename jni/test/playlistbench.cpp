@@ -0,0 +1,163 @@
+/*
+ * playlistbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Plays a playlist of the same file a few times, seeking close to the end
+ * of each item, and prints for each transition how long the next item took
+ * to preload and how long the audio sink waited across the splice. Then
+ * loops a single data source the same way, and goes from video to an
+ * audio only item and back.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WhiteBeanPlayer.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const char *AUDIO_PATH = "/data/local/tmp/audio.m4a";
+static const int ITEMS = 4;
+// played of each item, the next one is preloaded meanwhile
+static const int64_t TAIL_MS = 2000;
+
+class PlaylistListener: public MediaPlayerListener {
+public:
+	PlaylistListener(): mStarted(0), mCompleted(0), mSeeks(0) {}
+
+	virtual void notify(int msg, int ext1, int ext2) {
+		unique_lock<mutex> autoLock(mLock);
+
+		if (msg == WhiteBeanPlayer::MEDIA_INFO && ext1 == WhiteBeanPlayer::MEDIA_INFO_STARTED_AS_NEXT) {
+			mStarted++;
+		} else if (msg == WhiteBeanPlayer::MEDIA_PLAYBACK_COMPLETE) {
+			mCompleted++;
+		} else if (msg == WhiteBeanPlayer::MEDIA_SEEK_COMPLETE) {
+			mSeeks++;
+		}
+		mCond.notify_all();
+	}
+
+	bool waitFor(int &counter, int count, int64_t timeoutMs) {
+		unique_lock<mutex> autoLock(mLock);
+		return mCond.wait_for(autoLock, chrono::milliseconds(timeoutMs),
+							  [&] { return counter >= count; });
+	}
+
+	int mStarted;
+	int mCompleted;
+	int mSeeks;
+
+private:
+	mutex mLock;
+	condition_variable mCond;
+};
+
+// seek close to the end of the current item and wait for the next one
+static void playTail(WhiteBeanPlayer &player, PlaylistListener &listener, int seeks)
+{
+	int64_t durationMs = player.getDuration();
+	REQUIRE(durationMs > TAIL_MS);
+
+	REQUIRE(player.seekTo(durationMs - TAIL_MS) == 0);
+	REQUIRE(listener.waitFor(listener.mSeeks, seeks, 10000));
+}
+
+TEST_CASE("PlaylistBench")
+{
+	shared_ptr<MediaPlayerListener> listener(new PlaylistListener);
+	PlaylistListener &events = *static_cast<PlaylistListener *>(listener.get());
+
+	SECTION("Playlist") {
+		unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+		player->setListener(listener);
+		REQUIRE(player->setPlaylist(vector<string>(ITEMS, MEDIA_PATH)) == 0);
+		REQUIRE(player->prepare() == 0);
+		REQUIRE(player->play() == 0);
+
+		printf("item | preload ms | audio gap ms | max audio gap ms\n");
+
+		for (int i = 1; i < ITEMS; ++i) {
+			playTail(*player, events, i);
+			REQUIRE(events.waitFor(events.mStarted, i, TAIL_MS + 5000));
+
+			WhiteBeanPlayer::PlaylistStats stats = player->getPlaylistStats();
+			CHECK(stats.index == i);
+			CHECK(stats.transitions == i);
+
+			printf("%4d | %10.1f | %12.1f | %.1f\n", i, stats.lastPreloadUs / 1000.0,
+				   stats.lastAudioGapUs / 1000.0, stats.maxAudioGapUs / 1000.0);
+		}
+
+		// nothing follows the last one
+		playTail(*player, events, ITEMS);
+		REQUIRE(events.waitFor(events.mCompleted, 1, TAIL_MS + 5000));
+		CHECK_FALSE(player->isPlaying());
+		CHECK(player->getPlaylistStats().transitions == ITEMS - 1);
+
+		player->stop();
+	}
+
+	SECTION("Looping") {
+		unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+		player->setListener(listener);
+		REQUIRE(player->setDataSource(MEDIA_PATH) == 0);
+		player->setLooping(true);
+		REQUIRE(player->prepare() == 0);
+		REQUIRE(player->play() == 0);
+
+		for (int i = 1; i < ITEMS; ++i) {
+			playTail(*player, events, i);
+			REQUIRE(events.waitFor(events.mStarted, i, TAIL_MS + 5000));
+			CHECK(player->getPlaylistIndex() == 0);
+		}
+
+		WhiteBeanPlayer::PlaylistStats stats = player->getPlaylistStats();
+		CHECK(events.mCompleted == 0);
+		printf("looping: %d loops, last audio gap %.1f ms, max %.1f ms\n", stats.transitions,
+			   stats.lastAudioGapUs / 1000.0, stats.maxAudioGapUs / 1000.0);
+
+		player->stop();
+	}
+
+	SECTION("Audio only item") {
+		unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+		player->setListener(listener);
+		REQUIRE(player->setPlaylist({MEDIA_PATH, AUDIO_PATH, MEDIA_PATH}) == 0);
+		REQUIRE(player->prepare() == 0);
+		REQUIRE(player->play() == 0);
+
+		// video to audio only, nothing is left to show
+		playTail(*player, events, 1);
+		REQUIRE(events.waitFor(events.mStarted, 1, TAIL_MS + 5000));
+		CHECK(player->getPlaylistIndex() == 1);
+
+		int positionMs = player->getCurrentPosition();
+		this_thread::sleep_for(chrono::milliseconds(500));
+		CHECK(player->isPlaying());
+		CHECK(player->getCurrentPosition() > positionMs);
+
+		// and back, the video events start again
+		playTail(*player, events, 2);
+		REQUIRE(events.waitFor(events.mStarted, 2, TAIL_MS + 5000));
+		positionMs = player->getCurrentPosition();
+		this_thread::sleep_for(chrono::milliseconds(500));
+		CHECK(player->isPlaying());
+		CHECK(player->getCurrentPosition() > positionMs);
+
+		playTail(*player, events, 3);
+		REQUIRE(events.waitFor(events.mCompleted, 1, TAIL_MS + 5000));
+		CHECK(player->getPlaylistStats().transitions == 2);
+
+		player->stop();
+	}
+}
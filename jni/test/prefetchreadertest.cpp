@@ -0,0 +1,194 @@
+/*
+ * prefetchreadertest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Runs PrefetchReader over an in-memory reader that sleeps on every read,
+ * standing in for slow storage or network. Reads of prefetched bytes and
+ * seeks must not wait for it, and the bytes must come out unchanged.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "mediabase/PrefetchReader.hpp"
+#include "mediabase/Clock.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const size_t SIZE = 2 * 1024 * 1024 + 77;
+static const size_t CAPACITY = 512 * 1024;
+static const size_t CHUNK = 64 * 1024;
+static const int DELAY_MS = 20;
+
+class SlowReader: public ByteReader {
+public:
+	explicit SlowReader(const vector<uint8_t> &data): mData(data), mPos(0), mReads(0) {}
+
+	virtual int read(uint8_t *buf, int size) override {
+		this_thread::sleep_for(chrono::milliseconds(DELAY_MS));
+		mReads++;
+
+		int64_t len = min<int64_t>(size, (int64_t)mData.size() - mPos);
+		if (len <= 0) {
+			return 0;
+		}
+
+		memcpy(buf, mData.data() + mPos, len);
+		mPos += len;
+
+		return len;
+	}
+
+	virtual int64_t seek(int64_t pos) override {
+		mPos = pos;
+		return pos;
+	}
+
+	virtual int64_t tell() const override {
+		return mPos;
+	}
+
+	virtual int64_t size() const override {
+		return mData.size();
+	}
+
+	const vector<uint8_t> &mData;
+	int64_t mPos;
+	atomic<int> mReads;
+};
+
+// reads may return less than asked at the edge of the window
+static int readFully(PrefetchReader &reader, uint8_t *buf, int size)
+{
+	int total = 0;
+
+	while (total < size) {
+		int n = reader.read(buf + total, size - total);
+		if (n <= 0) {
+			break;
+		}
+		total += n;
+	}
+
+	return total;
+}
+
+static vector<uint8_t> makeData()
+{
+	vector<uint8_t> data(SIZE);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = (uint8_t)(i * 13 + (i >> 9));
+	}
+
+	return data;
+}
+
+TEST_CASE("PrefetchReader")
+{
+	vector<uint8_t> data = makeData();
+	shared_ptr<SlowReader> slow(new SlowReader(data));
+	PrefetchReader reader(slow, CAPACITY, CHUNK);
+
+	REQUIRE(reader.start() == 0);
+	REQUIRE(reader.size() == (int64_t)SIZE);
+
+	SECTION("Sequential") {
+		vector<uint8_t> out, buf(10000);
+		int n;
+
+		while ((n = reader.read(buf.data(), buf.size())) > 0) {
+			out.insert(out.end(), buf.begin(), buf.begin() + n);
+		}
+
+		CHECK(n == 0);
+		CHECK(out == data);
+
+		PrefetchReader::Stats stats = reader.getStats();
+		CHECK(stats.fetchedBytes == (int64_t)SIZE);
+		CHECK(stats.throughput > 0);
+		CHECK(stats.bufferedBytes == 0);
+	}
+
+	SECTION("Random") {
+		srand(2);
+
+		for (int i = 0; i < 100; ++i) {
+			int64_t pos = rand() % SIZE;
+			vector<uint8_t> buf(1 + rand() % 50000);
+
+			REQUIRE(reader.seek(pos) == pos);
+			int n = reader.read(buf.data(), buf.size());
+
+			REQUIRE(n > 0);
+			CHECK(reader.tell() == pos + n);
+			CHECK(equal(buf.begin(), buf.begin() + n, data.begin() + pos));
+		}
+	}
+
+	SECTION("ReadsFromCache") {
+		// let the worker fill the window
+		this_thread::sleep_for(chrono::milliseconds(DELAY_MS * (CAPACITY / CHUNK + 4)));
+
+		PrefetchReader::Stats stats = reader.getStats();
+		CHECK(stats.bufferedBytes == (int64_t)CAPACITY);
+
+		vector<uint8_t> buf(CAPACITY / 2);
+		int64_t start = nowUs();
+		REQUIRE(reader.read(buf.data(), buf.size()) == (int)buf.size());
+		int64_t us = nowUs() - start;
+
+		CHECK(us < DELAY_MS * 1000);
+		CHECK(equal(buf.begin(), buf.end(), data.begin()));
+		CHECK(reader.getStats().stalls == stats.stalls);
+
+		printf("read of %d cached bytes: %lld us, upstream %lld bytes/s\n", (int)buf.size(),
+			   (long long)us, (long long)stats.throughput);
+	}
+
+	SECTION("SeekDoesNotWait") {
+		// the worker is inside a slow read now
+		this_thread::sleep_for(chrono::milliseconds(DELAY_MS / 2));
+
+		int64_t start = nowUs();
+		REQUIRE(reader.seek(SIZE / 2) == (int64_t)(SIZE / 2));
+		CHECK(nowUs() - start < DELAY_MS * 1000 / 2);
+
+		uint8_t byte;
+		REQUIRE(reader.read(&byte, 1) == 1);
+		CHECK(byte == data[SIZE / 2]);
+	}
+
+	SECTION("BackwardSeekInWindow") {
+		vector<uint8_t> buf(CAPACITY / 4);
+		REQUIRE(reader.seek(CAPACITY) == (int64_t)CAPACITY);
+		REQUIRE(readFully(reader, buf.data(), buf.size()) == (int)buf.size());
+
+		int reads = slow->mReads;
+		REQUIRE(reader.seek(CAPACITY + 100) == (int64_t)(CAPACITY + 100));
+		REQUIRE(reader.seek(CAPACITY) == (int64_t)CAPACITY);
+
+		int64_t start = nowUs();
+		REQUIRE(readFully(reader, buf.data(), buf.size()) == (int)buf.size());
+		CHECK(nowUs() - start < DELAY_MS * 1000);
+		CHECK(equal(buf.begin(), buf.end(), data.begin() + CAPACITY));
+		CHECK(slow->mReads - reads <= 2);
+	}
+
+	SECTION("Stopped") {
+		// nothing is fetched any more, reads outside the window fail
+		reader.stop();
+
+		uint8_t byte;
+		REQUIRE(reader.seek(SIZE - 1) == (int64_t)(SIZE - 1));
+		CHECK(reader.read(&byte, 1) < 0);
+	}
+
+	reader.stop();
+}
@@ -0,0 +1,48 @@
+/*
+ * preparebench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Prepares the same file a few times and prints where prepare spent its
+ * time. Audio is prepared next to the video decoder, so the total should
+ * stay below the sum of the phases. There is no surface here, the first
+ * frame is only presented by a player with a window.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <memory>
+#include "WhiteBeanPlayer.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const int ITERATIONS = 10;
+
+TEST_CASE("PrepareBench")
+{
+	WhiteBeanPlayer::PrepareStats sum = {0, 0, 0, 0, 0};
+
+	for (int i = 0; i < ITERATIONS; ++i) {
+		unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+		REQUIRE(player->setDataSource("/data/local/tmp/video.mp4") == 0);
+		REQUIRE(player->prepare() == 0);
+
+		WhiteBeanPlayer::PrepareStats stats = player->getPrepareStats();
+		CHECK(stats.totalUs > 0);
+		CHECK(stats.totalUs >= stats.openUs + stats.videoDecoderUs);
+
+		sum.openUs += stats.openUs;
+		sum.videoDecoderUs += stats.videoDecoderUs;
+		sum.audioUs += stats.audioUs;
+		sum.totalUs += stats.totalUs;
+
+		player->stop();
+	}
+
+	printf("prepare: open %lld us, video decoder %lld us, audio %lld us, total %lld us\n",
+		   (long long)(sum.openUs / ITERATIONS), (long long)(sum.videoDecoderUs / ITERATIONS),
+		   (long long)(sum.audioUs / ITERATIONS), (long long)(sum.totalUs / ITERATIONS));
+	printf("sequential would be %lld us\n",
+		   (long long)((sum.openUs + sum.videoDecoderUs + sum.audioUs) / ITERATIONS));
+}
@@ -0,0 +1,119 @@
+/*
+ * seekbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Seeks around MPEG-TS and Matroska (no cues) samples with a cold keyframe
+ * index, plays each file through once to build it, then seeks again with
+ * the index loaded on open. Prints the time from the seek to the first
+ * packet of the seek stream.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include "MediaSource.hpp"
+#include "StreamInfoCache.hpp"
+#include "MediaRuntime.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *CACHE_DIR = "/data/local/tmp";
+static const int SEEKS = 20;
+
+// demux the whole file through the source, as playback does
+static void playThrough(const char *uri)
+{
+	MediaSource source;
+	REQUIRE(source.open(uri) == 0);
+	source.start();
+
+	shared_ptr<MediaTracks> tracks = source.getTracksPtr();
+	PacketBuffer pkt;
+	auto deadline = chrono::steady_clock::now() + chrono::minutes(5);
+
+	while (chrono::steady_clock::now() < deadline) {
+		bool got = tracks->readVideo(pkt);
+		got = tracks->readAudio(pkt) || got;
+
+		if (!got) {
+			if (source.eof()) {
+				break;
+			}
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+
+	// stores the index
+	source.stop();
+}
+
+static void seekAround(const char *name, const char *uri)
+{
+	MediaSource source;
+	REQUIRE(source.open(uri) == 0);
+
+	AVFormatContext *ctx = source.getFmtCtxPtr().get();
+	int stream = source.hasVideo() ? source.getVideoStreamId() : source.getAudioStreamId();
+	int64_t durationMs = ctx->duration / 1000;
+	int64_t totalUs = 0, maxUs = 0;
+
+	REQUIRE(durationMs > 0);
+
+	for (int i = 0; i < SEEKS; ++i) {
+		// spread over the file, not in order
+		int64_t msec = durationMs * ((i * 7) % SEEKS) / SEEKS;
+		AVPacket pkt;
+		av_init_packet(&pkt);
+
+		int64_t start = nowUs();
+		REQUIRE(source.seekTo_l(msec) == 0);
+
+		while (av_read_frame(ctx, &pkt) >= 0) {
+			bool done = pkt.stream_index == stream;
+			av_packet_unref(&pkt);
+			if (done) {
+				break;
+			}
+		}
+
+		int64_t us = nowUs() - start;
+		totalUs += us;
+		maxUs = max(maxUs, us);
+	}
+
+	printf("%-10s avg %lld us, max %lld us, %d of %d seeks by index\n", name,
+		   (long long)(totalUs / SEEKS), (long long)maxUs, source.getIndexedSeekCount(), SEEKS);
+
+	source.stop();
+}
+
+TEST_CASE("SeekBench")
+{
+	const char *samples[] = {
+		"/data/local/tmp/video.ts",
+		"/data/local/tmp/video.mkv",
+	};
+
+	MediaRuntime::instance().initFFmpeg();
+	StreamInfoCache::instance().setDirectory(CACHE_DIR);
+
+	for (const char *uri : samples) {
+		if (access(uri, R_OK) != 0) {
+			printf("%s missing, skipped\n", uri);
+			continue;
+		}
+
+		printf("%s\n", uri);
+
+		StreamInfoCache::instance().remove(uri);
+		seekAround("cold", uri);
+
+		playThrough(uri);
+		seekAround("warm", uri);
+	}
+}
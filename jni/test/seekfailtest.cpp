@@ -0,0 +1,175 @@
+/*
+ * seekfailtest.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Demuxes through a reader that refuses to seek once told to, so the
+ * source cannot move. The seek still has to complete, with a failure, and
+ * leave the source and the decoders ready for the next seek. A transport
+ * stream is used since its seeks go to the reader, an mp4 one only moves
+ * the sample index.
+ */
+
+#include <catch.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "FileReader.hpp"
+#include "MediaSource.hpp"
+#include "MediaCodec.hpp"
+#include "MediaRuntime.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.ts";
+
+class FailingSeekReader: public ByteReader {
+public:
+	explicit FailingSeekReader(shared_ptr<ByteReader> upstream)
+		: mUpstream(upstream), mFail(false) {}
+
+	void setFail(bool fail) {
+		mFail = fail;
+	}
+
+	virtual int read(uint8_t *buf, int size) override {
+		return mUpstream->read(buf, size);
+	}
+
+	virtual int64_t seek(int64_t pos) override {
+		if (mFail) {
+			return -1;
+		}
+		return mUpstream->seek(pos);
+	}
+
+	virtual int64_t tell() const override {
+		return mUpstream->tell();
+	}
+
+	virtual int64_t size() const override {
+		return mUpstream->size();
+	}
+
+private:
+	shared_ptr<ByteReader> mUpstream;
+	atomic<bool> mFail;
+};
+
+class SeekWaiter: public IMediaListener {
+public:
+	SeekWaiter(): mDone(false), mStatus(0) {}
+
+	virtual int mediaNotify(int msg, int arg1, int arg2) override {
+		if (msg == SOURCE_SEEK_COMPLETE) {
+			unique_lock<mutex> autoLock(mLock);
+			mDone = true;
+			mStatus = arg1;
+			mCond.notify_all();
+		}
+		return 0;
+	}
+
+	// the status of the seek, or 1 if it never completed
+	int wait() {
+		unique_lock<mutex> autoLock(mLock);
+		bool done = mCond.wait_for(autoLock, chrono::seconds(5), [&] { return mDone; });
+		mDone = false;
+		return done ? mStatus : 1;
+	}
+
+private:
+	mutex mLock;
+	condition_variable mCond;
+	bool mDone;
+	int mStatus;
+};
+
+// the handshake WhiteBeanPlayer runs for a seek
+static int seek(shared_ptr<MediaSource> &source, SeekWaiter &waiter,
+				MediaDecoder &audioDecoder, MediaDecoder &videoDecoder, int64_t msec)
+{
+	source->seekTo(msec);
+	videoDecoder.seekTo(msec);
+	audioDecoder.seekTo(msec);
+
+	int status = waiter.wait();
+
+	audioDecoder.resume();
+	videoDecoder.resume();
+
+	return status;
+}
+
+static bool readVideoFrame(MediaDecoder &audioDecoder, MediaDecoder &videoDecoder)
+{
+	auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+	FrameBuffer frmbuf;
+
+	while (chrono::steady_clock::now() < deadline) {
+		// keep audio flowing, the source stops demuxing on a full queue
+		while (audioDecoder.read(frmbuf)) {
+		}
+
+		if (videoDecoder.read(frmbuf)) {
+			return true;
+		}
+
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+
+	return false;
+}
+
+TEST_CASE("SeekFail")
+{
+	MediaRuntime::instance().initFFmpeg();
+
+	shared_ptr<FileReader> file(new FileReader);
+	REQUIRE(file->open(MEDIA_PATH) == 0);
+	shared_ptr<FailingSeekReader> reader(new FailingSeekReader(file));
+
+	shared_ptr<MediaSource> source(new MediaSource);
+	source->setByteReader(reader);
+	source->setPrefetchSize(0);
+	REQUIRE(source->open(MEDIA_PATH) == 0);
+	REQUIRE(source->hasAudio());
+	REQUIRE(source->hasVideo());
+
+	SeekWaiter waiter;
+	source->setListener(&waiter);
+
+	MediaDecoder audioDecoder, videoDecoder;
+	REQUIRE(audioDecoder.open(source, source->getAudioStreamId()) == 0);
+	REQUIRE(videoDecoder.open(source, source->getVideoStreamId()) == 0);
+	audioDecoder.setListener(source.get());
+	videoDecoder.setListener(source.get());
+
+	source->start();
+	audioDecoder.start();
+	videoDecoder.start();
+
+	int64_t durationMs = source->getFmtCtxPtr()->duration / 1000;
+	REQUIRE(durationMs > 0);
+	REQUIRE(readVideoFrame(audioDecoder, videoDecoder));
+
+	// completes, reporting the failure, and playback goes on
+	reader->setFail(true);
+	CHECK(seek(source, waiter, audioDecoder, videoDecoder, durationMs / 2) < 0);
+	CHECK(readVideoFrame(audioDecoder, videoDecoder));
+
+	// the next one is not held up by it
+	CHECK(seek(source, waiter, audioDecoder, videoDecoder, durationMs / 4) < 0);
+
+	reader->setFail(false);
+	CHECK(seek(source, waiter, audioDecoder, videoDecoder, durationMs / 2) == 0);
+	CHECK(readVideoFrame(audioDecoder, videoDecoder));
+
+	source->stop();
+	audioDecoder.stop();
+	videoDecoder.stop();
+}
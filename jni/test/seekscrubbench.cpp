@@ -0,0 +1,98 @@
+/*
+ * seekscrubbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Drags through the file as a seek bar does, one preview seek every 16 ms,
+ * then releases on the last position. Prints how many of the requests were
+ * actually run and how long the release took to complete, once with the
+ * drag sent as previews and once as plain seeks.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "WhiteBeanPlayer.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const int DRAG_STEPS = 60;
+static const int DRAG_INTERVAL_MS = 16;
+
+class SeekListener: public MediaPlayerListener {
+public:
+	SeekListener(): mCompleted(0) {}
+
+	virtual void notify(int msg, int ext1, int ext2) {
+		if (msg == WhiteBeanPlayer::MEDIA_SEEK_COMPLETE) {
+			unique_lock<mutex> autoLock(mLock);
+			mCompleted++;
+			mCond.notify_all();
+		}
+	}
+
+	bool waitFor(int completed, chrono::milliseconds timeout) {
+		unique_lock<mutex> autoLock(mLock);
+		return mCond.wait_for(autoLock, timeout, [&] { return mCompleted >= completed; });
+	}
+
+	int completed() {
+		unique_lock<mutex> autoLock(mLock);
+		return mCompleted;
+	}
+
+private:
+	mutex mLock;
+	condition_variable mCond;
+	int mCompleted;
+};
+
+static void drag(bool preview)
+{
+	shared_ptr<MediaPlayerListener> listener(new SeekListener);
+	SeekListener *seekListener = static_cast<SeekListener *>(listener.get());
+
+	unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+	player->setListener(listener);
+	REQUIRE(player->setDataSource(MEDIA_PATH) == 0);
+	REQUIRE(player->prepare() == 0);
+
+	int64_t durationMs = player->getDuration();
+	REQUIRE(durationMs > 0);
+
+	for (int i = 0; i < DRAG_STEPS; ++i) {
+		player->seekTo(durationMs * i / (DRAG_STEPS * 2), preview);
+		this_thread::sleep_for(chrono::milliseconds(DRAG_INTERVAL_MS));
+	}
+
+	int before = seekListener->completed();
+	auto release = chrono::steady_clock::now();
+	REQUIRE(player->seekTo(durationMs / 2) == 0);
+	REQUIRE(seekListener->waitFor(before + 1, chrono::seconds(10)));
+	int64_t releaseUs = chrono::duration_cast<chrono::microseconds>(
+		chrono::steady_clock::now() - release).count();
+
+	WhiteBeanPlayer::SeekStats stats = player->getSeekStats();
+
+	printf("%s drag: %d requested, %d executed, %d coalesced, release completed in %lld us\n",
+		   preview ? "preview" : "plain", stats.requested, stats.executed, stats.coalesced,
+		   (long long)releaseUs);
+
+	CHECK(stats.requested == DRAG_STEPS + 1);
+	CHECK(stats.coalesced > 0);
+	CHECK(stats.executed < stats.requested);
+
+	player->stop();
+}
+
+TEST_CASE("SeekScrubBench")
+{
+	drag(true);
+	drag(false);
+}
@@ -0,0 +1,119 @@
+/*
+ * streamopenbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Opens the same file with the FFmpeg probe defaults, with the bounded
+ * limits, and from the stream info cache, and prints the average open time
+ * of each. A cached open must describe the streams as a probed one does
+ * and the decoders must open on it.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include "MediaSource.hpp"
+#include "StreamInfoCache.hpp"
+#include "MediaCodec.hpp"
+#include "MediaRuntime.hpp"
+#include "Clock.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const char *CACHE_DIR = "/data/local/tmp";
+static const int ITERATIONS = 20;
+
+static int64_t openUs(int64_t probeSize, int64_t analyzeDurationUs)
+{
+	int64_t total = 0;
+
+	for (int i = 0; i < ITERATIONS; ++i) {
+		MediaSource source;
+		source.setProbeLimits(probeSize, analyzeDurationUs);
+
+		int64_t start = nowUs();
+		REQUIRE(source.open(MEDIA_PATH) == 0);
+		total += nowUs() - start;
+
+		source.stop();
+	}
+
+	return total / ITERATIONS;
+}
+
+TEST_CASE("StreamInfoCacheMatchesProbe")
+{
+	MediaRuntime::instance().initFFmpeg();
+	StreamInfoCache &cache = StreamInfoCache::instance();
+
+	cache.setDirectory(CACHE_DIR);
+	cache.remove(MEDIA_PATH);
+
+	MediaSource probed;
+	REQUIRE(probed.open(MEDIA_PATH) == 0);
+	StreamInfoCache::Stats stats = cache.getStats();
+
+	shared_ptr<MediaSource> cached(new MediaSource);
+	REQUIRE(cached->open(MEDIA_PATH) == 0);
+	CHECK(cache.getStats().hits == stats.hits + 1);
+
+	// the same entry, whichever way the file is named
+	MediaSource named;
+	REQUIRE(named.open(string("file://") + MEDIA_PATH) == 0);
+	CHECK(cache.getStats().hits == stats.hits + 2);
+	named.stop();
+
+	REQUIRE(cached->getVideoStreamId() == probed.getVideoStreamId());
+	REQUIRE(cached->getAudioStreamId() == probed.getAudioStreamId());
+
+	AVFormatContext *a = probed.getFmtCtxPtr().get();
+	AVFormatContext *b = cached->getFmtCtxPtr().get();
+	REQUIRE(a->nb_streams == b->nb_streams);
+
+	for (unsigned int i = 0; i < a->nb_streams; ++i) {
+		AVCodecContext *ca = a->streams[i]->codec;
+		AVCodecContext *cb = b->streams[i]->codec;
+
+		CHECK(ca->codec_id == cb->codec_id);
+		CHECK(ca->width == cb->width);
+		CHECK(ca->height == cb->height);
+		CHECK(ca->pix_fmt == cb->pix_fmt);
+		CHECK(ca->sample_rate == cb->sample_rate);
+		CHECK(ca->channels == cb->channels);
+		REQUIRE(ca->extradata_size == cb->extradata_size);
+		CHECK(memcmp(ca->extradata, cb->extradata, ca->extradata_size) == 0);
+	}
+
+	CHECK(a->duration == b->duration);
+
+	// the decoders open on what came from the cache
+	MediaDecoder videoDecoder, audioDecoder;
+	CHECK(videoDecoder.open(cached, cached->getVideoStreamId()) == 0);
+	CHECK(audioDecoder.open(cached, cached->getAudioStreamId()) == 0);
+
+	probed.stop();
+	cached->stop();
+}
+
+TEST_CASE("StreamOpenBench")
+{
+	MediaRuntime::instance().initFFmpeg();
+	StreamInfoCache &cache = StreamInfoCache::instance();
+
+	cache.setDirectory("");
+	int64_t defaultUs = openUs(0, 0);
+	int64_t boundedUs = openUs(MediaSource::DEFAULT_PROBE_SIZE, MediaSource::DEFAULT_ANALYZE_DURATION_US);
+
+	cache.setDirectory(CACHE_DIR);
+	cache.remove(MEDIA_PATH);
+	int64_t warmUs = openUs(MediaSource::DEFAULT_PROBE_SIZE, MediaSource::DEFAULT_ANALYZE_DURATION_US);
+
+	printf("open: ffmpeg defaults %lld us, bounded probe %lld us, cached %lld us\n",
+		   (long long)defaultUs, (long long)boundedUs, (long long)warmUs);
+
+	CHECK(warmUs < defaultUs);
+}
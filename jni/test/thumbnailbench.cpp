@@ -0,0 +1,114 @@
+/*
+ * thumbnailbench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Extracts a seek bar strip of thumbnails from the file with 1 worker up
+ * to one per core and prints thumbnails per second for each, then runs the
+ * strip again against the disk cache.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "ThumbnailEngine.hpp"
+#include "MediaSource.hpp"
+#include "MediaRuntime.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const char *CACHE_DIR = "/data/local/tmp/thumbcache";
+static const int THUMBNAILS = 100;
+static const int WIDTH = 160;
+static const int HEIGHT = 90;
+
+// the whole strip queued at once, as a seek bar asks for it
+static double runStrip(ThumbnailEngine &engine, int64_t durationUs, int &failed)
+{
+	mutex lock;
+	condition_variable cond;
+	int done = 0;
+	failed = 0;
+
+	auto start = chrono::steady_clock::now();
+
+	for (int i = 0; i < THUMBNAILS; ++i) {
+		int64_t timeUs = durationUs * i / THUMBNAILS;
+		REQUIRE(engine.request(MEDIA_PATH, timeUs, WIDTH, HEIGHT,
+							   [&](int status, const ThumbnailEngine::Thumbnail &thumb) {
+			unique_lock<mutex> autoLock(lock);
+			if (status < 0 || thumb.width > WIDTH || thumb.height > HEIGHT
+				|| (int)thumb.pixels.size() != thumb.width * thumb.height * 2) {
+				failed++;
+			}
+			done++;
+			cond.notify_all();
+		}) == 0);
+	}
+
+	unique_lock<mutex> autoLock(lock);
+	cond.wait(autoLock, [&] { return done == THUMBNAILS; });
+
+	double seconds = chrono::duration_cast<chrono::microseconds>(
+		chrono::steady_clock::now() - start).count() / 1000000.0;
+
+	return THUMBNAILS / seconds;
+}
+
+TEST_CASE("ThumbnailBench")
+{
+	MediaRuntime::instance().initFFmpeg();
+
+	int64_t durationUs;
+	{
+		MediaSource source;
+		REQUIRE(source.open(MEDIA_PATH) == 0);
+		durationUs = source.getFmtCtxPtr()->duration;
+	}
+	REQUIRE(durationUs > 0);
+
+	int cores = max(1, (int)thread::hardware_concurrency());
+	double single = 0;
+
+	printf("workers | thumbnails/s | speedup | opens | decode ms/thumbnail\n");
+
+	for (int threads = 1; threads <= cores; ++threads) {
+		ThumbnailEngine engine(threads);
+		int failed;
+		double rate = runStrip(engine, durationUs, failed);
+		CHECK(failed == 0);
+
+		if (threads == 1) {
+			single = rate;
+		}
+
+		ThumbnailEngine::Stats stats = engine.getStats();
+		CHECK(stats.decoded == THUMBNAILS);
+		CHECK(stats.opens <= threads);
+
+		printf("%7d | %12.1f | %7.2f | %5d | %.2f\n", threads, rate, rate / single, stats.opens,
+			   stats.decodeUs / 1000.0 / THUMBNAILS);
+	}
+
+	system((string("rm -rf ") + CACHE_DIR + " && mkdir -p " + CACHE_DIR).c_str());
+
+	ThumbnailEngine engine(cores);
+	engine.setDirectory(CACHE_DIR);
+
+	int failed;
+	double cold = runStrip(engine, durationUs, failed);
+	CHECK(failed == 0);
+	double warm = runStrip(engine, durationUs, failed);
+	CHECK(failed == 0);
+
+	ThumbnailEngine::Stats stats = engine.getStats();
+	CHECK(stats.cacheHits == THUMBNAILS);
+
+	printf("disk cache: %.1f thumbnails/s cold, %.1f warm\n", cold, warm);
+}
@@ -0,0 +1,124 @@
+/*
+ * trickplaybench.cpp
+ *
+ *  Created on: 2026年10月18日
+ *
+ * Fast forwards and rewinds through the file at every rate from 2x to 64x
+ * and prints the frames shown per second and the CPU time they cost. With
+ * key frames only, the CPU time should follow the shown frames and stay
+ * flat as the rate goes up.
+ */
+
+#include <catch.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sys/resource.h>
+#include "WhiteBeanPlayer.hpp"
+
+using namespace std;
+using namespace whitebean;
+
+static const char *MEDIA_PATH = "/data/local/tmp/video.mp4";
+static const int64_t RUN_MS = 3000;
+
+class SeekListener: public MediaPlayerListener {
+public:
+	SeekListener(): mCompleted(0) {}
+
+	virtual void notify(int msg, int ext1, int ext2) {
+		if (msg == WhiteBeanPlayer::MEDIA_SEEK_COMPLETE) {
+			unique_lock<mutex> autoLock(mLock);
+			mCompleted++;
+			mCond.notify_all();
+		}
+	}
+
+	bool waitFor(int completed) {
+		unique_lock<mutex> autoLock(mLock);
+		return mCond.wait_for(autoLock, chrono::seconds(10), [&] { return mCompleted >= completed; });
+	}
+
+	int completed() {
+		unique_lock<mutex> autoLock(mLock);
+		return mCompleted;
+	}
+
+private:
+	mutex mLock;
+	condition_variable mCond;
+	int mCompleted;
+};
+
+static int64_t cpuTimeUs()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+		 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+TEST_CASE("TrickPlayBench")
+{
+	shared_ptr<MediaPlayerListener> listener(new SeekListener);
+	SeekListener *seekListener = static_cast<SeekListener *>(listener.get());
+
+	unique_ptr<WhiteBeanPlayer> player(new WhiteBeanPlayer);
+	player->setListener(listener);
+	REQUIRE(player->setDataSource(MEDIA_PATH) == 0);
+	REQUIRE(player->prepare() == 0);
+	REQUIRE(player->play() == 0);
+
+	int64_t durationMs = player->getDuration();
+	REQUIRE(durationMs > 0);
+
+	CHECK(player->setPlaybackRate(3 * WhiteBeanPlayer::MAX_TRICK_RATE) < 0);
+	CHECK(player->setPlaybackRate(0) < 0);
+
+	int64_t startCpuUs = cpuTimeUs();
+	this_thread::sleep_for(chrono::milliseconds(RUN_MS));
+	printf("   1x: %.1f ms cpu per second\n", (cpuTimeUs() - startCpuUs) / 1000.0 / (RUN_MS / 1000.0));
+
+	printf(" rate | shown fps | dropped | cpu ms/s | cpu ms/frame\n");
+
+	const int rates[] = {2, 4, 8, 16, 32, 64, -2, -4, -8, -16, -32, -64};
+
+	for (int rate : rates) {
+		REQUIRE(player->setPlaybackRate(1) == 0);
+
+		// from the end of the file for rewinding
+		int before = seekListener->completed();
+		REQUIRE(player->seekTo(rate > 0 ? 0 : durationMs) == 0);
+		REQUIRE(seekListener->waitFor(before + 1));
+
+		// the rate starts from the audio clock, let it pick up the new position
+		this_thread::sleep_for(chrono::milliseconds(300));
+
+		// stay clear of the other end
+		int64_t runMs = min(RUN_MS, durationMs * 8 / 10 / abs(rate));
+
+		REQUIRE(player->setPlaybackRate(rate) == 0);
+		startCpuUs = cpuTimeUs();
+		this_thread::sleep_for(chrono::milliseconds(runMs));
+
+		int64_t cpuUs = cpuTimeUs() - startCpuUs;
+		WhiteBeanPlayer::TrickStats stats = player->getTrickStats();
+
+		REQUIRE(stats.rate == rate);
+		CHECK(stats.shownFrames > 0);
+
+		double seconds = stats.elapsedUs / 1000000.0;
+		printf("%4dx | %9.1f | %7d | %8.1f | %.2f\n", rate, stats.shownFrames / seconds,
+			   stats.droppedFrames, cpuUs / 1000.0 / (runMs / 1000.0),
+			   stats.shownFrames ? cpuUs / 1000.0 / stats.shownFrames : 0.0);
+	}
+
+	REQUIRE(player->setPlaybackRate(1) == 0);
+	player->stop();
+}
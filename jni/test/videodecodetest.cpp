@@ -75,4 +75,49 @@ TEST_CASE("VideoDecoder")
 		
 		this_thread::sleep_for(chrono::seconds(100));		
 	}
+
+	SECTION("SkipFrame")
+	{
+		MediaDecoder mediaDecoder;
+		ret = mediaDecoder.open(source, source->getVideoStreamId());
+		REQUIRE(ret == 0);
+
+		// as with the surface detached
+		mediaDecoder.setSkipFrame(AVDISCARD_NONKEY);
+		mediaDecoder.start();
+
+		int frames = 0;
+		while (frames < 5) {
+			FrameBuffer frmbuf;
+			if (mediaDecoder.read(frmbuf)) {
+				CHECK(frmbuf.getDataPtr()->key_frame);
+				++frames;
+			} else {
+				this_thread::sleep_for(chrono::milliseconds(10));
+			}
+		}
+
+		// reattached, full decoding restarts at a key frame
+		mediaDecoder.setSkipFrame(AVDISCARD_DEFAULT);
+
+		int64_t keyPts = -1;
+		for (;;) {
+			FrameBuffer frmbuf;
+			if (!mediaDecoder.read(frmbuf)) {
+				this_thread::sleep_for(chrono::milliseconds(10));
+				continue;
+			}
+
+			if (frmbuf.getDataPtr()->key_frame) {
+				keyPts = frmbuf.getPts();
+				continue;
+			}
+
+			CHECK(keyPts >= 0);
+			CHECK(frmbuf.getPts() > keyPts);
+			break;
+		}
+
+		mediaDecoder.stop();
+	}
 }